@@ -22,10 +22,14 @@
 #endif
 
 #include "coverage.h"
+#include "hash.h"
 #include "lflow-cache.h"
 #include "lib/uuid.h"
 #include "memory-trim.h"
+#include "openvswitch/list.h"
+#include "openvswitch/ofpbuf.h"
 #include "openvswitch/vlog.h"
+#include "ovn/actions.h"
 #include "ovn/expr.h"
 
 VLOG_DEFINE_THIS_MODULE(lflow_cache);
@@ -37,12 +41,18 @@ COVERAGE_DEFINE(lflow_cache_free_expr);
 COVERAGE_DEFINE(lflow_cache_free_matches);
 COVERAGE_DEFINE(lflow_cache_add);
 COVERAGE_DEFINE(lflow_cache_hit);
+COVERAGE_DEFINE(lflow_cache_hit_shared);
+COVERAGE_DEFINE(lflow_cache_share);
 COVERAGE_DEFINE(lflow_cache_miss);
 COVERAGE_DEFINE(lflow_cache_delete);
 COVERAGE_DEFINE(lflow_cache_full);
 COVERAGE_DEFINE(lflow_cache_mem_full);
 COVERAGE_DEFINE(lflow_cache_made_room);
+COVERAGE_DEFINE(lflow_cache_evict);
 COVERAGE_DEFINE(lflow_cache_trim);
+COVERAGE_DEFINE(lflow_cache_add_actions);
+COVERAGE_DEFINE(lflow_cache_hit_actions);
+COVERAGE_DEFINE(lflow_cache_free_actions);
 
 static const char *lflow_cache_type_names[LCACHE_T_MAX] = {
     [LCACHE_T_EXPR]    = "cache-expr",
@@ -51,8 +61,16 @@ static const char *lflow_cache_type_names[LCACHE_T_MAX] = {
 
 static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 1);
 
+/* Maximum number of least recently used entries considered when looking for
+ * an entry to evict. */
+#define LFLOW_CACHE_EVICT_CANDIDATES 8
+
 struct lflow_cache {
     struct hmap entries[LCACHE_T_MAX];
+    struct ovs_list lru;    /* Contains 'struct lflow_cache_entry', least
+                             * recently used first. */
+    struct hmap shared;     /* Contains 'struct lflow_cache_shared'. */
+    struct hmap actions;    /* Contains 'struct lflow_cache_actions'. */
     struct memory_trimmer *mt;
     uint32_t n_entries;
     uint32_t high_watermark;
@@ -62,25 +80,70 @@ struct lflow_cache {
     uint32_t trim_limit;
     uint32_t trim_wmark_perc;
     uint64_t trim_count;
+    uint64_t n_hits;
+    uint64_t n_misses;
+    uint64_t n_evictions;
+    uint64_t evicted_cost_us;
+    uint64_t actions_mem_usage; /* Not limited by 'max_mem_usage', the
+                                 * number of distinct actions is small. */
     bool enabled;
 };
 
 struct lflow_cache_entry {
     struct hmap_node node;
+    struct ovs_list lru_node;   /* In 'struct lflow_cache' 'lru'. */
     struct uuid lflow_uuid; /* key */
     size_t size;
+    uint64_t cost_us;           /* Time it took to build 'value'. */
+
+    /* If nonnull, 'value' points to the expr or matches owned by 'shared'
+     * instead of owning its own. */
+    struct lflow_cache_shared *shared;
+
+    struct lflow_cache_value value;
+};
+
+/* An expr or matches that doesn't depend on anything but the match and the
+ * actions of the logical flows it was built for, shared by all the cache
+ * entries of the logical flows with the same match and actions. */
+struct lflow_cache_shared {
+    struct hmap_node node;      /* In 'struct lflow_cache' 'shared'. */
+    char *match;                /* key */
+    char *actions;              /* key */
+    size_t refcnt;              /* Number of entries that use it. */
+    size_t size;
+    uint64_t cost_us;
 
     struct lflow_cache_value value;
 };
 
 static bool lflow_cache_make_room__(struct lflow_cache *lc,
-                                    enum lflow_cache_type type);
+                                    enum lflow_cache_type type,
+                                    uint64_t cost_us);
 static struct lflow_cache_value *lflow_cache_add__(
     struct lflow_cache *lc, const struct uuid *lflow_uuid,
-    enum lflow_cache_type type, uint64_t value_size);
+    enum lflow_cache_type type, uint64_t value_size, uint64_t cost_us);
+static struct lflow_cache_entry *lflow_cache_find__(
+    const struct lflow_cache *lc, const struct uuid *lflow_uuid);
+static uint32_t lflow_cache_shared_hash(const char *match,
+                                        const char *actions);
+static struct lflow_cache_shared *lflow_cache_shared_find__(
+    const struct lflow_cache *lc, const char *match, const char *actions,
+    uint32_t hash);
+static struct lflow_cache_entry *lflow_cache_add_shared__(
+    struct lflow_cache *lc, const struct uuid *lflow_uuid,
+    const char *match, const char *actions);
+static void lflow_cache_share__(struct lflow_cache *lc,
+                                struct lflow_cache_entry *lce,
+                                const char *match, const char *actions);
+static void lflow_cache_shared_unref__(struct lflow_cache *lc,
+                                       struct lflow_cache_shared *shared);
+static void lflow_cache_value_destroy__(struct lflow_cache_value *lcv);
 static void lflow_cache_delete__(struct lflow_cache *lc,
                                  struct lflow_cache_entry *lce);
 static void lflow_cache_trim__(struct lflow_cache *lc, bool force);
+static void lflow_cache_remove_actions__(struct lflow_cache *lc,
+                                         struct lflow_cache_actions *lca);
 
 struct lflow_cache *
 lflow_cache_create(void)
@@ -90,6 +153,9 @@ lflow_cache_create(void)
     for (size_t i = 0; i < LCACHE_T_MAX; i++) {
         hmap_init(&lc->entries[i]);
     }
+    ovs_list_init(&lc->lru);
+    hmap_init(&lc->shared);
+    hmap_init(&lc->actions);
     lc->mt = memory_trimmer_create();
 
     return lc;
@@ -110,6 +176,7 @@ lflow_cache_flush(struct lflow_cache *lc)
             lflow_cache_delete__(lc, lce);
         }
     }
+    lflow_cache_flush_actions(lc);
     lflow_cache_trim__(lc, true);
 }
 
@@ -124,6 +191,9 @@ lflow_cache_destroy(struct lflow_cache *lc)
     for (size_t i = 0; i < LCACHE_T_MAX; i++) {
         hmap_destroy(&lc->entries[i]);
     }
+    ovs_assert(hmap_is_empty(&lc->shared));
+    hmap_destroy(&lc->shared);
+    hmap_destroy(&lc->actions);
     memory_trimmer_destroy(lc->mt);
     free(lc);
 }
@@ -202,17 +272,34 @@ lflow_cache_get_stats(const struct lflow_cache *lc, struct ds *output)
                       lflow_cache_type_names[i],
                       hmap_count(&lc->entries[i]));
     }
+    ds_put_format(output, "%-16s: %"PRIuSIZE"\n", "cache-actions",
+                  hmap_count(&lc->actions));
     ds_put_format(output, "%-16s: %"PRIu64"\n", "trim count", lc->trim_count);
+
+    uint64_t n_lookups = lc->n_hits + lc->n_misses;
+    ds_put_format(output, "%-16s: %"PRIu64"\n", "hits", lc->n_hits);
+    ds_put_format(output, "%-16s: %"PRIu64"\n", "misses", lc->n_misses);
+    ds_put_format(output, "%-16s: %.2f\n", "hit ratio (%)",
+                  n_lookups ? 100.0 * lc->n_hits / n_lookups : 0.0);
+    ds_put_format(output, "%-16s: %"PRIu64"\n", "evictions",
+                  lc->n_evictions);
+    ds_put_format(output, "%-16s: %"PRIu64"\n", "evicted cost(us)",
+                  lc->evicted_cost_us);
     ds_put_format(output, "%-16s: %"PRIu64"\n", "Mem usage (KB)",
-                  ROUND_UP(lc->mem_usage, 1024) / 1024);
+                  ROUND_UP(lc->mem_usage + lc->actions_mem_usage, 1024)
+                  / 1024);
 }
 
+/* Adds 'expr' to the cache for 'lflow_uuid'.  If 'match' and 'actions' are
+ * nonnull, 'expr' must only depend on them and is shared with the other
+ * logical flows that have the same match and actions. */
 void
 lflow_cache_add_expr(struct lflow_cache *lc, const struct uuid *lflow_uuid,
-                     struct expr *expr, size_t expr_sz)
+                     const char *match, const char *actions,
+                     struct expr *expr, size_t expr_sz, uint64_t cost_us)
 {
     struct lflow_cache_value *lcv =
-        lflow_cache_add__(lc, lflow_uuid, LCACHE_T_EXPR, expr_sz);
+        lflow_cache_add__(lc, lflow_uuid, LCACHE_T_EXPR, expr_sz, cost_us);
 
     if (!lcv) {
         expr_destroy(expr);
@@ -220,15 +307,28 @@ lflow_cache_add_expr(struct lflow_cache *lc, const struct uuid *lflow_uuid,
     }
     COVERAGE_INC(lflow_cache_add_expr);
     lcv->expr = expr;
+
+    if (match && actions) {
+        lflow_cache_share__(lc, CONTAINER_OF(lcv, struct lflow_cache_entry,
+                                             value),
+                            match, actions);
+    }
 }
 
+/* Adds 'matches' to the cache for 'lflow_uuid'.  If 'match' and 'actions'
+ * are nonnull, 'matches' must only depend on them and, unless they use
+ * conjunction ids, which are allocated per logical flow, they are shared with
+ * the other logical flows that have the same match and actions. */
 void
 lflow_cache_add_matches(struct lflow_cache *lc, const struct uuid *lflow_uuid,
+                        const char *match, const char *actions,
                         uint32_t conj_id_ofs, uint32_t n_conjs,
-                        struct hmap *matches, size_t matches_sz)
+                        struct hmap *matches, size_t matches_sz,
+                        uint64_t cost_us)
 {
     struct lflow_cache_value *lcv =
-        lflow_cache_add__(lc, lflow_uuid, LCACHE_T_MATCHES, matches_sz);
+        lflow_cache_add__(lc, lflow_uuid, LCACHE_T_MATCHES, matches_sz,
+                          cost_us);
 
     if (!lcv) {
         expr_matches_destroy(matches);
@@ -239,15 +339,216 @@ lflow_cache_add_matches(struct lflow_cache *lc, const struct uuid *lflow_uuid,
     lcv->expr_matches = matches;
     lcv->n_conjs = n_conjs;
     lcv->conj_id_ofs = conj_id_ofs;
+
+    if (match && actions && !n_conjs) {
+        lflow_cache_share__(lc, CONTAINER_OF(lcv, struct lflow_cache_entry,
+                                             value),
+                            match, actions);
+    }
 }
 
+/* Looks up the cached value of 'lflow_uuid' and marks it as the most
+ * recently used one.  If there's none but 'match' and 'actions' are nonnull
+ * and a value was cached for another logical flow with the same match and
+ * actions, that value is added to the cache for 'lflow_uuid' too, and
+ * returned. */
 struct lflow_cache_value *
-lflow_cache_get(struct lflow_cache *lc, const struct uuid *lflow_uuid)
+lflow_cache_get(struct lflow_cache *lc, const struct uuid *lflow_uuid,
+                const char *match, const char *actions)
+{
+    if (!lflow_cache_is_enabled(lc)) {
+        return NULL;
+    }
+
+    struct lflow_cache_entry *lce = lflow_cache_find__(lc, lflow_uuid);
+    if (!lce && match && actions) {
+        lce = lflow_cache_add_shared__(lc, lflow_uuid, match, actions);
+    }
+    if (!lce) {
+        COVERAGE_INC(lflow_cache_miss);
+        lc->n_misses++;
+        return NULL;
+    }
+
+    COVERAGE_INC(lflow_cache_hit);
+    lc->n_hits++;
+    ovs_list_remove(&lce->lru_node);
+    ovs_list_push_back(&lc->lru, &lce->lru_node);
+    return &lce->value;
+}
+
+/* Returns true if lflow_cache_get() would find a value for 'lflow_uuid',
+ * 'match' and 'actions'.  Unlike lflow_cache_get(), it doesn't modify 'lc',
+ * so it may be called from multiple threads at the same time, as long as
+ * nothing modifies 'lc' meanwhile. */
+bool
+lflow_cache_contains(const struct lflow_cache *lc,
+                     const struct uuid *lflow_uuid,
+                     const char *match, const char *actions)
+{
+    if (!lflow_cache_is_enabled(lc)) {
+        return false;
+    }
+
+    return lflow_cache_find__(lc, lflow_uuid)
+           || (match && actions
+               && lflow_cache_shared_find__(
+                      lc, match, actions,
+                      lflow_cache_shared_hash(match, actions)));
+}
+
+void
+lflow_cache_delete(struct lflow_cache *lc, const struct uuid *lflow_uuid)
+{
+    if (!lflow_cache_is_enabled(lc)) {
+        return;
+    }
+
+    struct lflow_cache_entry *lce = lflow_cache_find__(lc, lflow_uuid);
+    if (lce) {
+        COVERAGE_INC(lflow_cache_delete);
+        lflow_cache_delete__(lc, lce);
+        lflow_cache_trim__(lc, false);
+        memory_trimmer_record_activity(lc->mt);
+    }
+}
+
+static uint32_t
+lflow_cache_actions_hash(const char *actions, bool ingress, uint8_t table_id)
+{
+    return hash_string(actions, hash_2words(ingress, table_id));
+}
+
+/* Looks up the actions parsed for 'actions' in logical table 'table_id' of
+ * the ingress or egress pipeline, depending on 'ingress'.  'actions' must
+ * have its template variables expanded already.  If found, takes a reference
+ * on them that the caller must release with lflow_cache_actions_unref(). */
+struct lflow_cache_actions *
+lflow_cache_get_actions(struct lflow_cache *lc, const char *actions,
+                        bool ingress, uint8_t table_id)
+{
+    if (!lflow_cache_is_enabled(lc)) {
+        return NULL;
+    }
+
+    uint32_t hash = lflow_cache_actions_hash(actions, ingress, table_id);
+    struct lflow_cache_actions *lca;
+    HMAP_FOR_EACH_WITH_HASH (lca, node, hash, &lc->actions) {
+        if (lca->ingress == ingress && lca->table_id == table_id
+            && !strcmp(lca->actions, actions)) {
+            COVERAGE_INC(lflow_cache_hit_actions);
+            lca->refcnt++;
+            lca->used = true;
+            return lca;
+        }
+    }
+    return NULL;
+}
+
+/* Adds 'ovnacts', the result of parsing 'actions', and their 'prereqs' to
+ * the cache.  Takes ownership of the data of 'ovnacts', but not of
+ * 'prereqs', which is cloned.  Returns the new cached actions, with a
+ * reference for the caller, or NULL without taking ownership of anything if
+ * the cache is disabled. */
+struct lflow_cache_actions *
+lflow_cache_add_actions(struct lflow_cache *lc, const char *actions,
+                        bool ingress, uint8_t table_id,
+                        struct ofpbuf *ovnacts, const struct expr *prereqs)
 {
     if (!lflow_cache_is_enabled(lc)) {
         return NULL;
     }
 
+    COVERAGE_INC(lflow_cache_add_actions);
+    struct lflow_cache_actions *lca = xzalloc(sizeof *lca);
+    lca->actions = xstrdup(actions);
+    lca->ingress = ingress;
+    lca->table_id = table_id;
+    lca->refcnt = 2;
+    lca->used = true;
+    lca->ovnacts_len = ovnacts->size;
+    lca->ovnacts = ofpbuf_steal_data(ovnacts);
+    lca->prereqs = prereqs ? expr_clone(CONST_CAST(struct expr *, prereqs))
+                           : NULL;
+    lca->size = sizeof *lca + strlen(actions) + 1 + lca->ovnacts_len
+                + (prereqs ? expr_size(lca->prereqs) : 0);
+    hmap_insert(&lc->actions, &lca->node,
+                lflow_cache_actions_hash(actions, ingress, table_id));
+    lc->actions_mem_usage += lca->size;
+    memory_trimmer_record_activity(lc->mt);
+    return lca;
+}
+
+/* Releases a reference to 'lca'. */
+void
+lflow_cache_actions_unref(struct lflow_cache_actions *lca)
+{
+    if (!lca) {
+        return;
+    }
+
+    ovs_assert(lca->refcnt);
+    if (--lca->refcnt) {
+        return;
+    }
+
+    COVERAGE_INC(lflow_cache_free_actions);
+    ovnacts_free(lca->ovnacts, lca->ovnacts_len);
+    free(lca->ovnacts);
+    expr_destroy(lca->prereqs);
+    free(lca->actions);
+    free(lca);
+}
+
+/* Removes the cached actions that weren't looked up since the previous call,
+ * e.g., the ones of logical flows that were deleted or whose template
+ * variables changed. */
+void
+lflow_cache_sweep_actions(struct lflow_cache *lc)
+{
+    if (!lc) {
+        return;
+    }
+
+    struct lflow_cache_actions *lca;
+    HMAP_FOR_EACH_SAFE (lca, node, &lc->actions) {
+        if (!lca->used) {
+            lflow_cache_remove_actions__(lc, lca);
+        } else {
+            lca->used = false;
+        }
+    }
+}
+
+/* Removes all the cached actions, e.g., because the DHCP options they may
+ * refer to changed. */
+void
+lflow_cache_flush_actions(struct lflow_cache *lc)
+{
+    if (!lc) {
+        return;
+    }
+
+    struct lflow_cache_actions *lca;
+    HMAP_FOR_EACH_SAFE (lca, node, &lc->actions) {
+        lflow_cache_remove_actions__(lc, lca);
+    }
+}
+
+static void
+lflow_cache_remove_actions__(struct lflow_cache *lc,
+                             struct lflow_cache_actions *lca)
+{
+    hmap_remove(&lc->actions, &lca->node);
+    ovs_assert(lc->actions_mem_usage >= lca->size);
+    lc->actions_mem_usage -= lca->size;
+    lflow_cache_actions_unref(lca);
+}
+
+static struct lflow_cache_entry *
+lflow_cache_find__(const struct lflow_cache *lc,
+                   const struct uuid *lflow_uuid)
+{
     size_t hash = uuid_hash(lflow_uuid);
 
     for (size_t i = 0; i < LCACHE_T_MAX; i++) {
@@ -255,51 +556,169 @@ lflow_cache_get(struct lflow_cache *lc, const struct uuid *lflow_uuid)
 
         HMAP_FOR_EACH_WITH_HASH (lce, node, hash, &lc->entries[i]) {
             if (uuid_equals(&lce->lflow_uuid, lflow_uuid)) {
-                COVERAGE_INC(lflow_cache_hit);
-                return &lce->value;
+                return lce;
             }
         }
     }
-    COVERAGE_INC(lflow_cache_miss);
     return NULL;
 }
 
-void
-lflow_cache_delete(struct lflow_cache *lc, const struct uuid *lflow_uuid)
+static uint32_t
+lflow_cache_shared_hash(const char *match, const char *actions)
 {
-    if (!lc) {
+    return hash_string(actions, hash_string(match, 0));
+}
+
+static struct lflow_cache_shared *
+lflow_cache_shared_find__(const struct lflow_cache *lc, const char *match,
+                          const char *actions, uint32_t hash)
+{
+    struct lflow_cache_shared *shared;
+
+    HMAP_FOR_EACH_WITH_HASH (shared, node, hash, &lc->shared) {
+        if (!strcmp(shared->match, match)
+            && !strcmp(shared->actions, actions)) {
+            return shared;
+        }
+    }
+    return NULL;
+}
+
+/* Adds an entry for 'lflow_uuid' that uses the value shared by the logical
+ * flows with 'match' and 'actions', if there is one. */
+static struct lflow_cache_entry *
+lflow_cache_add_shared__(struct lflow_cache *lc,
+                         const struct uuid *lflow_uuid,
+                         const char *match, const char *actions)
+{
+    struct lflow_cache_shared *shared =
+        lflow_cache_shared_find__(lc, match, actions,
+                                  lflow_cache_shared_hash(match, actions));
+    if (!shared) {
+        return NULL;
+    }
+
+    /* Take the reference of the new entry before adding it, so that
+     * 'shared' can't be freed if its other entries are evicted to make
+     * room. */
+    shared->refcnt++;
+
+    struct lflow_cache_value *lcv =
+        lflow_cache_add__(lc, lflow_uuid, shared->value.type, 0,
+                          shared->cost_us);
+    if (!lcv) {
+        lflow_cache_shared_unref__(lc, shared);
+        return NULL;
+    }
+
+    COVERAGE_INC(lflow_cache_hit_shared);
+    struct lflow_cache_entry *lce =
+        CONTAINER_OF(lcv, struct lflow_cache_entry, value);
+    lce->shared = shared;
+    *lcv = shared->value;
+    return lce;
+}
+
+/* Makes the value of 'lce', which was just added, shared by the logical flows
+ * with 'match' and 'actions'.  If another logical flow already shares an
+ * equivalent value, 'lce' uses that one instead and its own is destroyed. */
+static void
+lflow_cache_share__(struct lflow_cache *lc, struct lflow_cache_entry *lce,
+                    const char *match, const char *actions)
+{
+    uint32_t hash = lflow_cache_shared_hash(match, actions);
+    struct lflow_cache_shared *shared =
+        lflow_cache_shared_find__(lc, match, actions, hash);
+    size_t value_size = lce->size - sizeof *lce;
+
+    if (shared && shared->value.type == lce->value.type) {
+        lflow_cache_value_destroy__(&lce->value);
+        lce->value = shared->value;
+        lc->mem_usage -= value_size;
+    } else if (!shared) {
+        COVERAGE_INC(lflow_cache_share);
+        shared = xzalloc(sizeof *shared);
+        shared->match = xstrdup(match);
+        shared->actions = xstrdup(actions);
+        shared->size = sizeof *shared + strlen(match) + strlen(actions) + 2
+                       + value_size;
+        shared->cost_us = lce->cost_us;
+        shared->value = lce->value;
+        hmap_insert(&lc->shared, &shared->node, hash);
+        lc->mem_usage += shared->size - value_size;
+    } else {
+        /* The same match and actions were cached with a different type
+         * for another logical flow, keep the value private. */
         return;
     }
 
-    struct lflow_cache_value *lcv = lflow_cache_get(lc, lflow_uuid);
-    if (lcv) {
-        COVERAGE_INC(lflow_cache_delete);
-        lflow_cache_delete__(lc, CONTAINER_OF(lcv, struct lflow_cache_entry,
-                                              value));
-        lflow_cache_trim__(lc, false);
-        memory_trimmer_record_activity(lc->mt);
+    shared->refcnt++;
+    lce->shared = shared;
+    lce->size -= value_size;
+}
+
+static void
+lflow_cache_shared_unref__(struct lflow_cache *lc,
+                           struct lflow_cache_shared *shared)
+{
+    ovs_assert(shared->refcnt);
+    if (--shared->refcnt) {
+        return;
     }
+
+    hmap_remove(&lc->shared, &shared->node);
+    lflow_cache_value_destroy__(&shared->value);
+    ovs_assert(lc->mem_usage >= shared->size);
+    lc->mem_usage -= shared->size;
+    free(shared->match);
+    free(shared->actions);
+    free(shared);
 }
 
+/* Evicts one entry to make room for a new entry of 'type' that took
+ * 'cost_us' microseconds to build.  Returns false if no entry is worth
+ * less than the new one. */
 static bool
-lflow_cache_make_room__(struct lflow_cache *lc, enum lflow_cache_type type)
+lflow_cache_make_room__(struct lflow_cache *lc, enum lflow_cache_type type,
+                        uint64_t cost_us)
 {
     /* When the cache becomes full, the rule is to prefer more "important"
      * cache entries over less "important" ones.  That is, evict entries of
      * type LCACHE_T_EXPR if there's no room to add an entry of type
-     * LCACHE_T_MATCHES.
+     * LCACHE_T_MATCHES.  Entries of the same type are only evicted if they
+     * are cheaper to rebuild than the new one.
+     *
+     * Only the least recently used entries are considered and, among them,
+     * the one that is cheapest to rebuild is evicted.  That keeps entries
+     * that are hit often, or that are expensive to rebuild (e.g., matches
+     * that refer to big address sets), in the cache.
      */
-    for (size_t i = 0; i < type; i++) {
-        if (hmap_count(&lc->entries[i]) > 0) {
-            struct lflow_cache_entry *lce =
-                CONTAINER_OF(hmap_first(&lc->entries[i]),
-                             struct lflow_cache_entry, node);
+    struct lflow_cache_entry *victim = NULL;
+    struct lflow_cache_entry *lce;
+    size_t n_candidates = 0;
 
-            lflow_cache_delete__(lc, lce);
-            return true;
+    LIST_FOR_EACH (lce, lru_node, &lc->lru) {
+        if (n_candidates++ == LFLOW_CACHE_EVICT_CANDIDATES) {
+            break;
+        }
+        if (lce->value.type > type
+            || (lce->value.type == type && lce->cost_us >= cost_us)) {
+            continue;
         }
+        if (!victim || lce->cost_us < victim->cost_us) {
+            victim = lce;
+        }
+    }
+
+    if (!victim) {
+        return false;
     }
-    return false;
+
+    COVERAGE_INC(lflow_cache_evict);
+    lc->n_evictions++;
+    lc->evicted_cost_us += victim->cost_us;
+    lflow_cache_delete__(lc, victim);
+    return true;
 }
 
 void
@@ -311,8 +730,12 @@ lflow_cache_get_memory_usage(const struct lflow_cache *lc, struct simap *usage)
         simap_increase(usage, counter_name, hmap_count(&lc->entries[i]));
         free(counter_name);
     }
+    simap_increase(usage, "lflow-cache-shared-values",
+                   hmap_count(&lc->shared));
+    simap_increase(usage, "lflow-cache-actions", hmap_count(&lc->actions));
     simap_increase(usage, "lflow-cache-size-KB",
-                   ROUND_UP(lc->mem_usage, 1024) / 1024);
+                   ROUND_UP(lc->mem_usage + lc->actions_mem_usage, 1024)
+                   / 1024);
 }
 
 void
@@ -331,7 +754,8 @@ lflow_cache_wait(struct lflow_cache *lc)
 
 static struct lflow_cache_value *
 lflow_cache_add__(struct lflow_cache *lc, const struct uuid *lflow_uuid,
-                  enum lflow_cache_type type, uint64_t value_size)
+                  enum lflow_cache_type type, uint64_t value_size,
+                  uint64_t cost_us)
 {
     if (!lflow_cache_is_enabled(lc) || !lflow_uuid) {
         return NULL;
@@ -339,13 +763,21 @@ lflow_cache_add__(struct lflow_cache *lc, const struct uuid *lflow_uuid,
 
     struct lflow_cache_entry *lce;
     size_t size = sizeof *lce + value_size;
-    if (size + lc->mem_usage > lc->max_mem_usage) {
+    if (size > lc->max_mem_usage) {
         COVERAGE_INC(lflow_cache_mem_full);
         return NULL;
     }
 
+    while (size + lc->mem_usage > lc->max_mem_usage) {
+        if (!lflow_cache_make_room__(lc, type, cost_us)) {
+            COVERAGE_INC(lflow_cache_mem_full);
+            return NULL;
+        }
+        COVERAGE_INC(lflow_cache_made_room);
+    }
+
     if (lc->n_entries == lc->capacity) {
-        if (!lflow_cache_make_room__(lc, type)) {
+        if (!lflow_cache_make_room__(lc, type, cost_us)) {
             COVERAGE_INC(lflow_cache_full);
             return NULL;
         } else {
@@ -360,8 +792,10 @@ lflow_cache_add__(struct lflow_cache *lc, const struct uuid *lflow_uuid,
     lce = xzalloc(sizeof *lce);
     lce->lflow_uuid = *lflow_uuid;
     lce->size = size;
+    lce->cost_us = cost_us;
     lce->value.type = type;
     hmap_insert(&lc->entries[type], &lce->node, uuid_hash(lflow_uuid));
+    ovs_list_push_back(&lc->lru, &lce->lru_node);
     lc->n_entries++;
     lc->high_watermark = MAX(lc->high_watermark, lc->n_entries);
     return &lce->value;
@@ -372,25 +806,36 @@ lflow_cache_delete__(struct lflow_cache *lc, struct lflow_cache_entry *lce)
 {
     ovs_assert(lc->n_entries > 0);
     hmap_remove(&lc->entries[lce->value.type], &lce->node);
+    ovs_list_remove(&lce->lru_node);
     lc->n_entries--;
-    switch (lce->value.type) {
+    if (lce->shared) {
+        lflow_cache_shared_unref__(lc, lce->shared);
+    } else {
+        lflow_cache_value_destroy__(&lce->value);
+    }
+
+    ovs_assert(lc->mem_usage >= lce->size);
+    lc->mem_usage -= lce->size;
+    free(lce);
+}
+
+static void
+lflow_cache_value_destroy__(struct lflow_cache_value *lcv)
+{
+    switch (lcv->type) {
     case LCACHE_T_NONE:
         OVS_NOT_REACHED();
         break;
     case LCACHE_T_EXPR:
         COVERAGE_INC(lflow_cache_free_expr);
-        expr_destroy(lce->value.expr);
+        expr_destroy(lcv->expr);
         break;
     case LCACHE_T_MATCHES:
         COVERAGE_INC(lflow_cache_free_matches);
-        expr_matches_destroy(lce->value.expr_matches);
-        free(lce->value.expr_matches);
+        expr_matches_destroy(lcv->expr_matches);
+        free(lcv->expr_matches);
         break;
     }
-
-    ovs_assert(lc->mem_usage >= lce->size);
-    lc->mem_usage -= lce->size;
-    free(lce);
 }
 
 static void
@@ -411,6 +856,8 @@ lflow_cache_trim__(struct lflow_cache *lc, bool force)
     for (size_t i = 0; i < LCACHE_T_MAX; i++) {
         hmap_shrink(&lc->entries[i]);
     }
+    hmap_shrink(&lc->shared);
+    hmap_shrink(&lc->actions);
 
     memory_trimmer_trim(lc->mt);
 
@@ -23,7 +23,10 @@
 #include "openvswitch/uuid.h"
 #include "simap.h"
 
+struct expr;
 struct lflow_cache;
+struct ofpbuf;
+struct ovnact;
 
 /* Various lflow cache types which
  *  - store the conjunction id offset if the lflow matches
@@ -33,6 +36,13 @@ struct lflow_cache;
  *     (1) expr tree if the logical flow doesn't have port group/address set
  *         references but has other references (such as lport).
  *     (2) expr matches if the logical flow doesn't have any references.
+ *
+ *  - Values that only depend on the match and actions of a logical flow
+ *    are shared, with a reference count, by the cache entries of all the
+ *    logical flows that have the same match and actions.
+ *
+ *  - Separately from the per logical flow entries, the parsed actions are
+ *    cached once per distinct actions string, see lflow_cache_get_actions().
  */
 enum lflow_cache_type {
     LCACHE_T_EXPR,    /* Expr tree of the logical flow is cached. */
@@ -56,6 +66,23 @@ struct lflow_cache_value {
     };
 };
 
+/* Parsed actions, once template variables are expanded, of the logical flows
+ * of one pipeline and logical table.  Owned by the lflow cache, the users
+ * must not modify them. */
+struct lflow_cache_actions {
+    struct hmap_node node;
+    char *actions;              /* key */
+    bool ingress;               /* key */
+    uint8_t table_id;           /* key */
+    size_t refcnt;              /* The cache holds one reference. */
+    bool used;                  /* Looked up since the last sweep. */
+    size_t size;
+
+    struct ovnact *ovnacts;
+    size_t ovnacts_len;
+    struct expr *prereqs;
+};
+
 struct lflow_cache *lflow_cache_create(void);
 void lflow_cache_flush(struct lflow_cache *);
 void lflow_cache_destroy(struct lflow_cache *);
@@ -65,17 +92,39 @@ void lflow_cache_enable(struct lflow_cache *, bool enabled, uint32_t capacity,
 bool lflow_cache_is_enabled(const struct lflow_cache *);
 void lflow_cache_get_stats(const struct lflow_cache *, struct ds *output);
 
+/* 'cost_us' is the time, in microseconds, it took to build the value being
+ * cached, i.e., the time it would take to rebuild it if it's evicted. */
 void lflow_cache_add_expr(struct lflow_cache *, const struct uuid *lflow_uuid,
-                          struct expr *expr, size_t expr_sz);
+                          const char *match, const char *actions,
+                          struct expr *expr, size_t expr_sz,
+                          uint64_t cost_us);
 void lflow_cache_add_matches(struct lflow_cache *,
                              const struct uuid *lflow_uuid,
+                             const char *match, const char *actions,
                              uint32_t conj_id_ofs, uint32_t n_conjs,
-                             struct hmap *matches, size_t matches_sz);
+                             struct hmap *matches, size_t matches_sz,
+                             uint64_t cost_us);
 
 struct lflow_cache_value *lflow_cache_get(struct lflow_cache *,
-                                          const struct uuid *lflow_uuid);
+                                          const struct uuid *lflow_uuid,
+                                          const char *match,
+                                          const char *actions);
+bool lflow_cache_contains(const struct lflow_cache *,
+                          const struct uuid *lflow_uuid,
+                          const char *match, const char *actions);
 void lflow_cache_delete(struct lflow_cache *, const struct uuid *lflow_uuid);
 
+struct lflow_cache_actions *lflow_cache_get_actions(struct lflow_cache *,
+                                                    const char *actions,
+                                                    bool ingress,
+                                                    uint8_t table_id);
+struct lflow_cache_actions *lflow_cache_add_actions(
+    struct lflow_cache *, const char *actions, bool ingress,
+    uint8_t table_id, struct ofpbuf *ovnacts, const struct expr *prereqs);
+void lflow_cache_actions_unref(struct lflow_cache_actions *);
+void lflow_cache_sweep_actions(struct lflow_cache *);
+void lflow_cache_flush_actions(struct lflow_cache *);
+
 void lflow_cache_get_memory_usage(const struct lflow_cache *,
                                   struct simap *usage);
 
@@ -35,10 +35,13 @@
 #include "lib/ovn-sb-idl.h"
 #include "lib/extend-table.h"
 #include "lib/uuidset.h"
+#include "lib/ovn-parallel-hmap.h"
+#include "lib/arena.h"
 #include "packets.h"
 #include "physical.h"
 #include "simap.h"
 #include "sset.h"
+#include "timeval.h"
 
 VLOG_DEFINE_THIS_MODULE(lflow);
 
@@ -50,6 +53,10 @@ COVERAGE_DEFINE(consider_logical_flow);
 /* Contains "struct expr_symbol"s for fields supported by OVN lflows. */
 static struct shash symtab;
 
+/* Arena for the temporary expressions of consider_logical_flow__(), reset
+ * after each logical flow.  Only used by the main thread. */
+static struct arena lflow_expr_arena = ARENA_INITIALIZER;
+
 void
 lflow_init(void)
 {
@@ -91,11 +98,31 @@ add_matches_to_flow_table(const struct sbrec_logical_flow *,
                           uint8_t output_ptable, struct ofpbuf *ovnacts,
                           bool ingress, struct lflow_ctx_in *,
                           struct lflow_ctx_out *);
+static struct expr *
+parse_match(const struct sbrec_logical_flow *, int64_t dp_key,
+            struct expr **prereqs, const struct shash *addr_sets,
+            const struct shash *port_groups,
+            const struct smap *template_vars,
+            struct sset *template_vars_ref,
+            struct shash *addr_sets_ref, struct sset *port_groups_ref);
+static bool
+lflow_parse_actions(const struct sbrec_logical_flow *,
+                    const struct lflow_ctx_in *,
+                    struct sset *template_vars_ref,
+                    struct ofpbuf *ovnacts_out,
+                    struct expr **prereqs_out);
 static void
 consider_logical_flow(const struct sbrec_logical_flow *lflow,
                       bool is_recompute,
                       struct lflow_ctx_in *l_ctx_in,
                       struct lflow_ctx_out *l_ctx_out);
+struct lflow_parse_item;
+static void
+consider_logical_flow__(const struct sbrec_logical_flow *lflow,
+                        const struct sbrec_datapath_binding *dp,
+                        struct lflow_parse_item *,
+                        struct lflow_ctx_in *l_ctx_in,
+                        struct lflow_ctx_out *l_ctx_out);
 
 static void
 consider_lb_hairpin_flows(const struct ovn_controller_lb *lb,
@@ -204,15 +231,311 @@ is_chassis_resident_cb(const void *c_aux_, const char *port_name)
     }
 }
 
-/* Adds the logical flows from the Logical_Flow table to flow tables. */
+/* Number of logical flows add_logical_flows() adds between two calls to
+ * 'should_yield'. */
+#define LFLOW_YIELD_CHECK_INTERVAL 64
+
+/* A logical flow on a local datapath, parsed by 'lflow_parse_pool' before
+ * it's translated to OpenFlow by the main thread. */
+struct lflow_parse_item {
+    const struct sbrec_logical_flow *lflow;
+    const struct sbrec_datapath_binding *dp;  /* NULL if 'lflow' has no local
+                                               * datapath. */
+
+    /* Results of lflow_parse_actions(). */
+    bool actions_ok;
+    struct ofpbuf ovnacts;
+    struct expr *prereqs;
+    struct sset template_vars_ref;
+
+    /* Results of parse_match(), only if 'match_parsed' is true.  The match
+     * isn't parsed if the lflow cache already had a value for the lflow when
+     * the item was parsed. */
+    bool match_parsed;
+    struct expr *expr;
+    struct shash addr_sets_ref;
+    struct sset port_groups_ref;
+    uint64_t match_cost_us;     /* Time spent in parse_match(). */
+};
+
+/* Number of items after which add_logical_flows_parallel() runs
+ * 'lflow_parse_pool', bounds the memory used by the parsed but not yet
+ * translated logical flows. */
+#define LFLOW_PARSE_BATCH_SIZE 4096
+
+/* Work shared by all the threads of 'lflow_parse_pool'. */
+struct lflow_parse_work {
+    const struct lflow_ctx_in *l_ctx_in;
+    const struct lflow_cache *lflow_cache;
+    struct lflow_parse_item *items;
+    struct worker_task_queue tasks;  /* Indexes of 'items'. */
+};
+
+static struct worker_pool *lflow_parse_pool = NULL;
+
+static void
+lflow_parse_item_init(struct lflow_parse_item *item,
+                      const struct sbrec_logical_flow *lflow,
+                      const struct sbrec_datapath_binding *dp)
+{
+    *item = (struct lflow_parse_item) {
+        .lflow = lflow,
+        .dp = dp,
+    };
+    ofpbuf_init(&item->ovnacts, 0);
+    sset_init(&item->template_vars_ref);
+    shash_init(&item->addr_sets_ref);
+    sset_init(&item->port_groups_ref);
+}
+
 static void
+lflow_parse_item_destroy(struct lflow_parse_item *item)
+{
+    ovnacts_free(item->ovnacts.data, item->ovnacts.size);
+    ofpbuf_uninit(&item->ovnacts);
+    expr_destroy(item->prereqs);
+    expr_destroy(item->expr);
+    sset_destroy(&item->template_vars_ref);
+    shash_destroy_free_data(&item->addr_sets_ref);
+    sset_destroy(&item->port_groups_ref);
+}
+
+/* Parses the actions and, unless the lflow cache can provide it, the match
+ * of 'item'.  Only reads 'l_ctx_in' and 'lc', so it can run in a worker
+ * thread while the main thread waits. */
+static void
+lflow_parse_item_run(struct lflow_parse_item *item,
+                     const struct lflow_ctx_in *l_ctx_in,
+                     const struct lflow_cache *lc)
+{
+    const struct sbrec_logical_flow *lflow = item->lflow;
+
+    if (!item->dp) {
+        return;
+    }
+
+    item->actions_ok = lflow_parse_actions(lflow, l_ctx_in,
+                                           &item->template_vars_ref,
+                                           &item->ovnacts, &item->prereqs);
+    if (!item->actions_ok
+        || lflow_cache_contains(lc, &lflow->header_.uuid,
+                                lflow->match, lflow->actions)) {
+        return;
+    }
+
+    long long int start = time_usec();
+    item->expr = parse_match(lflow, item->dp->tunnel_key, &item->prereqs,
+                             l_ctx_in->addr_sets, l_ctx_in->port_groups,
+                             l_ctx_in->template_vars,
+                             &item->template_vars_ref,
+                             &item->addr_sets_ref, &item->port_groups_ref);
+    item->match_cost_us = time_usec() - start;
+    item->match_parsed = true;
+}
+
+static void *
+lflow_parse_thread(void *arg)
+{
+    struct worker_control *control = (struct worker_control *) arg;
+    struct lflow_parse_work *work;
+    size_t i;
+
+    while (!stop_parallel_processing()) {
+        wait_for_work(control);
+        work = (struct lflow_parse_work *) control->data;
+        if (stop_parallel_processing()) {
+            return NULL;
+        }
+        if (work) {
+            WORKER_TASK_FOR_EACH (i, control->id, &work->tasks) {
+                lflow_parse_item_run(&work->items[i], work->l_ctx_in,
+                                     work->lflow_cache);
+            }
+        }
+        post_completed_work(control);
+    }
+    return NULL;
+}
+
+static void
+lflow_parse_noop_callback(struct worker_pool *pool OVS_UNUSED,
+                          void *fin_result OVS_UNUSED,
+                          void *result_frags OVS_UNUSED,
+                          size_t index OVS_UNUSED)
+{
+    /* Do nothing */
+}
+
+/* Updates the number of threads used to parse the logical flows during a
+ * full recompute.  With a single thread, logical flows are parsed by the
+ * main thread as they are translated. */
+void
+lflow_update_worker_pool(size_t n_threads)
+{
+    update_worker_pool(MAX(n_threads, 1), &lflow_parse_pool,
+                       lflow_parse_thread);
+}
+
+/* Translates the 'n_items' parsed 'items' to OpenFlow, in order, and destroys
+ * them.  Returns false if it stopped early because 'should_yield' returned
+ * true, the remaining items are destroyed without being translated. */
+static bool
+add_parsed_logical_flows(struct lflow_parse_item *items, size_t n_items,
+                         size_t *n_added,
+                         struct lflow_ctx_in *l_ctx_in,
+                         struct lflow_ctx_out *l_ctx_out)
+{
+    bool completed = true;
+
+    for (size_t i = 0; i < n_items; i++) {
+        struct lflow_parse_item *item = &items[i];
+        const struct sbrec_logical_flow *lflow = item->lflow;
+
+        /* Logical flows with a datapath group have one item per local
+         * datapath, account for them only once. */
+        if (completed && (!i || items[i - 1].lflow != lflow)) {
+            if (l_ctx_in->should_yield
+                && !(++*n_added % LFLOW_YIELD_CHECK_INTERVAL)
+                && l_ctx_in->should_yield()) {
+                completed = false;
+            } else {
+                if (l_ctx_in->should_yield) {
+                    uuidset_insert(l_ctx_out->lflows_added,
+                                   &lflow->header_.uuid);
+                }
+                if (lflow->logical_datapath || lflow->logical_dp_group) {
+                    COVERAGE_INC(consider_logical_flow);
+                }
+            }
+        }
+        if (completed && item->dp) {
+            consider_logical_flow__(lflow, item->dp, item,
+                                    l_ctx_in, l_ctx_out);
+        }
+        lflow_parse_item_destroy(item);
+    }
+    return completed;
+}
+
+/* Parses the 'n_items' items of 'work' with 'lflow_parse_pool'. */
+static void
+lflow_parse_run_pool(struct lflow_parse_work *work, size_t n_items)
+{
+    worker_task_queue_init(&work->tasks, n_items, lflow_parse_pool->size, 0);
+    for (size_t i = 0; i < lflow_parse_pool->size; i++) {
+        lflow_parse_pool->controls[i].data = work;
+    }
+    run_pool_callback(lflow_parse_pool, NULL, NULL,
+                      lflow_parse_noop_callback);
+    worker_task_queue_destroy(&work->tasks);
+}
+
+/* Same as add_logical_flows() but parses the logical flows with
+ * 'lflow_parse_pool', in batches of about LFLOW_PARSE_BATCH_SIZE items.
+ * Everything else, including the allocation of conjunction ids and the
+ * updates of the desired flow table, is done by the main thread in the
+ * Logical_Flow table order, so the resulting flows are the same as with a
+ * single thread. */
+static bool
+add_logical_flows_parallel(struct lflow_ctx_in *l_ctx_in,
+                           struct lflow_ctx_out *l_ctx_out)
+{
+    const struct sbrec_logical_flow *lflow;
+    size_t n_items = 0, allocated_items = LFLOW_PARSE_BATCH_SIZE;
+    size_t n_added = 0;
+    bool completed = true;
+
+    struct lflow_parse_work work = {
+        .l_ctx_in = l_ctx_in,
+        .lflow_cache = l_ctx_out->lflow_cache,
+        .items = xmalloc(allocated_items * sizeof *work.items),
+    };
+
+    SBREC_LOGICAL_FLOW_TABLE_FOR_EACH (lflow, l_ctx_in->logical_flow_table) {
+        if (l_ctx_in->should_yield
+            && uuidset_find(l_ctx_out->lflows_added, &lflow->header_.uuid)) {
+            continue;
+        }
+
+        const struct sbrec_logical_dp_group *dp_group =
+            lflow->logical_dp_group;
+        const struct sbrec_datapath_binding *dp = lflow->logical_datapath;
+        size_t n_dps = dp ? 1 : dp_group ? dp_group->n_datapaths : 0;
+        size_t first_item = n_items;
+
+        for (size_t i = 0; i < n_dps; i++) {
+            const struct sbrec_datapath_binding *item_dp =
+                dp ? dp : dp_group->datapaths[i];
+
+            if (!get_local_datapath(l_ctx_in->local_datapaths,
+                                    item_dp->tunnel_key)) {
+                continue;
+            }
+            if (n_items >= allocated_items) {
+                work.items = x2nrealloc(work.items, &allocated_items,
+                                        sizeof *work.items);
+            }
+            lflow_parse_item_init(&work.items[n_items++], lflow, item_dp);
+        }
+        if (n_items == first_item) {
+            /* Nothing to parse, the item only keeps the logical flow's place
+             * for add_parsed_logical_flows(). */
+            if (n_items >= allocated_items) {
+                work.items = x2nrealloc(work.items, &allocated_items,
+                                        sizeof *work.items);
+            }
+            lflow_parse_item_init(&work.items[n_items++], lflow, NULL);
+        }
+
+        /* Batches only end on logical flow boundaries. */
+        if (n_items >= LFLOW_PARSE_BATCH_SIZE) {
+            lflow_parse_run_pool(&work, n_items);
+            completed = add_parsed_logical_flows(work.items, n_items,
+                                                 &n_added, l_ctx_in,
+                                                 l_ctx_out);
+            n_items = 0;
+            if (!completed) {
+                break;
+            }
+        }
+    }
+    if (n_items) {
+        lflow_parse_run_pool(&work, n_items);
+        completed = add_parsed_logical_flows(work.items, n_items, &n_added,
+                                             l_ctx_in, l_ctx_out);
+    }
+
+    free(work.items);
+    return completed;
+}
+
+/* Adds the logical flows from the Logical_Flow table to flow tables.
+ * Returns false if it stopped early because 'should_yield' returned true. */
+static bool
 add_logical_flows(struct lflow_ctx_in *l_ctx_in,
                   struct lflow_ctx_out *l_ctx_out)
 {
     const struct sbrec_logical_flow *lflow;
+    size_t n_added = 0;
+
+    if (lflow_parse_pool) {
+        return add_logical_flows_parallel(l_ctx_in, l_ctx_out);
+    }
+
     SBREC_LOGICAL_FLOW_TABLE_FOR_EACH (lflow, l_ctx_in->logical_flow_table) {
+        if (l_ctx_in->should_yield) {
+            if (uuidset_find(l_ctx_out->lflows_added, &lflow->header_.uuid)) {
+                continue;
+            }
+            if (!(++n_added % LFLOW_YIELD_CHECK_INTERVAL)
+                && l_ctx_in->should_yield()) {
+                return false;
+            }
+            uuidset_insert(l_ctx_out->lflows_added, &lflow->header_.uuid);
+        }
         consider_logical_flow(lflow, true, l_ctx_in, l_ctx_out);
     }
+    return true;
 }
 
 bool
@@ -318,11 +641,11 @@ store_lflow_template_refs(struct objdep_mgr *lflow_deps_mgr,
 }
 
 static bool
-lflow_parse_actions(const struct sbrec_logical_flow *lflow,
-                    const struct lflow_ctx_in *l_ctx_in,
-                    struct sset *template_vars_ref,
-                    struct ofpbuf *ovnacts_out,
-                    struct expr **prereqs_out)
+lflow_parse_actions__(const struct sbrec_logical_flow *lflow,
+                      const char *actions_s,
+                      const struct lflow_ctx_in *l_ctx_in,
+                      struct ofpbuf *ovnacts_out,
+                      struct expr **prereqs_out)
 {
     bool ingress = !strcmp(lflow->pipeline, "ingress");
     struct ovnact_parse_params pp = {
@@ -337,12 +660,8 @@ lflow_parse_actions(const struct sbrec_logical_flow *lflow,
         .cur_ltable = lflow->table_id,
     };
 
-    struct lex_str actions_s =
-        lexer_parse_template_string(lflow->actions, l_ctx_in->template_vars,
-                                    template_vars_ref);
-    char *error = ovnacts_parse_string(lex_str_get(&actions_s), &pp,
-                                       ovnacts_out, prereqs_out);
-    lex_str_free(&actions_s);
+    char *error = ovnacts_parse_string(actions_s, &pp, ovnacts_out,
+                                       prereqs_out);
     if (error) {
         static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 1);
         VLOG_WARN_RL(&rl, "error parsing actions \"%s\": %s",
@@ -353,6 +672,79 @@ lflow_parse_actions(const struct sbrec_logical_flow *lflow,
     return true;
 }
 
+static bool
+lflow_parse_actions(const struct sbrec_logical_flow *lflow,
+                    const struct lflow_ctx_in *l_ctx_in,
+                    struct sset *template_vars_ref,
+                    struct ofpbuf *ovnacts_out,
+                    struct expr **prereqs_out)
+{
+    struct lex_str actions_s =
+        lexer_parse_template_string(lflow->actions, l_ctx_in->template_vars,
+                                    template_vars_ref);
+    bool ok = lflow_parse_actions__(lflow, lex_str_get(&actions_s),
+                                    l_ctx_in, ovnacts_out, prereqs_out);
+    lex_str_free(&actions_s);
+    return ok;
+}
+
+/* Same as lflow_parse_actions() but, if the lflow cache is enabled, the
+ * actions are only parsed once for all the logical flows that have the same
+ * actions in the same logical table.  If '*lca_out' is nonnull on return,
+ * 'ovnacts_out' points to the actions cached in '*lca_out', which the caller
+ * must not free, and must release with lflow_cache_actions_unref() instead.
+ *
+ * Unlike lflow_parse_actions(), modifies the lflow cache, so it may only be
+ * called by the main thread. */
+static bool
+lflow_get_actions(const struct sbrec_logical_flow *lflow,
+                  const struct lflow_ctx_in *l_ctx_in,
+                  struct lflow_cache *lc,
+                  struct sset *template_vars_ref,
+                  struct ofpbuf *ovnacts_out,
+                  struct expr **prereqs_out,
+                  struct lflow_cache_actions **lca_out)
+{
+    *lca_out = NULL;
+    if (!lflow_cache_is_enabled(lc)) {
+        return lflow_parse_actions(lflow, l_ctx_in, template_vars_ref,
+                                   ovnacts_out, prereqs_out);
+    }
+
+    bool ingress = !strcmp(lflow->pipeline, "ingress");
+    struct lex_str actions_s =
+        lexer_parse_template_string(lflow->actions, l_ctx_in->template_vars,
+                                    template_vars_ref);
+    struct lflow_cache_actions *lca =
+        lflow_cache_get_actions(lc, lex_str_get(&actions_s), ingress,
+                                lflow->table_id);
+    bool ok = true;
+
+    if (lca) {
+        *prereqs_out = lca->prereqs ? expr_clone(lca->prereqs) : NULL;
+    } else {
+        ok = lflow_parse_actions__(lflow, lex_str_get(&actions_s), l_ctx_in,
+                                   ovnacts_out, prereqs_out);
+        if (ok) {
+            /* The cache keeps a copy of the prerequisites, which must not
+             * come from the caller's expression arena. */
+            struct arena *arena = expr_arena_set(NULL);
+            lca = lflow_cache_add_actions(lc, lex_str_get(&actions_s),
+                                          ingress, lflow->table_id,
+                                          ovnacts_out, *prereqs_out);
+            expr_arena_set(arena);
+        }
+    }
+    lex_str_free(&actions_s);
+
+    if (lca) {
+        ofpbuf_uninit(ovnacts_out);
+        ofpbuf_use_const(ovnacts_out, lca->ovnacts, lca->ovnacts_len);
+        *lca_out = lca;
+    }
+    return ok;
+}
+
 /* Parses the lflow regarding the changed address set 'as_name', and generates
  * ovs flows for the newly added addresses in 'as_diff_added' only. It is
  * similar to consider_logical_flow__, with the below differences:
@@ -960,51 +1352,32 @@ add_matches_to_flow_table(const struct sbrec_logical_flow *lflow,
  * The caller should evaluate the conditions and normalize the expr tree.
  * If parsing is successful, '*prereqs' is also consumed.
  */
+/* Parses the match of 'lflow' for the datapath with tunnel key 'dp_key' and
+ * combines it with '*prereqs'.  Adds the names of the template variables, the
+ * address sets and the port groups the match refers to to
+ * 'template_vars_ref', 'addr_sets_ref' and 'port_groups_ref'.
+ *
+ * Doesn't modify anything else, so it may run in a worker thread. */
 static struct expr *
-convert_match_to_expr(const struct sbrec_logical_flow *lflow,
-                      const struct local_datapath *ldp,
-                      struct expr **prereqs,
-                      const struct shash *addr_sets,
-                      const struct shash *port_groups,
-                      const struct smap *template_vars,
-                      struct sset *template_vars_ref,
-                      struct objdep_mgr *mgr,
-                      bool *pg_addr_set_ref)
+parse_match(const struct sbrec_logical_flow *lflow, int64_t dp_key,
+            struct expr **prereqs,
+            const struct shash *addr_sets,
+            const struct shash *port_groups,
+            const struct smap *template_vars,
+            struct sset *template_vars_ref,
+            struct shash *addr_sets_ref,
+            struct sset *port_groups_ref)
 {
-    struct shash addr_sets_ref = SHASH_INITIALIZER(&addr_sets_ref);
-    struct sset port_groups_ref = SSET_INITIALIZER(&port_groups_ref);
     char *error = NULL;
 
     struct lex_str match_s = lexer_parse_template_string(lflow->match,
                                                          template_vars,
                                                          template_vars_ref);
     struct expr *e = expr_parse_string(lex_str_get(&match_s), &symtab,
-                                       addr_sets, port_groups, &addr_sets_ref,
-                                       &port_groups_ref,
-                                       ldp->datapath->tunnel_key,
-                                       &error);
+                                       addr_sets, port_groups, addr_sets_ref,
+                                       port_groups_ref, dp_key, &error);
     lex_str_free(&match_s);
 
-    struct shash_node *addr_sets_ref_node;
-    SHASH_FOR_EACH (addr_sets_ref_node, &addr_sets_ref) {
-        objdep_mgr_add_with_refcount(mgr, OBJDEP_TYPE_ADDRSET,
-                                     addr_sets_ref_node->name,
-                                     &lflow->header_.uuid,
-                                     *(size_t *) addr_sets_ref_node->data);
-    }
-    const char *port_group_name;
-    SSET_FOR_EACH (port_group_name, &port_groups_ref) {
-        objdep_mgr_add(mgr, OBJDEP_TYPE_PORTGROUP, port_group_name,
-                       &lflow->header_.uuid);
-    }
-
-    if (pg_addr_set_ref) {
-        *pg_addr_set_ref = (!sset_is_empty(&port_groups_ref) ||
-                            !shash_is_empty(&addr_sets_ref));
-    }
-    shash_destroy_free_data(&addr_sets_ref);
-    sset_destroy(&port_groups_ref);
-
     if (!error) {
         if (*prereqs) {
             e = expr_combine(EXPR_T_AND, e, *prereqs);
@@ -1024,9 +1397,67 @@ convert_match_to_expr(const struct sbrec_logical_flow *lflow,
     return expr_simplify(e);
 }
 
+/* Stores the references of 'lflow' to the address sets and port groups its
+ * match refers to, as returned by parse_match(). */
+static void
+store_match_refs(struct objdep_mgr *mgr,
+                 const struct sbrec_logical_flow *lflow,
+                 const struct shash *addr_sets_ref,
+                 const struct sset *port_groups_ref,
+                 bool *pg_addr_set_ref)
+{
+    struct shash_node *addr_sets_ref_node;
+    SHASH_FOR_EACH (addr_sets_ref_node, addr_sets_ref) {
+        objdep_mgr_add_with_refcount(mgr, OBJDEP_TYPE_ADDRSET,
+                                     addr_sets_ref_node->name,
+                                     &lflow->header_.uuid,
+                                     *(size_t *) addr_sets_ref_node->data);
+    }
+    const char *port_group_name;
+    SSET_FOR_EACH (port_group_name, port_groups_ref) {
+        objdep_mgr_add(mgr, OBJDEP_TYPE_PORTGROUP, port_group_name,
+                       &lflow->header_.uuid);
+    }
+
+    if (pg_addr_set_ref) {
+        *pg_addr_set_ref = (!sset_is_empty(port_groups_ref) ||
+                            !shash_is_empty(addr_sets_ref));
+    }
+}
+
+static struct expr *
+convert_match_to_expr(const struct sbrec_logical_flow *lflow,
+                      const struct local_datapath *ldp,
+                      struct expr **prereqs,
+                      const struct shash *addr_sets,
+                      const struct shash *port_groups,
+                      const struct smap *template_vars,
+                      struct sset *template_vars_ref,
+                      struct objdep_mgr *mgr,
+                      bool *pg_addr_set_ref)
+{
+    struct shash addr_sets_ref = SHASH_INITIALIZER(&addr_sets_ref);
+    struct sset port_groups_ref = SSET_INITIALIZER(&port_groups_ref);
+
+    struct expr *e = parse_match(lflow, ldp->datapath->tunnel_key, prereqs,
+                                 addr_sets, port_groups, template_vars,
+                                 template_vars_ref, &addr_sets_ref,
+                                 &port_groups_ref);
+    store_match_refs(mgr, lflow, &addr_sets_ref, &port_groups_ref,
+                     pg_addr_set_ref);
+    shash_destroy_free_data(&addr_sets_ref);
+    sset_destroy(&port_groups_ref);
+
+    return e;
+}
+
+/* Translates 'lflow' for datapath 'dp' to OpenFlow.  If 'item' is nonnull,
+ * it holds the actions and possibly the match of 'lflow' already parsed by
+ * 'lflow_parse_pool', the function takes them from 'item'. */
 static void
 consider_logical_flow__(const struct sbrec_logical_flow *lflow,
                         const struct sbrec_datapath_binding *dp,
+                        struct lflow_parse_item *item,
                         struct lflow_ctx_in *l_ctx_in,
                         struct lflow_ctx_out *l_ctx_out)
 {
@@ -1078,14 +1509,36 @@ consider_logical_flow__(const struct sbrec_logical_flow *lflow,
     struct ofpbuf ovnacts = OFPBUF_STUB_INITIALIZER(ovnacts_stub);
     struct sset template_vars_ref = SSET_INITIALIZER(&template_vars_ref);
     struct expr *prereqs = NULL;
+    struct lflow_cache_actions *lca = NULL;
+    bool actions_ok;
 
-    if (!lflow_parse_actions(lflow, l_ctx_in, &template_vars_ref,
-                             &ovnacts, &prereqs)) {
+    /* All the expressions built from here on are temporary, except the one
+     * added to the lflow cache, which is cloned with the arena unset. */
+    struct arena *old_arena = expr_arena_set(&lflow_expr_arena);
+
+    if (item) {
+        actions_ok = item->actions_ok;
+        ofpbuf_uninit(&ovnacts);
+        ovnacts = item->ovnacts;
+        ofpbuf_init(&item->ovnacts, 0);
+        prereqs = item->prereqs;
+        item->prereqs = NULL;
+        sset_swap(&template_vars_ref, &item->template_vars_ref);
+    } else {
+        actions_ok = lflow_get_actions(lflow, l_ctx_in,
+                                       l_ctx_out->lflow_cache,
+                                       &template_vars_ref, &ovnacts,
+                                       &prereqs, &lca);
+    }
+    if (!actions_ok) {
         ovnacts_free(ovnacts.data, ovnacts.size);
         ofpbuf_uninit(&ovnacts);
         store_lflow_template_refs(l_ctx_out->lflow_deps_mgr,
                                   &template_vars_ref, lflow);
         sset_destroy(&template_vars_ref);
+        expr_destroy(prereqs);
+        expr_arena_set(old_arena);
+        arena_reset(&lflow_expr_arena);
         return;
     }
 
@@ -1107,7 +1560,8 @@ consider_logical_flow__(const struct sbrec_logical_flow *lflow,
     };
 
     struct lflow_cache_value *lcv =
-        lflow_cache_get(l_ctx_out->lflow_cache, &lflow->header_.uuid);
+        lflow_cache_get(l_ctx_out->lflow_cache, &lflow->header_.uuid,
+                        lflow->match, lflow->actions);
     enum lflow_cache_type lcv_type =
         lcv ? lcv->type : LCACHE_T_NONE;
 
@@ -1117,6 +1571,15 @@ consider_logical_flow__(const struct sbrec_logical_flow *lflow,
 
     bool pg_addr_set_ref = false;
 
+    /* Time spent building the expr and the matches, used by the cache to
+     * decide which entries are the most expensive to evict. */
+    long long int build_start = time_usec();
+    uint64_t expr_cost_us = 0;
+
+    if (item) {
+        build_start -= item->match_cost_us;
+    }
+
     if (lcv_type == LCACHE_T_MATCHES
         && lcv->n_conjs
         && !lflow_conj_ids_alloc_specified(l_ctx_out->conj_ids,
@@ -1134,12 +1597,21 @@ consider_logical_flow__(const struct sbrec_logical_flow *lflow,
     /* Get match expr, either from cache or from lflow match. */
     switch (lcv_type) {
     case LCACHE_T_NONE:
-        expr = convert_match_to_expr(lflow, ldp, &prereqs, l_ctx_in->addr_sets,
-                                     l_ctx_in->port_groups,
-                                     l_ctx_in->template_vars,
-                                     &template_vars_ref,
-                                     l_ctx_out->lflow_deps_mgr,
-                                     &pg_addr_set_ref);
+        if (item && item->match_parsed) {
+            expr = item->expr;
+            item->expr = NULL;
+            store_match_refs(l_ctx_out->lflow_deps_mgr, lflow,
+                             &item->addr_sets_ref, &item->port_groups_ref,
+                             &pg_addr_set_ref);
+        } else {
+            expr = convert_match_to_expr(lflow, ldp, &prereqs,
+                                         l_ctx_in->addr_sets,
+                                         l_ctx_in->port_groups,
+                                         l_ctx_in->template_vars,
+                                         &template_vars_ref,
+                                         l_ctx_out->lflow_deps_mgr,
+                                         &pg_addr_set_ref);
+        }
         if (!expr) {
             goto done;
         }
@@ -1159,7 +1631,10 @@ consider_logical_flow__(const struct sbrec_logical_flow *lflow,
             && lflow_cache_is_enabled(l_ctx_out->lflow_cache)
             && !pg_addr_set_ref
             && sset_is_empty(&template_vars_ref)) {
+        expr_arena_set(NULL);
         cached_expr = expr_clone(expr);
+        expr_arena_set(&lflow_expr_arena);
+        expr_cost_us = time_usec() - build_start;
     }
 
     /* Normalize expression if needed. */
@@ -1203,6 +1678,7 @@ consider_logical_flow__(const struct sbrec_logical_flow *lflow,
         matches = lcv->expr_matches;
         break;
     }
+    uint64_t matches_cost_us = time_usec() - build_start;
 
     add_matches_to_flow_table(lflow, ldp, matches, ptable, output_ptable,
                               &ovnacts, ingress, l_ctx_in, l_ctx_out);
@@ -1216,13 +1692,17 @@ consider_logical_flow__(const struct sbrec_logical_flow *lflow,
                 && !objdep_mgr_contains_obj(l_ctx_out->lflow_deps_mgr,
                                             &lflow->header_.uuid)) {
                 lflow_cache_add_matches(l_ctx_out->lflow_cache,
-                                        &lflow->header_.uuid, start_conj_id,
-                                        n_conjs, matches, matches_size);
+                                        &lflow->header_.uuid, lflow->match,
+                                        lflow->actions, start_conj_id,
+                                        n_conjs, matches, matches_size,
+                                        matches_cost_us);
                 matches = NULL;
             } else if (cached_expr) {
                 lflow_cache_add_expr(l_ctx_out->lflow_cache,
-                                     &lflow->header_.uuid,
-                                     cached_expr, expr_size(cached_expr));
+                                     &lflow->header_.uuid, lflow->match,
+                                     lflow->actions, cached_expr,
+                                     expr_size(cached_expr),
+                                     expr_cost_us);
                 cached_expr = NULL;
             }
         }
@@ -1237,13 +1717,20 @@ consider_logical_flow__(const struct sbrec_logical_flow *lflow,
 
 done:
     expr_destroy(prereqs);
-    ovnacts_free(ovnacts.data, ovnacts.size);
+    if (lca) {
+        lflow_cache_actions_unref(lca);
+    } else {
+        ovnacts_free(ovnacts.data, ovnacts.size);
+    }
     ofpbuf_uninit(&ovnacts);
     expr_destroy(expr);
     expr_destroy(cached_expr);
     expr_matches_destroy(matches);
     free(matches);
 
+    expr_arena_set(old_arena);
+    arena_reset(&lflow_expr_arena);
+
     store_lflow_template_refs(l_ctx_out->lflow_deps_mgr,
                               &template_vars_ref, lflow);
     sset_destroy(&template_vars_ref);
@@ -1273,11 +1760,11 @@ consider_logical_flow(const struct sbrec_logical_flow *lflow,
     }
 
     if (dp) {
-        consider_logical_flow__(lflow, dp, l_ctx_in, l_ctx_out);
+        consider_logical_flow__(lflow, dp, NULL, l_ctx_in, l_ctx_out);
         return;
     }
     for (size_t i = 0; dp_group && i < dp_group->n_datapaths; i++) {
-        consider_logical_flow__(lflow, dp_group->datapaths[i],
+        consider_logical_flow__(lflow, dp_group->datapaths[i], NULL,
                                 l_ctx_in, l_ctx_out);
     }
 }
@@ -2141,13 +2628,19 @@ add_fdb_flows(const struct sbrec_fdb_table *fdb_table,
 
 
 /* Translates logical flows in the Logical_Flow table in the OVN_SB database
- * into OpenFlow flows.  See ovn-architecture(7) for more information. */
-void
+ * into OpenFlow flows.  See ovn-architecture(7) for more information.
+ *
+ * Returns false if it stopped early because 'l_ctx_in->should_yield'
+ * returned true, in which case it must be called again with the same
+ * 'l_ctx_out' to add the remaining flows. */
+bool
 lflow_run(struct lflow_ctx_in *l_ctx_in, struct lflow_ctx_out *l_ctx_out)
 {
     COVERAGE_INC(lflow_run);
 
-    add_logical_flows(l_ctx_in, l_ctx_out);
+    if (!add_logical_flows(l_ctx_in, l_ctx_out)) {
+        return false;
+    }
     add_neighbor_flows(l_ctx_in->sbrec_port_binding_by_name,
                        l_ctx_in->mac_binding_table,
                        l_ctx_in->static_mac_binding_table,
@@ -2163,6 +2656,7 @@ lflow_run(struct lflow_ctx_in *l_ctx_in, struct lflow_ctx_out *l_ctx_out)
                   l_ctx_in->localnet_learn_fdb);
     add_port_sec_flows(l_ctx_in->binding_lports, l_ctx_in->chassis,
                        l_ctx_out->flow_table);
+    return true;
 }
 
 /* Should be called at every ovn-controller iteration before IDL tracked
@@ -2187,6 +2681,7 @@ lflow_destroy(void)
 {
     expr_symtab_destroy(&symtab);
     shash_destroy(&symtab);
+    arena_destroy(&lflow_expr_arena);
 }
 
 bool
@@ -2207,7 +2702,7 @@ lflow_add_flows_for_datapath(const struct sbrec_datapath_binding *dp,
             continue;
         }
         uuidset_insert(l_ctx_out->objs_processed, &lflow->header_.uuid);
-        consider_logical_flow__(lflow, dp, l_ctx_in, l_ctx_out);
+        consider_logical_flow__(lflow, dp, NULL, l_ctx_in, l_ctx_out);
     }
     sbrec_logical_flow_index_destroy_row(lf_row);
 
@@ -2238,7 +2733,7 @@ lflow_add_flows_for_datapath(const struct sbrec_datapath_binding *dp,
             /* Don't call uuidset_insert() because here we process the
              * lflow only for one of the DPs in the DP group, which may be
              * incomplete. */
-            consider_logical_flow__(lflow, dp, l_ctx_in, l_ctx_out);
+            consider_logical_flow__(lflow, dp, NULL, l_ctx_in, l_ctx_out);
         }
     }
     sbrec_logical_flow_index_destroy_row(lf_row);
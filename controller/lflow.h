@@ -132,6 +132,10 @@ struct lflow_ctx_in {
     bool localnet_learn_fdb;
     bool localnet_learn_fdb_changed;
     bool explicit_arp_ns_output;
+
+    /* If nonnull, lflow_run() calls it periodically and stops early if it
+     * returns true. */
+    bool (*should_yield)(void);
 };
 
 struct lflow_ctx_out {
@@ -143,10 +147,16 @@ struct lflow_ctx_out {
     struct lflow_cache *lflow_cache;
     struct conj_ids *conj_ids;
     struct uuidset *objs_processed;
+
+    /* Logical flows already added by lflow_run(), required if
+     * 'should_yield' is set.  A lflow_run() that stopped early continues
+     * with the logical flows that are not in it. */
+    struct uuidset *lflows_added;
 };
 
 void lflow_init(void);
-void lflow_run(struct lflow_ctx_in *, struct lflow_ctx_out *);
+void lflow_update_worker_pool(size_t n_threads);
+bool lflow_run(struct lflow_ctx_in *, struct lflow_ctx_out *);
 void lflow_handle_cached_flows(struct lflow_cache *,
                                const struct sbrec_logical_flow_table *);
 bool lflow_handle_changed_flows(struct lflow_ctx_in *,
@@ -644,6 +644,13 @@ update_sb_db(struct ovsdb_idl *ovs_idl, struct ovsdb_idl *ovnsb_idl,
         *reset_ovnsb_idl_min_index = false;
     }
 
+    engine_set_time_slice(
+        get_chassis_external_id_value_uint(&cfg->external_ids, chassis_id,
+                                           "ovn-engine-time-slice-ms", 0));
+    lflow_update_worker_pool(
+        get_chassis_external_id_value_uint(&cfg->external_ids, chassis_id,
+                                           "ovn-lflow-parse-threads", 1));
+
     if (ctx) {
         lflow_cache_enable(
             ctx->lflow_cache,
@@ -2108,6 +2115,9 @@ en_template_vars_cleanup(void *data)
 
 struct ed_type_addr_sets {
     struct shash addr_sets;
+    /* Aggregate the addresses of each set into CIDR prefixes, see
+     * expr_constant_set_aggregate(). */
+    bool aggregate;
     bool change_tracked;
     struct sset new;
     struct sset deleted;
@@ -2159,23 +2169,45 @@ en_addr_sets_cleanup(void *data)
     shash_destroy(&as->updated);
 }
 
+static bool
+addr_sets_aggregate_enabled(const struct ovsrec_open_vswitch_table *ovs_table)
+{
+    const struct ovsrec_open_vswitch *cfg =
+        ovsrec_open_vswitch_table_first(ovs_table);
+
+    return cfg && get_chassis_external_id_value_bool(
+                      &cfg->external_ids, get_ovs_chassis_id(ovs_table),
+                      "ovn-aggregate-address-sets", false);
+}
+
+static struct expr_constant_set *
+addr_set_create(const struct sbrec_address_set *as, bool aggregate)
+{
+    struct expr_constant_set *cs =
+        expr_constant_set_create_integers(
+            (const char *const *) as->addresses, as->n_addresses);
+    if (aggregate) {
+        expr_constant_set_aggregate(cs);
+    }
+    return cs;
+}
+
 /* Iterate address sets in the southbound database.  Create and update the
  * corresponding symtab entries as necessary. */
 static void
 addr_sets_init(const struct sbrec_address_set_table *address_set_table,
-               struct shash *addr_sets)
+               struct shash *addr_sets, bool aggregate)
 {
     const struct sbrec_address_set *as;
     SBREC_ADDRESS_SET_TABLE_FOR_EACH (as, address_set_table) {
-        expr_const_sets_add_integers(addr_sets, as->name,
-                                     (const char *const *) as->addresses,
-                                     as->n_addresses);
+        expr_const_sets_add(addr_sets, as->name,
+                            addr_set_create(as, aggregate));
     }
 }
 
 static void
 addr_sets_update(const struct sbrec_address_set_table *address_set_table,
-                 struct shash *addr_sets, struct sset *added,
+                 struct shash *addr_sets, bool aggregate, struct sset *added,
                  struct sset *deleted, struct shash *updated)
 {
     const struct sbrec_address_set *as;
@@ -2192,13 +2224,12 @@ addr_sets_update(const struct sbrec_address_set_table *address_set_table,
                                                                as->name);
             if (!cs_old) {
                 sset_add(added, as->name);
-                expr_const_sets_add_integers(addr_sets, as->name,
-                    (const char *const *) as->addresses, as->n_addresses);
+                expr_const_sets_add(addr_sets, as->name,
+                                    addr_set_create(as, aggregate));
             } else {
                 /* Find out the diff for the updated address set. */
                 struct expr_constant_set *cs_new =
-                    expr_constant_set_create_integers(
-                        (const char *const *) as->addresses, as->n_addresses);
+                    addr_set_create(as, aggregate);
                 struct addr_set_diff *as_diff = xmalloc(sizeof *as_diff);
                 expr_constant_set_integers_diff(cs_old, cs_new,
                                                 &as_diff->added,
@@ -2229,8 +2260,11 @@ en_addr_sets_run(struct engine_node *node, void *data)
     struct sbrec_address_set_table *as_table =
         (struct sbrec_address_set_table *)EN_OVSDB_GET(
             engine_get_input("SB_address_set", node));
+    const struct ovsrec_open_vswitch_table *ovs_table =
+        EN_OVSDB_GET(engine_get_input("OVS_open_vswitch", node));
 
-    addr_sets_init(as_table, &as->addr_sets);
+    as->aggregate = addr_sets_aggregate_enabled(ovs_table);
+    addr_sets_init(as_table, &as->addr_sets, as->aggregate);
 
     as->change_tracked = false;
     engine_set_node_state(node, EN_UPDATED);
@@ -2245,7 +2279,7 @@ addr_sets_sb_address_set_handler(struct engine_node *node, void *data)
         (struct sbrec_address_set_table *)EN_OVSDB_GET(
             engine_get_input("SB_address_set", node));
 
-    addr_sets_update(as_table, &as->addr_sets, &as->new,
+    addr_sets_update(as_table, &as->addr_sets, as->aggregate, &as->new,
                      &as->deleted, &as->updated);
 
     if (!sset_is_empty(&as->new) || !sset_is_empty(&as->deleted) ||
@@ -2259,6 +2293,22 @@ addr_sets_sb_address_set_handler(struct engine_node *node, void *data)
     return true;
 }
 
+static bool
+addr_sets_ovs_open_vswitch_handler(struct engine_node *node, void *data)
+{
+    struct ed_type_addr_sets *as = data;
+
+    const struct ovsrec_open_vswitch_table *ovs_table =
+        EN_OVSDB_GET(engine_get_input("OVS_open_vswitch", node));
+
+    /* The address sets only need to be rebuilt if the aggregation is
+     * enabled or disabled. */
+    if (addr_sets_aggregate_enabled(ovs_table) != as->aggregate) {
+        return false;
+    }
+    return true;
+}
+
 struct ed_type_port_groups{
     /* A copy of SB port_groups, each converted as a sset for efficient lport
      * lookup. */
@@ -3874,6 +3924,9 @@ struct ed_type_lflow_output {
      * execution. */
     struct uuidset objs_processed;
 
+    /* lflows added so far by a time sliced recompute that yielded. */
+    struct uuidset lflows_added;
+
     /* Data which is persistent and not cleared during
      * full recompute. */
     struct lflow_output_persistent_data pd;
@@ -4034,6 +4087,7 @@ init_lflow_ctx(struct engine_node *node,
     l_ctx_in->template_vars = &template_vars->local_templates;
     l_ctx_in->collector_ids = &fo->collector_ids;
     l_ctx_in->local_lbs = &lb_data->local_lbs;
+    l_ctx_in->should_yield = NULL;
 
     l_ctx_out->flow_table = &fo->flow_table;
     l_ctx_out->group_table = &fo->group_table;
@@ -4041,6 +4095,7 @@ init_lflow_ctx(struct engine_node *node,
     l_ctx_out->lflow_deps_mgr = &fo->lflow_deps_mgr;
     l_ctx_out->conj_ids = &fo->conj_ids;
     l_ctx_out->objs_processed = &fo->objs_processed;
+    l_ctx_out->lflows_added = NULL;
     l_ctx_out->lflow_cache = fo->pd.lflow_cache;
 }
 
@@ -4055,6 +4110,7 @@ en_lflow_output_init(struct engine_node *node OVS_UNUSED,
     objdep_mgr_init(&data->lflow_deps_mgr);
     lflow_conj_ids_init(&data->conj_ids);
     uuidset_init(&data->objs_processed);
+    uuidset_init(&data->lflows_added);
     nd_ra_opts_init(&data->nd_ra_opts);
     controller_event_opts_init(&data->controller_event_opts);
     flow_collector_ids_init(&data->collector_ids);
@@ -4078,6 +4134,7 @@ en_lflow_output_cleanup(void *data)
     objdep_mgr_destroy(&flow_output_data->lflow_deps_mgr);
     lflow_conj_ids_destroy(&flow_output_data->conj_ids);
     uuidset_destroy(&flow_output_data->objs_processed);
+    uuidset_destroy(&flow_output_data->lflows_added);
     lflow_cache_destroy(flow_output_data->pd.lflow_cache);
     nd_ra_opts_destroy(&flow_output_data->nd_ra_opts);
     controller_event_opts_destroy(&flow_output_data->controller_event_opts);
@@ -4125,25 +4182,45 @@ en_lflow_output_run(struct engine_node *node, void *data)
     struct ovn_extend_table *meter_table = &fo->meter_table;
     struct objdep_mgr *lflow_deps_mgr = &fo->lflow_deps_mgr;
 
+    /* A resumed recompute continues with the flows it already added. */
     static bool first_run = true;
     if (first_run) {
         first_run = false;
-    } else {
+    } else if (!engine_node_resuming(node)) {
         ovn_desired_flow_table_clear(lflow_table);
         ovn_extend_table_clear(group_table, false /* desired */);
         ovn_extend_table_clear(meter_table, false /* desired */);
         objdep_mgr_clear(lflow_deps_mgr);
         lflow_conj_ids_clear(&fo->conj_ids);
+        uuidset_clear(&fo->lflows_added);
     }
 
     struct controller_engine_ctx *ctrl_ctx = engine_get_context()->client_ctx;
 
     fo->pd.lflow_cache = ctrl_ctx->lflow_cache;
 
+    /* The cached actions may refer to DHCP options, and the ones that weren't
+     * used since the previous recompute are most likely stale. */
+    if (!engine_node_resuming(node)) {
+        if (engine_node_changed(engine_get_input("dhcp_options", node))) {
+            lflow_cache_flush_actions(ctrl_ctx->lflow_cache);
+        } else {
+            lflow_cache_sweep_actions(ctrl_ctx->lflow_cache);
+        }
+    }
+
     struct lflow_ctx_in l_ctx_in;
     struct lflow_ctx_out l_ctx_out;
     init_lflow_ctx(node, fo, &l_ctx_in, &l_ctx_out);
-    lflow_run(&l_ctx_in, &l_ctx_out);
+    if (engine_time_slice_enabled()) {
+        l_ctx_in.should_yield = engine_time_slice_expired;
+        l_ctx_out.lflows_added = &fo->lflows_added;
+    }
+    if (!lflow_run(&l_ctx_in, &l_ctx_out)) {
+        engine_node_yield(node);
+        return;
+    }
+    uuidset_clear(&fo->lflows_added);
 
     engine_set_node_state(node, EN_UPDATED);
 }
@@ -5407,6 +5484,8 @@ main(int argc, char *argv[])
 
     engine_add_input(&en_addr_sets, &en_sb_address_set,
                      addr_sets_sb_address_set_handler);
+    engine_add_input(&en_addr_sets, &en_ovs_open_vswitch,
+                     addr_sets_ovs_open_vswitch_handler);
     engine_add_input(&en_port_groups, &en_sb_port_group,
                      port_groups_sb_port_group_handler);
     /* port_groups computation requires runtime_data's lbinding_data for the
@@ -5726,6 +5805,7 @@ main(int argc, char *argv[])
             local_datapath_memory_usage(&usage);
             ovsdb_idl_get_memory_usage(ovnsb_idl_loop.idl, &usage);
             ovsdb_idl_get_memory_usage(ovs_idl_loop.idl, &usage);
+            engine_get_memory_usage(&usage);
             memory_report(&usage);
             simap_destroy(&usage);
         }
@@ -6111,6 +6191,9 @@ main(int argc, char *argv[])
                              " either: br_int %p, chassis %p",
                              br_int, chassis);
                 }
+            } else if (engine_suspended()) {
+                VLOG_DBG("engine run was suspended, resume it next time: "
+                         "br_int %p, chassis %p", br_int, chassis);
             } else if (engine_canceled()) {
                 VLOG_DBG("engine was canceled, force recompute next time: "
                          "br_int %p, chassis %p", br_int, chassis);
@@ -16,6 +16,7 @@
 #include <config.h>
 
 #include "lib/uuid.h"
+#include "openvswitch/ofpbuf.h"
 #include "ovn/expr.h"
 #include "tests/ovstest.h"
 #include "tests/test-utils.h"
@@ -34,11 +35,16 @@
 
 #define TEST_LFLOW_CACHE_TRIM_TO_MS 30000
 
+/* Actions of the entries that are added with a match. */
+#define TEST_LFLOW_CACHE_ACTIONS "next;"
+
 static void
 test_lflow_cache_add__(struct lflow_cache *lc, const char *op_type,
                        const struct uuid *lflow_uuid,
                        unsigned int conj_id_ofs,
                        unsigned int n_conjs,
+                       unsigned int cost_us,
+                       const char *match,
                        struct expr *e)
 {
     printf("ADD %s:\n", op_type);
@@ -46,15 +52,18 @@ test_lflow_cache_add__(struct lflow_cache *lc, const char *op_type,
     printf("  n_conjs: %u\n", n_conjs);
 
     if (!strcmp(op_type, "expr")) {
-        lflow_cache_add_expr(lc, lflow_uuid, expr_clone(e),
-                             TEST_LFLOW_CACHE_VALUE_SIZE);
+        lflow_cache_add_expr(lc, lflow_uuid, match,
+                             match ? TEST_LFLOW_CACHE_ACTIONS : NULL,
+                             expr_clone(e), TEST_LFLOW_CACHE_VALUE_SIZE,
+                             cost_us);
     } else if (!strcmp(op_type, "matches")) {
         struct hmap *matches = xmalloc(sizeof *matches);
         ovs_assert(expr_to_matches(e, NULL, NULL, matches) == 0);
         ovs_assert(hmap_count(matches) == 1);
-        lflow_cache_add_matches(lc, lflow_uuid,
+        lflow_cache_add_matches(lc, lflow_uuid, match,
+                                match ? TEST_LFLOW_CACHE_ACTIONS : NULL,
                                 conj_id_ofs, n_conjs, matches,
-                                TEST_LFLOW_CACHE_VALUE_SIZE);
+                                TEST_LFLOW_CACHE_VALUE_SIZE, cost_us);
     } else {
         OVS_NOT_REACHED();
     }
@@ -62,9 +71,12 @@ test_lflow_cache_add__(struct lflow_cache *lc, const char *op_type,
 
 static void
 test_lflow_cache_lookup__(struct lflow_cache *lc,
-                          const struct uuid *lflow_uuid)
+                          const struct uuid *lflow_uuid,
+                          const char *match)
 {
-    struct lflow_cache_value *lcv = lflow_cache_get(lc, lflow_uuid);
+    struct lflow_cache_value *lcv =
+        lflow_cache_get(lc, lflow_uuid, match,
+                        match ? TEST_LFLOW_CACHE_ACTIONS : NULL);
 
     printf("LOOKUP:\n");
     if (!lcv) {
@@ -87,6 +99,32 @@ test_lflow_cache_lookup__(struct lflow_cache *lc,
     }
 }
 
+static void
+test_lflow_cache_lookup_actions__(struct lflow_cache *lc, const char *actions)
+{
+    struct lflow_cache_actions *lca =
+        lflow_cache_get_actions(lc, actions, true, 0);
+
+    printf("LOOKUP actions:\n");
+    printf("  %s\n", lca ? "found" : "not found");
+    lflow_cache_actions_unref(lca);
+}
+
+static void
+test_lflow_cache_add_actions__(struct lflow_cache *lc, const char *actions,
+                               const struct expr *prereqs)
+{
+    struct ofpbuf ovnacts;
+
+    printf("ADD actions:\n");
+    printf("  %s\n", actions);
+
+    ofpbuf_init(&ovnacts, 0);
+    lflow_cache_actions_unref(lflow_cache_add_actions(lc, actions, true, 0,
+                                                      &ovnacts, prereqs));
+    ofpbuf_uninit(&ovnacts);
+}
+
 static void
 test_lflow_cache_delete__(struct lflow_cache *lc,
                           const struct uuid *lflow_uuid)
@@ -152,6 +190,23 @@ test_lflow_cache_operations(struct ovs_cmdl_context *ctx)
                 goto done;
             }
 
+            unsigned int cost_us = 0;
+            if (shift < ctx->argc && !strcmp(ctx->argv[shift], "cost")) {
+                shift++;
+                if (!test_read_uint_value(ctx, shift++, "cost", &cost_us)) {
+                    goto done;
+                }
+            }
+
+            const char *match = NULL;
+            if (shift < ctx->argc && !strcmp(ctx->argv[shift], "match")) {
+                shift++;
+                match = test_read_value(ctx, shift++, "match");
+                if (!match) {
+                    goto done;
+                }
+            }
+
             if (n_lflow_uuids == n_allocated_lflow_uuids) {
                 lflow_uuids = x2nrealloc(lflow_uuids, &n_allocated_lflow_uuids,
                                          sizeof *lflow_uuids);
@@ -160,8 +215,45 @@ test_lflow_cache_operations(struct ovs_cmdl_context *ctx)
 
             uuid_generate(lflow_uuid);
             test_lflow_cache_add__(lc, op_type, lflow_uuid, conj_id_ofs,
-                                   n_conjs, e);
-            test_lflow_cache_lookup__(lc, lflow_uuid);
+                                   n_conjs, cost_us, match, e);
+            test_lflow_cache_lookup__(lc, lflow_uuid, NULL);
+        } else if (!strcmp(op, "lookup")) {
+            unsigned int idx;
+            if (!test_read_uint_value(ctx, shift++, "idx", &idx)) {
+                goto done;
+            }
+            ovs_assert(idx < n_lflow_uuids);
+            test_lflow_cache_lookup__(lc, &lflow_uuids[idx], NULL);
+        } else if (!strcmp(op, "lookup-match")) {
+            const char *match = test_read_value(ctx, shift++, "match");
+            if (!match) {
+                goto done;
+            }
+
+            if (n_lflow_uuids == n_allocated_lflow_uuids) {
+                lflow_uuids = x2nrealloc(lflow_uuids, &n_allocated_lflow_uuids,
+                                         sizeof *lflow_uuids);
+            }
+            struct uuid *lflow_uuid = &lflow_uuids[n_lflow_uuids++];
+
+            uuid_generate(lflow_uuid);
+            test_lflow_cache_lookup__(lc, lflow_uuid, match);
+        } else if (!strcmp(op, "add-actions")) {
+            const char *actions = test_read_value(ctx, shift++, "actions");
+            if (!actions) {
+                goto done;
+            }
+            test_lflow_cache_add_actions__(lc, actions, e);
+            test_lflow_cache_lookup_actions__(lc, actions);
+        } else if (!strcmp(op, "lookup-actions")) {
+            const char *actions = test_read_value(ctx, shift++, "actions");
+            if (!actions) {
+                goto done;
+            }
+            test_lflow_cache_lookup_actions__(lc, actions);
+        } else if (!strcmp(op, "sweep-actions")) {
+            printf("SWEEP actions\n");
+            lflow_cache_sweep_actions(lc);
         } else if (!strcmp(op, "add-del")) {
             const char *op_type = test_read_value(ctx, shift++, "op_type");
             if (!op_type) {
@@ -183,10 +275,10 @@ test_lflow_cache_operations(struct ovs_cmdl_context *ctx)
             struct uuid lflow_uuid;
             uuid_generate(&lflow_uuid);
             test_lflow_cache_add__(lc, op_type, &lflow_uuid, conj_id_ofs,
-                                   n_conjs, e);
-            test_lflow_cache_lookup__(lc, &lflow_uuid);
+                                   n_conjs, 0, NULL, e);
+            test_lflow_cache_lookup__(lc, &lflow_uuid, NULL);
             test_lflow_cache_delete__(lc, &lflow_uuid);
-            test_lflow_cache_lookup__(lc, &lflow_uuid);
+            test_lflow_cache_lookup__(lc, &lflow_uuid, NULL);
         } else if (!strcmp(op, "del")) {
             ovs_assert(n_lflow_uuids);
             test_lflow_cache_delete__(lc, &lflow_uuids[n_lflow_uuids - 1]);
@@ -269,11 +361,11 @@ test_lflow_cache_negative(struct ovs_cmdl_context *ctx OVS_UNUSED)
         ovs_assert(expr_to_matches(e, NULL, NULL, matches) == 0);
         ovs_assert(hmap_count(matches) == 1);
 
-        lflow_cache_add_expr(lcs[i], NULL, NULL, 0);
-        lflow_cache_add_expr(lcs[i], NULL, e, expr_size(e));
-        lflow_cache_add_matches(lcs[i], NULL, 0, 0, NULL, 0);
-        lflow_cache_add_matches(lcs[i], NULL, 0, 0, matches,
-                                TEST_LFLOW_CACHE_VALUE_SIZE);
+        lflow_cache_add_expr(lcs[i], NULL, NULL, NULL, NULL, 0, 0);
+        lflow_cache_add_expr(lcs[i], NULL, NULL, NULL, e, expr_size(e), 0);
+        lflow_cache_add_matches(lcs[i], NULL, NULL, NULL, 0, 0, NULL, 0, 0);
+        lflow_cache_add_matches(lcs[i], NULL, NULL, NULL, 0, 0, matches,
+                                TEST_LFLOW_CACHE_VALUE_SIZE, 0);
         lflow_cache_destroy(lcs[i]);
     }
 }
@@ -59,6 +59,7 @@
 #include "openvswitch/match.h"
 #include "openvswitch/meta-flow.h"
 #include "logical-fields.h"
+#include "ovs-atomic.h"
 #include "smap.h"
 
 struct ds;
@@ -263,6 +264,16 @@ struct expr_symbol {
     bool must_crossproduct;
     enum expr_write_scope rw; /* Bit map indicating in which nested contexts
                                * the symbol is writeable */
+
+    /* Annotated 'predicate' and 'prereqs', set on their first successful
+     * expansion.  Internal to expr.c.
+     *
+     * Guarded by atomic access: these may be set concurrently by threads that
+     * annotate expressions with the same symbol table, so they are only read
+     * with acquire and set once with compare-and-exchange, and they are only
+     * accessed through the symbol table that owns the symbol. */
+    ATOMIC(struct expr *) predicate_expr;
+    ATOMIC(struct expr *) prereqs_expr;
 };
 
 void expr_symbol_format(const struct expr_symbol *, struct ds *);
@@ -368,6 +379,8 @@ bool expr_relop_from_token(enum lex_type type, enum expr_relop *relop);
 struct expr {
     struct ovs_list node;       /* In parent EXPR_T_AND or EXPR_T_OR if any. */
     enum expr_type type;        /* Expression type. */
+    bool in_arena;              /* Allocated from an arena, see
+                                   expr_arena_set(). */
     const char *as_name;        /* Address set name. Null if it is not an
                                    address set. */
 
@@ -405,6 +418,9 @@ struct expr {
     };
 };
 
+struct arena;
+struct arena *expr_arena_set(struct arena *);
+
 struct expr *expr_create_boolean(bool b);
 struct expr *expr_create_andor(enum expr_type);
 struct expr *expr_combine(enum expr_type, struct expr *a, struct expr *b);
@@ -548,6 +564,7 @@ void expr_constant_set_format(const struct expr_constant_set *, struct ds *);
 void expr_constant_set_destroy(struct expr_constant_set *cs);
 struct expr_constant_set * expr_constant_set_create_integers(
                                 const char *const *values, size_t n_values);
+void expr_constant_set_aggregate(struct expr_constant_set *);
 void expr_constant_set_integers_diff(
                                 struct expr_constant_set *old,
                                 struct expr_constant_set *new,
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2024, Red Hat, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+/* OVS includes */
+#include "util.h"
+
+/* OVN includes */
+#include "arena.h"
+
+/* Size of the regular chunks.  Larger allocations get a chunk of their
+ * own. */
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+/* Alignment of the allocations, the same as malloc() provides on the common
+ * 64-bit platforms. */
+#define ARENA_ALIGNMENT 16
+
+struct arena_chunk {
+    struct arena_chunk *next;
+    size_t size;                /* Bytes in 'data'. */
+    size_t used;                /* Bytes of 'data' handed out. */
+    OVS_ALIGNED_VAR(ARENA_ALIGNMENT) char data[];
+};
+
+static struct arena_chunk *
+arena_chunk_create(struct arena *arena, size_t size)
+{
+    struct arena_chunk *chunk = xmalloc(sizeof *chunk + size);
+
+    chunk->size = size;
+    chunk->used = 0;
+    arena->n_bytes_allocated += size;
+    return chunk;
+}
+
+void
+arena_init(struct arena *arena)
+{
+    *arena = (struct arena) ARENA_INITIALIZER;
+}
+
+void
+arena_destroy(struct arena *arena)
+{
+    struct arena_chunk *chunk = arena->chunks;
+
+    while (chunk) {
+        struct arena_chunk *next = chunk->next;
+
+        free(chunk);
+        chunk = next;
+    }
+    arena_init(arena);
+}
+
+/* Releases all the memory allocated from 'arena' at once.  One regular
+ * chunk is kept for the next allocations. */
+void
+arena_reset(struct arena *arena)
+{
+    struct arena_chunk *keep = NULL;
+    struct arena_chunk *chunk = arena->chunks;
+
+    while (chunk) {
+        struct arena_chunk *next = chunk->next;
+
+        if (!keep && chunk->size == ARENA_CHUNK_SIZE) {
+            keep = chunk;
+        } else {
+            free(chunk);
+        }
+        chunk = next;
+    }
+
+    arena->chunks = keep;
+    arena->n_bytes_in_use = 0;
+    arena->n_bytes_allocated = 0;
+    if (keep) {
+        keep->next = NULL;
+        keep->used = 0;
+        arena->n_bytes_allocated = keep->size;
+    }
+}
+
+/* Returns 'size' bytes of uninitialized memory from 'arena'.  The memory is
+ * released by arena_reset() or arena_destroy(). */
+void *
+arena_alloc(struct arena *arena, size_t size)
+{
+    struct arena_chunk *chunk = arena->chunks;
+
+    size = ROUND_UP(MAX(size, 1), ARENA_ALIGNMENT);
+    arena->n_bytes_in_use += size;
+
+    if (size > ARENA_CHUNK_SIZE / 4) {
+        /* Link the dedicated chunk after the current one, so that the rest
+         * of the current chunk is still used. */
+        struct arena_chunk *big = arena_chunk_create(arena, size);
+
+        big->used = size;
+        if (chunk) {
+            big->next = chunk->next;
+            chunk->next = big;
+        } else {
+            big->next = NULL;
+            arena->chunks = big;
+        }
+        return big->data;
+    }
+
+    if (!chunk || chunk->size - chunk->used < size) {
+        chunk = arena_chunk_create(arena, ARENA_CHUNK_SIZE);
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+
+    void *p = &chunk->data[chunk->used];
+    chunk->used += size;
+    return p;
+}
+
+void *
+arena_zalloc(struct arena *arena, size_t size)
+{
+    void *p = arena_alloc(arena, size);
+
+    memset(p, 0, size);
+    return p;
+}
+
+void *
+arena_memdup(struct arena *arena, const void *src, size_t size)
+{
+    void *p = arena_alloc(arena, size);
+
+    memcpy(p, src, size);
+    return p;
+}
+
+char *
+arena_strdup(struct arena *arena, const char *s)
+{
+    return arena_memdup(arena, s, strlen(s) + 1);
+}
+
+/* Accounts for the 'size' bytes at 'p', allocated from 'arena', as no longer
+ * in use.  The memory itself is only released by arena_reset() or
+ * arena_destroy().  'p' may be NULL. */
+void
+arena_free(struct arena *arena, void *p, size_t size)
+{
+    if (p) {
+        size = ROUND_UP(MAX(size, 1), ARENA_ALIGNMENT);
+        ovs_assert(arena->n_bytes_in_use >= size);
+        arena->n_bytes_in_use -= size;
+    }
+}
+
+size_t
+arena_bytes_in_use(const struct arena *arena)
+{
+    return arena->n_bytes_in_use;
+}
+
+size_t
+arena_bytes_allocated(const struct arena *arena)
+{
+    return arena->n_bytes_allocated;
+}
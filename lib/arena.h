@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2024, Red Hat, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OVN_ARENA_H
+#define OVN_ARENA_H 1
+
+#include <stddef.h>
+
+/* Arena allocator.
+ * ================
+ *
+ * Hands out memory from large chunks.  The memory of an arena can only be
+ * released all at once, with arena_reset(), which takes time proportional to
+ * the number of chunks instead of the number of objects allocated from them.
+ *
+ * arena_free() only accounts for an object that is no longer used, its
+ * memory stays unavailable until the next arena_reset().  Users that free
+ * objects individually, e.g., from incremental processing, can compare
+ * arena_bytes_in_use() with arena_bytes_allocated() to decide when to
+ * rebuild their data in a fresh arena.
+ *
+ * Thread safety
+ * =============
+ * An arena requires exclusive access to it for all the functions. */
+
+struct arena_chunk;
+
+struct arena {
+    struct arena_chunk *chunks; /* Current chunk first. */
+    size_t n_bytes_in_use;      /* Allocated and not arena_free()'d. */
+    size_t n_bytes_allocated;   /* Total size of 'chunks'. */
+};
+
+#define ARENA_INITIALIZER { .chunks = NULL }
+
+void arena_init(struct arena *);
+void arena_destroy(struct arena *);
+void arena_reset(struct arena *);
+
+void *arena_alloc(struct arena *, size_t size);
+void *arena_zalloc(struct arena *, size_t size);
+void *arena_memdup(struct arena *, const void *, size_t size);
+char *arena_strdup(struct arena *, const char *);
+void arena_free(struct arena *, void *, size_t size);
+
+size_t arena_bytes_in_use(const struct arena *);
+size_t arena_bytes_allocated(const struct arena *);
+
+#endif /* lib/arena.h */
@@ -12,6 +12,8 @@ endif
 lib_libovn_la_SOURCES = \
 	lib/acl-log.c \
 	lib/acl-log.h \
+	lib/arena.c \
+	lib/arena.h \
 	lib/actions.c \
 	lib/chassis-index.c \
 	lib/chassis-index.h \
@@ -47,6 +49,10 @@ lib_libovn_la_SOURCES = \
 	lib/static-mac-binding-index.c \
 	lib/static-mac-binding-index.h \
 	lib/stopwatch-names.h \
+	lib/sparse-bitmap.c \
+	lib/sparse-bitmap.h \
+	lib/string-pool.c \
+	lib/string-pool.h \
 	lib/vif-plug-provider.h \
 	lib/vif-plug-provider.c \
 	lib/vif-plug-providers/dummy/vif-plug-dummy.c
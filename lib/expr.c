@@ -15,6 +15,7 @@
  */
 
 #include <config.h>
+#include "arena.h"
 #include "bitmap.h"
 #include "byte-order.h"
 #include "hmapx.h"
@@ -25,6 +26,8 @@
 #include "openvswitch/ofp-actions.h"
 #include "openvswitch/shash.h"
 #include "openvswitch/vlog.h"
+#include "ovs-atomic.h"
+#include "ovs-thread.h"
 #include "ovn-util.h"
 #include "ovn/expr.h"
 #include "ovn/lex.h"
@@ -35,7 +38,8 @@
 
 VLOG_DEFINE_THIS_MODULE(expr);
 
-static struct expr *parse_and_annotate(const char *s,
+static struct expr *expr_symbol_expand(const struct expr_symbol *,
+                                       bool predicate,
                                        const struct shash *symtab,
                                        struct sset *nesting,
                                        char **errorp);
@@ -141,6 +145,55 @@ expr_relop_test(enum expr_relop relop, int cmp)
 
 /* Constructing and manipulating expressions. */
 
+/* The arena that the expressions created by the current thread are allocated
+ * from, if any.  See expr_arena_set(). */
+DEFINE_STATIC_PER_THREAD_DATA(struct arena *, expr_arena, NULL);
+
+/* Makes the expressions that the calling thread creates from now on be
+ * allocated from 'arena', or from the heap if 'arena' is NULL, and returns
+ * the previous arena of the thread.
+ *
+ * Allocating from an arena saves the many small allocations and frees of the
+ * nodes that parsing, annotating and normalizing an expression creates and
+ * destroys: expr_destroy() doesn't free the nodes from an arena, they are
+ * all released together by arena_reset().  The caller must make sure that no
+ * expression from 'arena' is used after that, e.g., by cloning the ones it
+ * keeps longer with the arena unset.  Expressions from an arena and from
+ * the heap may be combined freely. */
+struct arena *
+expr_arena_set(struct arena *arena)
+{
+    struct arena **cur = expr_arena_get();
+    struct arena *old = *cur;
+
+    *cur = arena;
+    return old;
+}
+
+/* Returns a new zeroed expression node. */
+static struct expr *
+expr_alloc(void)
+{
+    struct arena *arena = *expr_arena_get();
+    struct expr *e;
+
+    if (arena) {
+        e = arena_zalloc(arena, sizeof *e);
+        e->in_arena = true;
+    } else {
+        e = xzalloc(sizeof *e);
+    }
+    return e;
+}
+
+/* Returns a copy of 's' to be owned by 'e', which must have just been
+ * allocated by expr_alloc(). */
+static char *
+expr_strdup(const struct expr *e, const char *s)
+{
+    return e->in_arena ? arena_strdup(*expr_arena_get(), s) : xstrdup(s);
+}
+
 /* Creates and returns a logical AND or OR expression (according to 'type',
  * which must be EXPR_T_AND or EXPR_T_OR) that initially has no
  * sub-expressions.  (To satisfy the invariants for expressions, the caller
@@ -149,7 +202,7 @@ expr_relop_test(enum expr_relop relop, int cmp)
 struct expr *
 expr_create_andor(enum expr_type type)
 {
-    struct expr *e = xzalloc(sizeof *e);
+    struct expr *e = expr_alloc();
     e->type = type;
     ovs_list_init(&e->andor);
     return e;
@@ -212,7 +265,7 @@ expr_insert_andor(struct expr *andor, struct ovs_list *before,
 struct expr *
 expr_create_boolean(bool b)
 {
-    struct expr *e = xzalloc(sizeof *e);
+    struct expr *e = expr_alloc();
     e->type = EXPR_T_BOOLEAN;
     e->boolean = b;
     return e;
@@ -521,7 +574,7 @@ static struct expr *
 make_cmp__(const struct expr_field *f, enum expr_relop r,
              const struct expr_constant *c)
 {
-    struct expr *e = xzalloc(sizeof *e);
+    struct expr *e = expr_alloc();
     e->type = EXPR_T_CMP;
     e->cmp.symbol = f->symbol;
     e->cmp.relop = r;
@@ -539,7 +592,7 @@ make_cmp__(const struct expr_field *f, enum expr_relop r,
                         f->n_bits);
         }
     } else {
-        e->cmp.string = xstrdup(c->string);
+        e->cmp.string = expr_strdup(e, c->string);
     }
     return e;
 }
@@ -1142,6 +1195,233 @@ expr_constant_set_add_value(struct expr_constant_set **p_cs,
     cs->values[cs->n_values++] = *c;
 }
 
+/* A CIDR prefix of an IPv4 or IPv6 constant, in host byte order. */
+struct expr_cidr {
+    ovs_u128 addr;
+    unsigned int plen;
+};
+
+/* Returns a 128-bit value with the 'n' least significant bits set. */
+static ovs_u128
+expr_u128_low_ones(unsigned int n)
+{
+    ovs_u128 x;
+
+    x.u64.lo = n >= 64 ? UINT64_MAX : (UINT64_C(1) << n) - 1;
+    x.u64.hi = (n >= 128 ? UINT64_MAX
+                : n > 64 ? (UINT64_C(1) << (n - 64)) - 1
+                : 0);
+    return x;
+}
+
+/* Returns the mask of a 'plen' bits long prefix of a 'width' bits address. */
+static ovs_u128
+expr_u128_prefix_mask(unsigned int width, unsigned int plen)
+{
+    ovs_u128 all = expr_u128_low_ones(width);
+    ovs_u128 host = expr_u128_low_ones(width - plen);
+
+    return (ovs_u128) { .u64 = { .lo = all.u64.lo & ~host.u64.lo,
+                                 .hi = all.u64.hi & ~host.u64.hi } };
+}
+
+static ovs_u128
+expr_u128_from_subvalue(const union mf_subvalue *sv, unsigned int width)
+{
+    ovs_u128 x;
+
+    if (width == 32) {
+        x.u64.hi = 0;
+        x.u64.lo = ntohl(sv->ipv4);
+    } else {
+        ovs_be64 be[2];
+
+        memcpy(be, &sv->ipv6, sizeof be);
+        x.u64.hi = ntohll(be[0]);
+        x.u64.lo = ntohll(be[1]);
+    }
+    return x;
+}
+
+static void
+expr_u128_to_subvalue(ovs_u128 x, unsigned int width, union mf_subvalue *sv)
+{
+    memset(sv, 0, sizeof *sv);
+    if (width == 32) {
+        sv->ipv4 = htonl(x.u64.lo);
+    } else {
+        ovs_be64 be[2] = { htonll(x.u64.hi), htonll(x.u64.lo) };
+
+        memcpy(&sv->ipv6, be, sizeof be);
+    }
+}
+
+/* Converts 'c', an IPv4 or IPv6 constant of 'width' bits, to a CIDR prefix.
+ * Returns false if 'c' has a mask that isn't a prefix mask. */
+static bool
+expr_cidr_from_constant(const struct expr_constant *c, unsigned int width,
+                        struct expr_cidr *cidr)
+{
+    cidr->addr = expr_u128_from_subvalue(&c->value, width);
+    cidr->plen = width;
+    if (c->masked) {
+        ovs_u128 mask = expr_u128_from_subvalue(&c->mask, width);
+
+        cidr->plen = count_1bits(mask.u64.hi) + count_1bits(mask.u64.lo);
+        if (!ovs_u128_equals(mask, expr_u128_prefix_mask(width,
+                                                         cidr->plen))) {
+            return false;
+        }
+        cidr->addr.u64.hi &= mask.u64.hi;
+        cidr->addr.u64.lo &= mask.u64.lo;
+    }
+    return true;
+}
+
+static int
+compare_expr_cidr_cb(const void *a_, const void *b_)
+{
+    const struct expr_cidr *a = a_;
+    const struct expr_cidr *b = b_;
+
+    if (a->addr.u64.hi != b->addr.u64.hi) {
+        return a->addr.u64.hi < b->addr.u64.hi ? -1 : 1;
+    } else if (a->addr.u64.lo != b->addr.u64.lo) {
+        return a->addr.u64.lo < b->addr.u64.lo ? -1 : 1;
+    }
+    return a->plen < b->plen ? -1 : a->plen > b->plen;
+}
+
+/* Returns true if prefix 'a' contains prefix 'b'. */
+static bool
+expr_cidr_contains(const struct expr_cidr *a, const struct expr_cidr *b,
+                   unsigned int width)
+{
+    ovs_u128 mask = expr_u128_prefix_mask(width, a->plen);
+
+    return (a->plen <= b->plen
+            && (b->addr.u64.hi & mask.u64.hi) == a->addr.u64.hi
+            && (b->addr.u64.lo & mask.u64.lo) == a->addr.u64.lo);
+}
+
+/* Returns true if prefixes 'a' and 'b', with 'a' < 'b', are the two halves
+ * of a prefix one bit shorter. */
+static bool
+expr_cidr_are_siblings(const struct expr_cidr *a, const struct expr_cidr *b,
+                       unsigned int width)
+{
+    if (a->plen != b->plen || !a->plen) {
+        return false;
+    }
+
+    ovs_u128 bit = expr_u128_low_ones(width - a->plen + 1);
+    ovs_u128 host = expr_u128_low_ones(width - a->plen);
+    bit.u64.hi &= ~host.u64.hi;
+    bit.u64.lo &= ~host.u64.lo;
+
+    return ((a->addr.u64.hi ^ b->addr.u64.hi) == bit.u64.hi
+            && (a->addr.u64.lo ^ b->addr.u64.lo) == bit.u64.lo
+            && !(a->addr.u64.hi & bit.u64.hi)
+            && !(a->addr.u64.lo & bit.u64.lo));
+}
+
+/* Replaces the 'n' prefixes in 'cidrs' by the smallest list of prefixes that
+ * covers exactly the same addresses.  Returns the new number of prefixes. */
+static size_t
+expr_cidrs_aggregate(struct expr_cidr *cidrs, size_t n, unsigned int width)
+{
+    size_t n_out = 0;
+
+    qsort(cidrs, n, sizeof *cidrs, compare_expr_cidr_cb);
+    for (size_t i = 0; i < n; i++) {
+        /* The prefixes are sorted by address, so only the last one kept can
+         * contain 'cidrs[i]'. */
+        if (n_out && expr_cidr_contains(&cidrs[n_out - 1], &cidrs[i],
+                                        width)) {
+            continue;
+        }
+        cidrs[n_out++] = cidrs[i];
+        while (n_out >= 2 && expr_cidr_are_siblings(&cidrs[n_out - 2],
+                                                    &cidrs[n_out - 1],
+                                                    width)) {
+            cidrs[n_out - 2].plen--;
+            n_out--;
+        }
+    }
+    return n_out;
+}
+
+/* Aggregates the IPv4 and IPv6 addresses and CIDR prefixes in integer
+ * constant set 'cs' into the smallest list of prefixes that matches exactly
+ * the same addresses, e.g., {10.0.0.0, 10.0.0.1, 10.0.0.2/31} becomes
+ * {10.0.0.0/30}.  The other constants are kept as they are.  'cs' stays
+ * sorted, as expr_constant_set_integers_diff() requires. */
+void
+expr_constant_set_aggregate(struct expr_constant_set *cs)
+{
+    static const struct {
+        enum lex_format format;
+        unsigned int width;
+    } families[] = {
+        { LEX_F_IPV4, 32 },
+        { LEX_F_IPV6, 128 },
+    };
+
+    if (cs->type != EXPR_C_INTEGER || cs->n_values < 2) {
+        return;
+    }
+
+    struct expr_cidr *cidrs = xmalloc(cs->n_values * sizeof *cidrs);
+    struct expr_constant *values = xmalloc(cs->n_values * sizeof *values);
+    size_t n_values = 0;
+    bool *aggregated = xzalloc(cs->n_values * sizeof *aggregated);
+
+    for (size_t f = 0; f < ARRAY_SIZE(families); f++) {
+        unsigned int width = families[f].width;
+        size_t n_cidrs = 0;
+
+        for (size_t i = 0; i < cs->n_values; i++) {
+            const struct expr_constant *c = &cs->values[i];
+
+            if (c->format == families[f].format
+                && expr_cidr_from_constant(c, width, &cidrs[n_cidrs])) {
+                aggregated[i] = true;
+                n_cidrs++;
+            }
+        }
+
+        n_cidrs = expr_cidrs_aggregate(cidrs, n_cidrs, width);
+        for (size_t i = 0; i < n_cidrs; i++) {
+            struct expr_constant *c = &values[n_values++];
+
+            memset(c, 0, sizeof *c);
+            c->format = families[f].format;
+            expr_u128_to_subvalue(cidrs[i].addr, width, &c->value);
+            if (cidrs[i].plen < width) {
+                c->masked = true;
+                expr_u128_to_subvalue(
+                    expr_u128_prefix_mask(width, cidrs[i].plen), width,
+                    &c->mask);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < cs->n_values; i++) {
+        if (!aggregated[i]) {
+            values[n_values++] = cs->values[i];
+        }
+    }
+
+    free(cs->values);
+    cs->values = values;
+    cs->n_values = n_values;
+    qsort(cs->values, cs->n_values, sizeof *cs->values,
+          compare_expr_constant_integer_cb);
+
+    free(aggregated);
+    free(cidrs);
+}
+
 /* Find the differences between old and new. Both old and new must be integer
  * type and must be sorted (which is true if they are generated by
  * expr_constant_set_create_integers() or expr_const_sets_add_integers().
@@ -1278,11 +1558,11 @@ parse_chassis_resident(struct expr_context *ctx)
         return NULL;
     }
 
-    struct expr *e = xzalloc(sizeof *e);
+    struct expr *e = expr_alloc();
     e->type = EXPR_T_CONDITION;
     e->cond.type = EXPR_COND_CHASSIS_RESIDENT;
     e->cond.not = false;
-    e->cond.string = xstrdup(ctx->lexer->token.s);
+    e->cond.string = expr_strdup(e, ctx->lexer->token.s);
 
     lexer_get(ctx->lexer);
     if (!lexer_force_match(ctx->lexer, LEX_T_RPAREN)) {
@@ -1558,7 +1838,7 @@ expr_field_parse(struct lexer *lexer, const struct shash *symtab,
             if (symbol->prereqs) {
                 char *error;
                 struct sset nesting = SSET_INITIALIZER(&nesting);
-                struct expr *e = parse_and_annotate(symbol->prereqs, symtab,
+                struct expr *e = expr_symbol_expand(symbol, false, symtab,
                                                     &nesting, &error);
                 sset_destroy(&nesting);
                 if (error) {
@@ -1811,23 +2091,40 @@ expr_symtab_destroy(struct shash *symtab)
 
     SHASH_FOR_EACH_SAFE (node, symtab) {
         struct expr_symbol *symbol = node->data;
+        struct expr *prereqs_expr, *predicate_expr;
 
         shash_delete(symtab, node);
         free(symbol->name);
         free(symbol->prereqs);
         free(symbol->predicate);
+        atomic_read_relaxed(&symbol->prereqs_expr, &prereqs_expr);
+        atomic_read_relaxed(&symbol->predicate_expr, &predicate_expr);
+        expr_destroy(prereqs_expr);
+        expr_destroy(predicate_expr);
         free(symbol);
     }
 }
 
 /* Cloning. */
 
+/* Returns a shallow copy of 'expr', allocated by expr_alloc(). */
+static struct expr *
+expr_dup(const struct expr *expr)
+{
+    struct expr *new = expr_alloc();
+    bool in_arena = new->in_arena;
+
+    *new = *expr;
+    new->in_arena = in_arena;
+    return new;
+}
+
 static struct expr *
 expr_clone_cmp(struct expr *expr)
 {
-    struct expr *new = xmemdup(expr, sizeof *expr);
+    struct expr *new = expr_dup(expr);
     if (!new->cmp.symbol->width) {
-        new->cmp.string = xstrdup(new->cmp.string);
+        new->cmp.string = expr_strdup(new, new->cmp.string);
     }
     return new;
 }
@@ -1848,8 +2145,8 @@ expr_clone_andor(struct expr *expr)
 static struct expr *
 expr_clone_condition(struct expr *expr)
 {
-    struct expr *new = xmemdup(expr, sizeof *expr);
-    new->cond.string = xstrdup(new->cond.string);
+    struct expr *new = expr_dup(expr);
+    new->cond.string = expr_strdup(new, new->cond.string);
     return new;
 }
 
@@ -1875,7 +2172,8 @@ expr_clone(struct expr *expr)
     OVS_NOT_REACHED();
 }
 
-/* Destroys 'expr' and all of the sub-expressions it references. */
+/* Destroys 'expr' and all of the sub-expressions it references.  The nodes
+ * allocated from an arena are only released with the arena. */
 void
 expr_destroy(struct expr *expr)
 {
@@ -1887,7 +2185,7 @@ expr_destroy(struct expr *expr)
 
     switch (expr->type) {
     case EXPR_T_CMP:
-        if (!expr->cmp.symbol->width) {
+        if (!expr->cmp.symbol->width && !expr->in_arena) {
             free(expr->cmp.string);
         }
         break;
@@ -1904,10 +2202,14 @@ expr_destroy(struct expr *expr)
         break;
 
     case EXPR_T_CONDITION:
-        free(expr->cond.string);
+        if (!expr->in_arena) {
+            free(expr->cond.string);
+        }
         break;
     }
-    free(expr);
+    if (!expr->in_arena) {
+        free(expr);
+    }
 }
 
 /* Annotation. */
@@ -1937,6 +2239,56 @@ parse_and_annotate(const char *s, const struct shash *symtab,
     return expr;
 }
 
+/* Returns the annotated expansion of 'symbol''s predicate, if 'predicate' is
+ * true, or of its prerequisites otherwise, which must not be NULL.
+ *
+ * The same symbols are expanded over and over, e.g. "ip4" for every match on
+ * an IPv4 field, so the first successful expansion of each symbol is kept in
+ * the symbol and later expansions just clone it.  An expansion that succeeds
+ * once always succeeds, regardless of 'nesting', because a recursive
+ * expansion fails in any context.  This may run concurrently in multiple
+ * threads for the same symbol, the thread that loses the race to store its
+ * expansion destroys it.
+ *
+ * The expansion is only kept in symbols owned by 'symtab', which is where the
+ * writable symbol comes from. */
+static struct expr *
+expr_symbol_expand(const struct expr_symbol *symbol, bool predicate,
+                   const struct shash *symtab, struct sset *nesting,
+                   char **errorp)
+{
+    const char *s = predicate ? symbol->predicate : symbol->prereqs;
+    struct expr_symbol *owned = shash_find_data(symtab, symbol->name);
+    if (owned != symbol) {
+        return parse_and_annotate(s, symtab, nesting, errorp);
+    }
+
+    ATOMIC(struct expr *) *slot = (predicate ? &owned->predicate_expr
+                                             : &owned->prereqs_expr);
+    struct expr *cached;
+
+    atomic_read_explicit(slot, &cached, memory_order_acquire);
+    if (!cached) {
+        /* The cached expansion outlives the arena of the caller, if any. */
+        struct arena *arena = expr_arena_set(NULL);
+        struct expr *expr = parse_and_annotate(s, symtab, nesting, errorp);
+        expr_arena_set(arena);
+        if (!expr) {
+            return NULL;
+        }
+        if (atomic_compare_exchange_strong_explicit(slot, &cached, expr,
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire)) {
+            cached = expr;
+        } else {
+            expr_destroy(expr);
+        }
+    }
+
+    *errorp = NULL;
+    return expr_clone(cached);
+}
+
 static struct expr *
 expr_annotate_cmp(struct expr *expr, const struct shash *symtab,
                   bool append_prereqs, struct sset *nesting, char **errorp)
@@ -1952,7 +2304,7 @@ expr_annotate_cmp(struct expr *expr, const struct shash *symtab,
 
     struct expr *prereqs = NULL;
     if (append_prereqs && symbol->prereqs) {
-        prereqs = parse_and_annotate(symbol->prereqs, symtab, nesting, errorp);
+        prereqs = expr_symbol_expand(symbol, false, symtab, nesting, errorp);
         if (!prereqs) {
             goto error;
         }
@@ -1965,8 +2317,8 @@ expr_annotate_cmp(struct expr *expr, const struct shash *symtab,
     } else if (symbol->predicate) {
         struct expr *predicate;
 
-        predicate = parse_and_annotate(symbol->predicate, symtab,
-                                       nesting, errorp);
+        predicate = expr_symbol_expand(symbol, true, symtab, nesting,
+                                       errorp);
         if (!predicate) {
             goto error;
         }
@@ -2001,7 +2353,7 @@ expr_append_prereqs(struct expr *expr, const struct expr_symbol *symbol,
     struct expr *prereqs = NULL;
 
     if (symbol->prereqs) {
-        prereqs = parse_and_annotate(symbol->prereqs, symtab, nesting, errorp);
+        prereqs = expr_symbol_expand(symbol, false, symtab, nesting, errorp);
         if (!prereqs) {
             expr_destroy(expr);
             return NULL;
@@ -2136,7 +2488,7 @@ expr_simplify_ne(struct expr *expr)
     for (i = 0; (i = bitwise_scan(mask, sizeof *mask, true, i, w)) < w; i++) {
         struct expr *e;
 
-        e = xzalloc(sizeof *e);
+        e = expr_alloc();
         e->type = EXPR_T_CMP;
         e->cmp.symbol = expr->cmp.symbol;
         e->cmp.relop = EXPR_R_EQ;
@@ -2480,11 +2832,11 @@ crush_and_string(struct expr *expr, const struct expr_symbol *symbol)
 
     const char *string;
     SSET_FOR_EACH (string, &result) {
-        sub = xzalloc(sizeof *sub);
+        sub = expr_alloc();
         sub->type = EXPR_T_CMP;
         sub->cmp.relop = EXPR_R_EQ;
         sub->cmp.symbol = symbol;
-        sub->cmp.string = xstrdup(string);
+        sub->cmp.string = expr_strdup(sub, string);
         ovs_list_push_back(&expr->andor, &sub->node);
     }
     sset_destroy(&result);
@@ -2729,7 +3081,7 @@ crush_and_numeric(struct expr *expr, const struct expr_symbol *symbol)
             return expr_create_boolean(true);
         } else {
             struct expr *cmp;
-            cmp = xzalloc(sizeof *cmp);
+            cmp = expr_alloc();
             cmp->type = EXPR_T_CMP;
             cmp->cmp.symbol = symbol;
             cmp->cmp.relop = EXPR_R_EQ;
@@ -2744,7 +3096,7 @@ crush_and_numeric(struct expr *expr, const struct expr_symbol *symbol)
         struct expr *disjuncts = expr_from_node(ovs_list_pop_front(&expr->andor));
         struct expr *or;
 
-        or = xzalloc(sizeof *or);
+        or = expr_alloc();
         or->type = EXPR_T_OR;
         ovs_list_init(&or->andor);
 
@@ -2780,7 +3132,7 @@ crush_and_numeric(struct expr *expr, const struct expr_symbol *symbol)
         struct expr *new = NULL;
         struct expr *or;
 
-        or = xzalloc(sizeof *or);
+        or = expr_alloc();
         or->type = EXPR_T_OR;
         ovs_list_init(&or->andor);
 
@@ -2799,7 +3151,7 @@ crush_and_numeric(struct expr *expr, const struct expr_symbol *symbol)
             LIST_FOR_EACH (b, node, &bs->andor) {
                 ovs_assert(b->type == EXPR_T_CMP);
                 if (!new) {
-                    new = xzalloc(sizeof *new);
+                    new = expr_alloc();
                     new->type = EXPR_T_CMP;
                     new->cmp.symbol = symbol;
                     new->cmp.relop = EXPR_R_EQ;
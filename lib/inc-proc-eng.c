@@ -21,18 +21,31 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#include "arena.h"
+#include "coverage.h"
 #include "lib/util.h"
 #include "openvswitch/dynamic-string.h"
 #include "openvswitch/hmap.h"
+#include "openvswitch/json.h"
 #include "openvswitch/poll-loop.h"
 #include "openvswitch/vlog.h"
 #include "inc-proc-eng.h"
+#include "ovs-thread.h"
+#include "simap.h"
 #include "timeval.h"
 #include "unixctl.h"
 
 VLOG_DEFINE_THIS_MODULE(inc_proc_eng);
 
+COVERAGE_DEFINE(engine_recompute_forced);
+COVERAGE_DEFINE(engine_recompute_missing_handler);
+COVERAGE_DEFINE(engine_recompute_failed_handler);
+COVERAGE_DEFINE(engine_run_yield);
+COVERAGE_DEFINE(engine_run_resume);
+COVERAGE_DEFINE(engine_run_abandon);
+
 static bool engine_force_recompute = false;
 static bool engine_run_canceled = false;
 static const struct engine_context *engine_context;
@@ -40,18 +53,87 @@ static const struct engine_context *engine_context;
 static struct engine_node **engine_nodes;
 static size_t engine_n_nodes;
 
+/* Worker threads that run thread safe nodes in parallel with the thread
+ * calling engine_run().  During a parallel run, the thread safe nodes whose
+ * inputs all ran are in 'engine_pool_ready' and the other nodes whose
+ * inputs all ran are in 'engine_pool_serial', which only the thread calling
+ * engine_run() takes from. */
+static struct ovs_mutex engine_pool_mutex = OVS_MUTEX_INITIALIZER;
+static pthread_cond_t engine_pool_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t engine_pool_done_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t *engine_pool_threads;
+static size_t engine_pool_n_threads;
+static bool engine_pool_exiting OVS_GUARDED_BY(engine_pool_mutex);
+static struct engine_node **engine_pool_ready
+    OVS_GUARDED_BY(engine_pool_mutex);
+static size_t engine_pool_n_ready OVS_GUARDED_BY(engine_pool_mutex);
+static struct engine_node **engine_pool_serial
+    OVS_GUARDED_BY(engine_pool_mutex);
+static size_t engine_pool_n_serial OVS_GUARDED_BY(engine_pool_mutex);
+static size_t engine_pool_next_serial OVS_GUARDED_BY(engine_pool_mutex);
+static size_t engine_pool_n_running OVS_GUARDED_BY(engine_pool_mutex);
+static size_t engine_pool_n_left OVS_GUARDED_BY(engine_pool_mutex);
+
+/* Serializes the writes of thread safe nodes to the IDL transactions. */
+static struct ovs_mutex engine_txn_mutex = OVS_MUTEX_INITIALIZER;
+
+/* Number of engine runs kept for inc-engine/dump-trace. */
+#define ENGINE_TRACE_N_RUNS 100
+
+/* A node run that recomputed or computed the node. */
+struct engine_trace_event {
+    const struct engine_node *node;
+    bool recompute;
+    unsigned int tid;               /* ovsthread_id_self() of the runner. */
+    long long int start_usec;
+    long long int duration_usec;
+};
+
+struct engine_trace_run {
+    uint64_t seqno;                 /* 0 if the slot was never used. */
+    struct engine_trace_event *events;
+    size_t n_events;
+    size_t allocated_events;
+};
+
+/* Ring of the last ENGINE_TRACE_N_RUNS engine runs, run 'seqno' is stored
+ * at index 'seqno' % ENGINE_TRACE_N_RUNS. */
+static struct ovs_mutex engine_trace_mutex = OVS_MUTEX_INITIALIZER;
+static struct engine_trace_run engine_trace_runs[ENGINE_TRACE_N_RUNS]
+    OVS_GUARDED_BY(engine_trace_mutex);
+static uint64_t engine_trace_seqno OVS_GUARDED_BY(engine_trace_mutex);
+
 static const char *engine_node_state_name[EN_STATE_MAX] = {
     [EN_STALE]     = "Stale",
     [EN_UPDATED]   = "Updated",
     [EN_UNCHANGED] = "Unchanged",
     [EN_CANCELED]   = "Canceled",
+    [EN_SUSPENDED] = "Suspended",
 };
 
+/* Cooperative time slicing, see engine_set_time_slice().  The node that
+ * yielded is 'engine_suspended_node', 0 'engine_time_slice_msec' disables
+ * time slicing. */
+static long long int engine_time_slice_msec;
+static long long int engine_run_start_msec;
+static bool engine_time_slice_paused;
+static struct engine_node *engine_suspended_node;
+static size_t engine_suspended_input_idx;
+static bool engine_suspended_forced;
+static struct engine_node *engine_resuming_node;
+
+/* True if engine_init_run() kept the suspended run and no engine_run()
+ * processed the changes of the current iteration yet. */
+static bool engine_suspended_pending;
+
 static long long engine_compute_log_timeout_msec = 500;
 
-static void
-engine_recompute(struct engine_node *node, bool allowed,
-                 const char *reason_fmt, ...) OVS_PRINTF_FORMAT(3, 4);
+/* 'input_idx' argument of engine_recompute() for forced recomputes. */
+#define ENGINE_RECOMPUTE_FORCED SIZE_MAX
+
+static void engine_recompute(struct engine_node *node, bool allowed,
+                             size_t input_idx);
+static void engine_run_node(struct engine_node *, bool recompute_allowed);
 
 void
 engine_set_force_recompute(bool val)
@@ -111,6 +193,110 @@ engine_get_nodes(struct engine_node *node, size_t *n_count)
     return engine_topo_sort(node, NULL, n_count, &n_size);
 }
 
+/* Sets the outputs of all the nodes. */
+static void
+engine_set_outputs(void)
+{
+    for (size_t i = 0; i < engine_n_nodes; i++) {
+        struct engine_node *node = engine_nodes[i];
+
+        for (size_t j = 0; j < node->n_inputs; j++) {
+            struct engine_node *input = node->inputs[j].node;
+
+            input->outputs = xrealloc(input->outputs,
+                                      (input->n_outputs + 1)
+                                      * sizeof *input->outputs);
+            input->outputs[input->n_outputs++] = node;
+        }
+    }
+}
+
+static void
+engine_latency_hist_add(struct engine_latency_hist *hist, uint64_t usec)
+{
+    size_t bucket = usec ? MIN((size_t) log_2_floor(usec) + 1,
+                               ENGINE_LATENCY_N_BUCKETS - 1)
+                         : 0;
+
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->max_usec = MAX(hist->max_usec, usec);
+}
+
+/* Returns an upper bound of the 'pct' percentile of the latencies in
+ * 'hist', in microseconds. */
+static uint64_t
+engine_latency_hist_percentile(const struct engine_latency_hist *hist,
+                               unsigned int pct)
+{
+    uint64_t target = DIV_ROUND_UP(hist->count * pct, 100);
+    uint64_t n = 0;
+
+    for (size_t i = 0; i < ENGINE_LATENCY_N_BUCKETS - 1; i++) {
+        n += hist->buckets[i];
+        if (n && n >= target) {
+            return MIN(i ? (UINT64_C(1) << i) - 1 : 0, hist->max_usec);
+        }
+    }
+    return hist->max_usec;
+}
+
+static void
+engine_latency_hist_format(struct ds *s, const char *name,
+                           const struct engine_latency_hist *hist)
+{
+    ds_put_format(s, "- %-10s count: %12"PRIu64"  p50: %10"PRIu64"us  "
+                  "p99: %10"PRIu64"us  max: %10"PRIu64"us\n",
+                  name, hist->count,
+                  engine_latency_hist_percentile(hist, 50),
+                  engine_latency_hist_percentile(hist, 99),
+                  hist->max_usec);
+}
+
+static void
+engine_trace_start_run(void)
+{
+    ovs_mutex_lock(&engine_trace_mutex);
+    struct engine_trace_run *run =
+        &engine_trace_runs[++engine_trace_seqno % ENGINE_TRACE_N_RUNS];
+    run->seqno = engine_trace_seqno;
+    run->n_events = 0;
+    ovs_mutex_unlock(&engine_trace_mutex);
+}
+
+static void
+engine_trace_add_event(const struct engine_node *node, bool recompute,
+                       long long int start_usec, long long int duration_usec)
+{
+    ovs_mutex_lock(&engine_trace_mutex);
+    struct engine_trace_run *run =
+        &engine_trace_runs[engine_trace_seqno % ENGINE_TRACE_N_RUNS];
+    if (run->n_events == run->allocated_events) {
+        run->events = x2nrealloc(run->events, &run->allocated_events,
+                                 sizeof *run->events);
+    }
+    run->events[run->n_events++] = (struct engine_trace_event) {
+        .node = node,
+        .recompute = recompute,
+        .tid = ovsthread_id_self(),
+        .start_usec = start_usec,
+        .duration_usec = duration_usec,
+    };
+    ovs_mutex_unlock(&engine_trace_mutex);
+}
+
+static void
+engine_trace_destroy(void)
+{
+    ovs_mutex_lock(&engine_trace_mutex);
+    for (size_t i = 0; i < ENGINE_TRACE_N_RUNS; i++) {
+        free(engine_trace_runs[i].events);
+        memset(&engine_trace_runs[i], 0, sizeof engine_trace_runs[i]);
+    }
+    engine_trace_seqno = 0;
+    ovs_mutex_unlock(&engine_trace_mutex);
+}
+
 static void
 engine_clear_stats(struct unixctl_conn *conn, int argc OVS_UNUSED,
                    const char *argv[] OVS_UNUSED, void *arg OVS_UNUSED)
@@ -119,10 +305,54 @@ engine_clear_stats(struct unixctl_conn *conn, int argc OVS_UNUSED,
         struct engine_node *node = engine_nodes[i];
 
         memset(&node->stats, 0, sizeof node->stats);
+        memset(node->input_recompute_causes, 0,
+               node->n_inputs * sizeof *node->input_recompute_causes);
     }
     unixctl_command_reply(conn, NULL);
 }
 
+static void
+engine_format_recompute_cause(struct ds *s, const char *reason,
+                              const char *input_name,
+                              const struct engine_recompute_cause *cause)
+{
+    if (cause->count) {
+        ds_put_format(s, "%s%s: %"PRIu64" recomputes, %"PRIu64"ms\n",
+                      reason, input_name, cause->count,
+                      cause->cost_usec / 1000);
+    }
+}
+
+/* Formats the number of recomputes of 'node' and the time they took by
+ * cause, skipping the causes that never triggered a recompute. */
+static void
+engine_format_recompute_causes(struct ds *s, const struct engine_node *node)
+{
+    engine_format_recompute_cause(s, "forced", "",
+                                  &node->stats.forced_recompute);
+    for (size_t i = 0; i < node->n_inputs; i++) {
+        const struct engine_node_input *input = &node->inputs[i];
+
+        engine_format_recompute_cause(s,
+                                      input->change_handler
+                                      ? "failed handler for input "
+                                      : "missing handler for input ",
+                                      input->node->name,
+                                      &node->input_recompute_causes[i]);
+    }
+}
+
+static void
+engine_format_memory(struct ds *s, const struct engine_node *node)
+{
+    if (node->arena) {
+        ds_put_format(s, "arena: %"PRIuSIZE" bytes in use, "
+                      "%"PRIuSIZE" bytes allocated\n",
+                      arena_bytes_in_use(node->arena),
+                      arena_bytes_allocated(node->arena));
+    }
+}
+
 static void
 engine_dump_stats(struct unixctl_conn *conn, int argc,
                   const char *argv[], void *arg OVS_UNUSED)
@@ -154,6 +384,10 @@ engine_dump_stats(struct unixctl_conn *conn, int argc,
                 ds_put_format(&dump, "%"PRIu64, node->stats.compute);
             } else if (!strcmp(dump_stat_type, "cancel")) {
                 ds_put_format(&dump, "%"PRIu64, node->stats.cancel);
+            } else if (!strcmp(dump_stat_type, "causes")) {
+                engine_format_recompute_causes(&dump, node);
+            } else if (!strcmp(dump_stat_type, "memory")) {
+                engine_format_memory(&dump, node);
             } else {
                 ds_put_format(&dump, "Invalid stat type : %s", dump_stat_type);
             }
@@ -172,6 +406,88 @@ engine_dump_stats(struct unixctl_conn *conn, int argc,
     ds_destroy(&dump);
 }
 
+static void
+engine_show_latency(struct unixctl_conn *conn, int argc,
+                    const char *argv[], void *arg OVS_UNUSED)
+{
+    struct ds dump = DS_EMPTY_INITIALIZER;
+    const char *dump_eng_node_name = (argc > 1 ? argv[1] : NULL);
+
+    for (size_t i = 0; i < engine_n_nodes; i++) {
+        struct engine_node *node = engine_nodes[i];
+
+        if (dump_eng_node_name && strcmp(node->name, dump_eng_node_name)) {
+            continue;
+        }
+
+        ds_put_format(&dump, "Node: %s\n", node->name);
+        engine_latency_hist_format(&dump, "recompute:",
+                                   &node->stats.recompute_latency);
+        engine_latency_hist_format(&dump, "compute:",
+                                   &node->stats.compute_latency);
+    }
+    unixctl_command_reply(conn, ds_cstr(&dump));
+    ds_destroy(&dump);
+}
+
+/* Replies with the node runs of the last engine runs, at most
+ * ENGINE_TRACE_N_RUNS, in the Chrome trace event format. */
+static void
+engine_dump_trace(struct unixctl_conn *conn, int argc,
+                  const char *argv[], void *arg OVS_UNUSED)
+{
+    unsigned int n_runs = ENGINE_TRACE_N_RUNS;
+
+    if (argc > 1 && (!str_to_uint(argv[1], 10, &n_runs) || !n_runs)) {
+        unixctl_command_reply_error(conn, "positive integer required");
+        return;
+    }
+    n_runs = MIN(n_runs, ENGINE_TRACE_N_RUNS);
+
+    struct json *events = json_array_create_empty();
+    long long int pid = getpid();
+
+    ovs_mutex_lock(&engine_trace_mutex);
+    uint64_t first = engine_trace_seqno >= n_runs
+                     ? engine_trace_seqno - n_runs + 1 : 1;
+    for (uint64_t seqno = first; seqno <= engine_trace_seqno; seqno++) {
+        const struct engine_trace_run *run =
+            &engine_trace_runs[seqno % ENGINE_TRACE_N_RUNS];
+
+        if (run->seqno != seqno) {
+            continue;
+        }
+        for (size_t i = 0; i < run->n_events; i++) {
+            const struct engine_trace_event *ev = &run->events[i];
+            struct json *event = json_object_create();
+            struct json *args = json_object_create();
+
+            json_object_put_string(event, "name", ev->node->name);
+            json_object_put_string(event, "cat",
+                                   ev->recompute ? "recompute" : "compute");
+            json_object_put_string(event, "ph", "X");
+            json_object_put(event, "ts", json_integer_create(ev->start_usec));
+            json_object_put(event, "dur",
+                            json_integer_create(ev->duration_usec));
+            json_object_put(event, "pid", json_integer_create(pid));
+            json_object_put(event, "tid", json_integer_create(ev->tid));
+            json_object_put(args, "run", json_integer_create(seqno));
+            json_object_put(event, "args", args);
+            json_array_add(events, event);
+        }
+    }
+    ovs_mutex_unlock(&engine_trace_mutex);
+
+    struct json *trace = json_object_create();
+    json_object_put(trace, "traceEvents", events);
+    json_object_put_string(trace, "displayTimeUnit", "ms");
+
+    char *reply = json_to_string(trace, JSSF_SORT);
+    unixctl_command_reply(conn, reply);
+    free(reply);
+    json_destroy(trace);
+}
+
 static void
 engine_trigger_recompute_cmd(struct unixctl_conn *conn, int argc OVS_UNUSED,
                              const char *argv[] OVS_UNUSED,
@@ -199,8 +515,12 @@ void
 engine_init(struct engine_node *node, struct engine_arg *arg)
 {
     engine_nodes = engine_get_nodes(node, &engine_n_nodes);
+    engine_set_outputs();
 
     for (size_t i = 0; i < engine_n_nodes; i++) {
+        engine_nodes[i]->input_recompute_causes =
+            xcalloc(engine_nodes[i]->n_inputs,
+                    sizeof *engine_nodes[i]->input_recompute_causes);
         if (engine_nodes[i]->init) {
             engine_nodes[i]->data =
                 engine_nodes[i]->init(engine_nodes[i], arg);
@@ -213,6 +533,10 @@ engine_init(struct engine_node *node, struct engine_arg *arg)
                              engine_dump_stats, NULL);
     unixctl_command_register("inc-engine/clear-stats", "", 0, 0,
                              engine_clear_stats, NULL);
+    unixctl_command_register("inc-engine/show-latency", "[NODE]", 0, 1,
+                             engine_show_latency, NULL);
+    unixctl_command_register("inc-engine/dump-trace", "[N_RUNS]", 0, 1,
+                             engine_dump_trace, NULL);
     unixctl_command_register("inc-engine/recompute", "", 0, 0,
                              engine_trigger_recompute_cmd, NULL);
     unixctl_command_register("inc-engine/compute-log-timeout", "", 1, 1,
@@ -222,6 +546,8 @@ engine_init(struct engine_node *node, struct engine_arg *arg)
 void
 engine_cleanup(void)
 {
+    engine_set_n_threads(1);
+
     for (size_t i = 0; i < engine_n_nodes; i++) {
         if (engine_nodes[i]->clear_tracked_data) {
             engine_nodes[i]->clear_tracked_data(engine_nodes[i]->data);
@@ -231,10 +557,168 @@ engine_cleanup(void)
             engine_nodes[i]->cleanup(engine_nodes[i]->data);
         }
         free(engine_nodes[i]->data);
+        free(engine_nodes[i]->input_recompute_causes);
+        engine_nodes[i]->input_recompute_causes = NULL;
+        free(engine_nodes[i]->outputs);
+        engine_nodes[i]->outputs = NULL;
+        engine_nodes[i]->n_outputs = 0;
+        if (engine_nodes[i]->arena) {
+            arena_destroy(engine_nodes[i]->arena);
+            free(engine_nodes[i]->arena);
+            engine_nodes[i]->arena = NULL;
+        }
     }
     free(engine_nodes);
     engine_nodes = NULL;
     engine_n_nodes = 0;
+    engine_suspended_node = NULL;
+    engine_suspended_pending = false;
+
+    engine_trace_destroy();
+}
+
+void
+engine_set_node_thread_safe(struct engine_node *node)
+{
+    node->thread_safe = true;
+}
+
+void
+engine_txn_lock(void)
+    OVS_NO_THREAD_SAFETY_ANALYSIS
+{
+    ovs_mutex_lock(&engine_txn_mutex);
+}
+
+void
+engine_txn_unlock(void)
+    OVS_NO_THREAD_SAFETY_ANALYSIS
+{
+    ovs_mutex_unlock(&engine_txn_mutex);
+}
+
+struct arena *
+engine_node_enable_arena(struct engine_node *node)
+{
+    if (!node->arena) {
+        node->arena = xmalloc(sizeof *node->arena);
+        arena_init(node->arena);
+    }
+    return node->arena;
+}
+
+void
+engine_get_memory_usage(struct simap *usage)
+{
+    for (size_t i = 0; i < engine_n_nodes; i++) {
+        const struct engine_node *node = engine_nodes[i];
+
+        if (node->arena) {
+            char *name = xasprintf("engine-%s-arena-KB", node->name);
+            simap_increase(usage, name,
+                           ROUND_UP(arena_bytes_in_use(node->arena), 1024)
+                           / 1024);
+            free(name);
+        }
+    }
+}
+
+/* Thread safe nodes without inputs still run serially: they read the IDL
+ * change tracking. */
+static bool
+engine_node_runs_in_pool(const struct engine_node *node)
+{
+    return node->thread_safe && node->n_inputs;
+}
+
+/* Queues 'node', whose inputs all ran. */
+static void
+engine_pool_add_ready(struct engine_node *node)
+    OVS_REQUIRES(engine_pool_mutex)
+{
+    if (engine_node_runs_in_pool(node)) {
+        engine_pool_ready[engine_pool_n_ready++] = node;
+        xpthread_cond_signal(&engine_pool_work_cond);
+    } else {
+        engine_pool_serial[engine_pool_n_serial++] = node;
+    }
+}
+
+/* Runs 'node' and queues the outputs whose inputs all ran. */
+static void
+engine_pool_run_node(struct engine_node *node)
+    OVS_REQUIRES(engine_pool_mutex)
+{
+    engine_pool_n_running++;
+    ovs_mutex_unlock(&engine_pool_mutex);
+    engine_run_node(node, true);
+    ovs_mutex_lock(&engine_pool_mutex);
+    engine_pool_n_running--;
+    engine_pool_n_left--;
+
+    for (size_t i = 0; i < node->n_outputs; i++) {
+        struct engine_node *output = node->outputs[i];
+
+        if (!--output->n_pending_inputs) {
+            engine_pool_add_ready(output);
+        }
+    }
+    xpthread_cond_signal(&engine_pool_done_cond);
+}
+
+static void *
+engine_pool_worker(void *arg OVS_UNUSED)
+{
+    ovs_mutex_lock(&engine_pool_mutex);
+    while (!engine_pool_exiting) {
+        if (engine_pool_n_ready) {
+            engine_pool_run_node(engine_pool_ready[--engine_pool_n_ready]);
+        } else {
+            ovs_mutex_cond_wait(&engine_pool_work_cond, &engine_pool_mutex);
+        }
+    }
+    ovs_mutex_unlock(&engine_pool_mutex);
+
+    return NULL;
+}
+
+void
+engine_set_n_threads(size_t n_threads)
+{
+    size_t n_workers = n_threads ? n_threads - 1 : 0;
+
+    if (n_workers == engine_pool_n_threads) {
+        return;
+    }
+
+    if (engine_pool_n_threads) {
+        ovs_mutex_lock(&engine_pool_mutex);
+        engine_pool_exiting = true;
+        xpthread_cond_broadcast(&engine_pool_work_cond);
+        ovs_mutex_unlock(&engine_pool_mutex);
+
+        for (size_t i = 0; i < engine_pool_n_threads; i++) {
+            xpthread_join(engine_pool_threads[i], NULL);
+        }
+        free(engine_pool_threads);
+        engine_pool_threads = NULL;
+
+        ovs_mutex_lock(&engine_pool_mutex);
+        engine_pool_exiting = false;
+        ovs_mutex_unlock(&engine_pool_mutex);
+    }
+
+    engine_pool_n_threads = n_workers;
+    if (n_workers) {
+        engine_pool_threads = xmalloc(n_workers * sizeof *engine_pool_threads);
+        for (size_t i = 0; i < n_workers; i++) {
+            engine_pool_threads[i] = ovs_thread_create("inc_proc_eng",
+                                                       engine_pool_worker,
+                                                       NULL);
+        }
+    }
+    VLOG_INFO("Using %"PRIuSIZE" threads to run thread safe nodes",
+              n_workers + 1);
 }
 
 struct engine_node *
@@ -371,10 +855,9 @@ engine_get_internal_data(struct engine_node *node)
     return node->data;
 }
 
-void
-engine_init_run(void)
+static void
+engine_reset_nodes(void)
 {
-    VLOG_DBG("Initializing new run");
     for (size_t i = 0; i < engine_n_nodes; i++) {
         engine_set_node_state(engine_nodes[i], EN_STALE);
 
@@ -384,19 +867,65 @@ engine_init_run(void)
     }
 }
 
+/* Drops the partial results of the suspended run.  The next run recomputes
+ * all the nodes, without time slicing so that it makes progress. */
+static void
+engine_suspended_run_abandon(void)
+{
+    VLOG_DBG("node: %s, suspended run abandoned, recompute",
+             engine_suspended_node->name);
+    COVERAGE_INC(engine_run_abandon);
+    engine_suspended_node = NULL;
+    engine_suspended_forced = false;
+    engine_suspended_pending = false;
+    engine_reset_nodes();
+    engine_set_force_recompute(true);
+    engine_time_slice_paused = true;
+}
+
+void
+engine_init_run(void)
+{
+    /* A suspended run keeps the states and the tracked data of the nodes
+     * that already ran, the next engine_run() processes the new changes
+     * and resumes it.  If the last iteration didn't call engine_run(), its
+     * IDL changes are lost, so the suspended run can't be used anymore. */
+    if (engine_suspended_node) {
+        if (!engine_suspended_pending) {
+            VLOG_DBG("Keeping suspended run");
+            engine_suspended_pending = true;
+            return;
+        }
+        engine_suspended_run_abandon();
+        poll_immediate_wake();
+        return;
+    }
+
+    VLOG_DBG("Initializing new run");
+    engine_reset_nodes();
+}
+
 /* Do a full recompute (or at least try). If we're not allowed then
- * mark the node as "canceled".
+ * mark the node as "canceled".  The recompute is caused by the input at
+ * 'input_idx', which has no change handler or whose change handler
+ * failed, or is forced if 'input_idx' is ENGINE_RECOMPUTE_FORCED.
  */
 static void
-engine_recompute(struct engine_node *node, bool allowed,
-                 const char *reason_fmt, ...)
+engine_recompute(struct engine_node *node, bool allowed, size_t input_idx)
 {
-    char *reason = NULL;
-    va_list reason_args;
+    struct engine_recompute_cause *cause;
+    char *reason;
 
-    va_start(reason_args, reason_fmt);
-    reason = xvasprintf(reason_fmt, reason_args);
-    va_end(reason_args);
+    if (input_idx == ENGINE_RECOMPUTE_FORCED) {
+        cause = &node->stats.forced_recompute;
+        reason = xstrdup("forced");
+    } else {
+        cause = &node->input_recompute_causes[input_idx];
+        reason = xasprintf("%s handler for input %s",
+                           node->inputs[input_idx].change_handler
+                           ? "failed" : "missing",
+                           node->inputs[input_idx].node->name);
+    }
 
     if (!allowed) {
         VLOG_DBG("node: %s, recompute (%s) canceled", node->name, reason);
@@ -404,17 +933,37 @@ engine_recompute(struct engine_node *node, bool allowed,
         goto done;
     }
 
-    /* Clear tracked data before calling run() so that partially tracked data
-     * from some of the change handler executions are cleared. */
-    if (node->clear_tracked_data) {
-        node->clear_tracked_data(node->data);
+    bool resuming = engine_node_resuming(node);
+    if (!resuming) {
+        /* Clear tracked data before calling run() so that partially tracked
+         * data from some of the change handler executions are cleared. */
+        if (node->clear_tracked_data) {
+            node->clear_tracked_data(node->data);
+        }
+
+        if (input_idx == ENGINE_RECOMPUTE_FORCED) {
+            COVERAGE_INC(engine_recompute_forced);
+        } else if (node->inputs[input_idx].change_handler) {
+            COVERAGE_INC(engine_recompute_failed_handler);
+        } else {
+            COVERAGE_INC(engine_recompute_missing_handler);
+        }
     }
 
     /* Run the node handler which might change state. */
-    long long int now = time_msec();
+    long long int now = time_usec();
     node->run(node, node->data);
+    long long int delta_usec = time_usec() - now;
+    long long int delta_time = delta_usec / 1000;
+    cause->cost_usec += delta_usec;
+    if (node->state == EN_SUSPENDED) {
+        VLOG_DBG("node: %s, recompute (%s) yielded after %lldms",
+                 node->name, reason, delta_time);
+        engine_suspended_input_idx = input_idx;
+        goto done;
+    }
     node->stats.recompute++;
-    long long int delta_time = time_msec() - now;
+    cause->count++;
     if (delta_time > engine_compute_log_timeout_msec) {
         static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(20, 10);
         VLOG_INFO_RL(&rl, "node: %s, recompute (%s) took %lldms", node->name,
@@ -451,10 +1000,9 @@ engine_compute(struct engine_node *node, bool recompute_allowed)
                          node->name, node->inputs[i].node->name, delta_time);
             }
             if (!handled) {
-                engine_recompute(node, recompute_allowed,
-                                 "failed handler for input %s",
-                                 node->inputs[i].node->name);
-                return (node->state != EN_CANCELED);
+                engine_recompute(node, recompute_allowed, i);
+                return (node->state != EN_CANCELED
+                        && node->state != EN_SUSPENDED);
             }
         }
     }
@@ -464,7 +1012,7 @@ engine_compute(struct engine_node *node, bool recompute_allowed)
 }
 
 static void
-engine_run_node(struct engine_node *node, bool recompute_allowed)
+engine_run_node__(struct engine_node *node, bool recompute_allowed)
 {
     if (!node->n_inputs) {
         /* Run the node handler which might change state. */
@@ -474,7 +1022,7 @@ engine_run_node(struct engine_node *node, bool recompute_allowed)
     }
 
     if (engine_force_recompute) {
-        engine_recompute(node, recompute_allowed, "forced");
+        engine_recompute(node, recompute_allowed, ENGINE_RECOMPUTE_FORCED);
         return;
     }
 
@@ -488,9 +1036,7 @@ engine_run_node(struct engine_node *node, bool recompute_allowed)
 
             /* Trigger a recompute if we don't have a change handler. */
             if (!node->inputs[i].change_handler) {
-                engine_recompute(node, recompute_allowed,
-                                 "missing handler for input %s",
-                                 node->inputs[i].node->name);
+                engine_recompute(node, recompute_allowed, i);
                 return;
             }
         }
@@ -513,9 +1059,187 @@ engine_run_node(struct engine_node *node, bool recompute_allowed)
     }
 }
 
+/* Runs 'node' and accounts the time it took to the latency histogram and to
+ * the trace of the current engine run if the node was recomputed or
+ * computed. */
+static void
+engine_run_node(struct engine_node *node, bool recompute_allowed)
+{
+    uint64_t n_recompute = node->stats.recompute;
+    uint64_t n_compute = node->stats.compute;
+    long long int start = time_usec();
+
+    engine_run_node__(node, recompute_allowed);
+
+    long long int duration = time_usec() - start;
+    if (node->stats.recompute != n_recompute) {
+        engine_latency_hist_add(&node->stats.recompute_latency, duration);
+        engine_trace_add_event(node, true, start, duration);
+    } else if (node->stats.compute != n_compute) {
+        engine_latency_hist_add(&node->stats.compute_latency, duration);
+        engine_trace_add_event(node, false, start, duration);
+    }
+}
+
+/* Runs every node as soon as all of its inputs ran.  Thread safe nodes run
+ * in parallel, on the calling thread and on the worker threads.  The other
+ * nodes run on the calling thread while no thread safe node runs, because
+ * they may use the IDL transactions and the IDL tables without locking.
+ * Nodes can't be canceled, because recomputes are allowed. */
+static void
+engine_run_parallel(void)
+{
+    ovs_mutex_lock(&engine_pool_mutex);
+    engine_pool_ready = xmalloc(engine_n_nodes * sizeof *engine_pool_ready);
+    engine_pool_serial = xmalloc(engine_n_nodes * sizeof *engine_pool_serial);
+    engine_pool_n_ready = 0;
+    engine_pool_n_serial = 0;
+    engine_pool_next_serial = 0;
+    engine_pool_n_left = engine_n_nodes;
+
+    for (size_t i = 0; i < engine_n_nodes; i++) {
+        struct engine_node *node = engine_nodes[i];
+
+        node->n_pending_inputs = node->n_inputs;
+        if (!node->n_inputs) {
+            engine_pool_add_ready(node);
+        }
+    }
+
+    while (engine_pool_n_left) {
+        if (engine_pool_n_ready) {
+            engine_pool_run_node(engine_pool_ready[--engine_pool_n_ready]);
+        } else if (!engine_pool_n_running
+                   && engine_pool_next_serial < engine_pool_n_serial) {
+            engine_pool_run_node(
+                engine_pool_serial[engine_pool_next_serial++]);
+        } else {
+            ovs_mutex_cond_wait(&engine_pool_done_cond, &engine_pool_mutex);
+        }
+    }
+
+    free(engine_pool_ready);
+    engine_pool_ready = NULL;
+    free(engine_pool_serial);
+    engine_pool_serial = NULL;
+    ovs_mutex_unlock(&engine_pool_mutex);
+}
+
+/* Processes the changes of the current iteration in the nodes that ran
+ * before the suspended node, the way any run does.  Their states from the
+ * suspended run are merged back afterwards, so that the nodes that didn't
+ * run yet see the changes of both runs.
+ *
+ * Returns false if the suspended run can't continue, because one of these
+ * nodes was canceled or an input of the suspended node changed. */
+static bool
+engine_suspended_run_catch_up(bool recompute_allowed)
+{
+    struct engine_node *suspended = engine_suspended_node;
+    size_t n;
+
+    for (n = 0; engine_nodes[n] != suspended; n++) {
+        continue;
+    }
+
+    enum engine_node_state *states = xmalloc(n * sizeof *states);
+    bool ok = true;
+
+    for (size_t i = 0; i < n; i++) {
+        struct engine_node *node = engine_nodes[i];
+
+        states[i] = node->state;
+        if (node->clear_tracked_data) {
+            node->clear_tracked_data(node->data);
+        }
+        engine_run_node(node, recompute_allowed);
+        if (node->state == EN_CANCELED) {
+            node->stats.cancel++;
+            ok = false;
+            break;
+        }
+    }
+
+    for (size_t i = 0; ok && i < suspended->n_inputs; i++) {
+        if (suspended->inputs[i].node->state == EN_UPDATED) {
+            VLOG_DBG("node: %s, input %s changed while suspended",
+                     suspended->name, suspended->inputs[i].node->name);
+            ok = false;
+        }
+    }
+
+    for (size_t i = 0; ok && i < n; i++) {
+        if (states[i] == EN_UPDATED) {
+            engine_set_node_state(engine_nodes[i], EN_UPDATED);
+        }
+    }
+
+    free(states);
+    return ok;
+}
+
+/* Resumes the run suspended by engine_node_yield().  If the new changes
+ * can't be processed without touching the inputs of the suspended node, or
+ * a recompute was forced, the partial results can't be used anymore: the
+ * suspended run is abandoned and false is returned. */
+static bool
+engine_resume(void)
+{
+    struct engine_node *node = engine_suspended_node;
+    size_t i;
+
+    if (engine_force_recompute || !engine_suspended_run_catch_up(true)) {
+        engine_suspended_run_abandon();
+        return false;
+    }
+
+    COVERAGE_INC(engine_run_resume);
+    engine_suspended_node = NULL;
+    for (i = 0; engine_nodes[i] != node; i++) {
+        continue;
+    }
+
+    engine_resuming_node = node;
+    engine_recompute(node, true, engine_suspended_input_idx);
+    engine_resuming_node = NULL;
+    if (node->state == EN_SUSPENDED) {
+        return true;
+    }
+
+    /* The nodes that didn't run yet missed the IDL changes tracked in the
+     * iteration that suspended the run, so recompute them unless none of
+     * their inputs changed.  Inputs without inputs that didn't run yet may
+     * have had such changes. */
+    for (i++; i < engine_n_nodes; i++) {
+        struct engine_node *next = engine_nodes[i];
+
+        if (!next->n_inputs) {
+            engine_run_node(next, true);
+            engine_set_node_state(next, EN_UPDATED);
+            continue;
+        }
+
+        bool updated = engine_suspended_forced;
+        for (size_t j = 0; !updated && j < next->n_inputs; j++) {
+            updated = next->inputs[j].node->state == EN_UPDATED;
+        }
+        if (updated) {
+            engine_recompute(next, true, ENGINE_RECOMPUTE_FORCED);
+            if (next->state == EN_SUSPENDED) {
+                return true;
+            }
+        } else {
+            engine_set_node_state(next, EN_UNCHANGED);
+        }
+    }
+    return true;
+}
+
 void
 engine_run(bool recompute_allowed)
 {
+    engine_suspended_pending = false;
+
     /* If the last run was canceled skip the incremental run because a
      * recompute is needed first.
      */
@@ -524,6 +1248,33 @@ engine_run(bool recompute_allowed)
     }
 
     engine_run_canceled = false;
+    engine_run_start_msec = time_msec();
+    engine_trace_start_run();
+
+    /* A suspended run is a recompute, it can only resume when recomputes
+     * are allowed.  Until then the new changes are processed incrementally,
+     * or the run is canceled if that's not possible. */
+    if (engine_suspended_node && !recompute_allowed) {
+        struct engine_node *node = engine_suspended_node;
+
+        if (engine_force_recompute || !engine_suspended_run_catch_up(false)) {
+            engine_suspended_run_abandon();
+            engine_set_node_state(node, EN_CANCELED);
+            node->stats.cancel++;
+            engine_run_canceled = true;
+        }
+        return;
+    }
+    if (engine_suspended_node && engine_resume()) {
+        return;
+    }
+
+    if (recompute_allowed && engine_pool_n_threads
+        && !engine_time_slice_enabled()) {
+        engine_run_parallel();
+        return;
+    }
+
     for (size_t i = 0; i < engine_n_nodes; i++) {
         engine_run_node(engine_nodes[i], recompute_allowed);
 
@@ -532,7 +1283,58 @@ engine_run(bool recompute_allowed)
             engine_run_canceled = true;
             return;
         }
+        if (engine_nodes[i]->state == EN_SUSPENDED) {
+            /* The forced recompute continues when the run resumes. */
+            engine_suspended_forced = engine_force_recompute;
+            engine_set_force_recompute(false);
+            return;
+        }
     }
+    engine_time_slice_paused = false;
+}
+
+void
+engine_set_time_slice(long long int msec)
+{
+    msec = MAX(msec, 0);
+    if (msec != engine_time_slice_msec) {
+        VLOG_INFO("Engine time slice set to %lldms", msec);
+        engine_time_slice_msec = msec;
+    }
+}
+
+bool
+engine_time_slice_enabled(void)
+{
+    return engine_time_slice_msec > 0;
+}
+
+bool
+engine_time_slice_expired(void)
+{
+    return engine_time_slice_msec && !engine_time_slice_paused
+           && time_msec() - engine_run_start_msec >= engine_time_slice_msec;
+}
+
+void
+engine_node_yield(struct engine_node *node)
+{
+    COVERAGE_INC(engine_run_yield);
+    engine_set_node_state(node, EN_SUSPENDED);
+    engine_suspended_node = node;
+    poll_immediate_wake();
+}
+
+bool
+engine_node_resuming(const struct engine_node *node)
+{
+    return engine_resuming_node == node;
+}
+
+bool
+engine_suspended(void)
+{
+    return engine_suspended_node != NULL;
 }
 
 bool
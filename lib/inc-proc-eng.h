@@ -153,6 +153,9 @@
 
 #include "compiler.h"
 
+struct arena;
+struct simap;
+
 struct engine_context {
     struct ovsdb_idl_txn *ovs_idl_txn;
     struct ovsdb_idl_txn *ovnsb_idl_txn;
@@ -197,13 +200,42 @@ enum engine_node_state {
     EN_CANCELED,  /* During the last run, processing was canceled for
                    * this node.
                    */
+    EN_SUSPENDED, /* The node yielded in the middle of a recompute, the
+                   * recompute continues in the next run.
+                   */
     EN_STATE_MAX,
 };
 
+/* Number of buckets of a 'struct engine_latency_hist'.  Bucket 0 counts
+ * the runs that took less than 1 microsecond, bucket 'i' > 0 the runs that
+ * took between 2^(i - 1) and 2^i - 1 microseconds.  The last bucket also
+ * counts all the longer runs. */
+#define ENGINE_LATENCY_N_BUCKETS 32
+
+struct engine_latency_hist {
+    uint64_t buckets[ENGINE_LATENCY_N_BUCKETS];
+    uint64_t count;
+    uint64_t max_usec;
+};
+
+/* Recomputes of a node that had the same cause. */
+struct engine_recompute_cause {
+    uint64_t count;
+    uint64_t cost_usec;     /* Time spent in the node's run() method. */
+};
+
 struct engine_stats {
     uint64_t recompute;
     uint64_t compute;
     uint64_t cancel;
+
+    /* Recomputes forced with engine_set_force_recompute(). */
+    struct engine_recompute_cause forced_recompute;
+
+    /* Time spent in engine_run() for the runs of the node that recomputed
+     * it and for the ones that computed it incrementally. */
+    struct engine_latency_hist recompute_latency;
+    struct engine_latency_hist compute_latency;
 };
 
 struct engine_node {
@@ -254,6 +286,26 @@ struct engine_node {
      * engine 'data'. It may be NULL. */
     void (*clear_tracked_data)(void *tracked_data);
 
+    /* True if the node may run in parallel with other thread safe nodes,
+     * see engine_set_node_thread_safe(). */
+    bool thread_safe;
+
+    /* Nodes that have this node as an input, set by engine_init(). */
+    struct engine_node **outputs;
+    size_t n_outputs;
+
+    /* Inputs that didn't run yet in the current parallel engine run. */
+    size_t n_pending_inputs;
+
+    /* Recomputes caused by each input, indexed like 'inputs'.  An input
+     * causes a recompute when it has no change handler or when its change
+     * handler fails. */
+    struct engine_recompute_cause *input_recompute_causes;
+
+    /* Arena the node allocates (part of) its data from, or NULL, see
+     * engine_node_enable_arena(). */
+    struct arena *arena;
+
     /* Engine stats. */
     struct engine_stats stats;
 };
@@ -280,6 +332,79 @@ void engine_run(bool recompute_allowed);
  * terminates. */
 void engine_cleanup(void);
 
+/* Marks 'node' as thread safe: its run() method and change handlers only
+ * modify the node's own data and only read the data of its inputs.  They
+ * may use the IDL transactions of the engine context, but only with
+ * engine_txn_lock() held, and only to write tables that no other thread
+ * safe node reads or writes.
+ *
+ * When the engine uses more than one thread, each thread safe node runs as
+ * soon as all of its inputs ran, in parallel with the other thread safe
+ * nodes.  The other nodes run one at a time, while no thread safe node
+ * runs. */
+void engine_set_node_thread_safe(struct engine_node *node);
+
+/* IDL transactions aren't thread safe.  Thread safe nodes hold this lock
+ * around their writes through the transactions of the engine context. */
+void engine_txn_lock(void);
+void engine_txn_unlock(void);
+
+/* Creates an arena, see lib/arena.h, for 'node' to allocate its data from and
+ * returns it.  Meant to be called from the node's init() method.  The node
+ * is responsible for arena_reset() when its data is rebuilt, typically in
+ * run(), after releasing all the references to the old data.  The engine
+ * reports the memory usage of the arena through "inc-engine/show-stats NODE
+ * memory" and engine_get_memory_usage() and destroys it after the node's
+ * cleanup() method. */
+struct arena *engine_node_enable_arena(struct engine_node *);
+
+/* Adds the memory usage of the engine nodes' arenas to 'usage'. */
+void engine_get_memory_usage(struct simap *usage);
+
+/* Sets the number of threads used to run thread safe nodes, including the
+ * thread calling engine_run().  Nodes are only run in parallel when the
+ * engine run allows recomputes. */
+void engine_set_n_threads(size_t n_threads);
+
+/* Cooperative time slicing.
+ *
+ * The run() method of a node whose recompute may take long can call
+ * engine_time_slice_expired() periodically.  When it returns true, the node
+ * saves how far it got in its data, calls engine_node_yield() and returns
+ * without setting its state.  The engine run stops there, so that the main
+ * loop can service I/O, and the engine_run() of the next iteration calls
+ * run() again with engine_node_resuming() returning true, so that it
+ * continues where it left off.  engine_init_run() keeps the state of the
+ * nodes while the run is suspended.
+ *
+ * Every engine_run() while the run is suspended first processes the new
+ * changes in the nodes that ran before the suspension, with their change
+ * handlers, like any run.  engine_run() without recomputes allowed stops
+ * there and the run stays suspended.  The partial results are dropped and
+ * the engine recomputes all the nodes, without time slicing, if that fails,
+ * if an input of the suspended node changed, if a recompute is forced, or
+ * if an iteration of the main loop doesn't call engine_run(), because its
+ * IDL changes are gone by the next one.  Nodes that didn't run before the
+ * suspension are recomputed when the run resumes, if any of their inputs
+ * changed, because the IDL changes tracked when the run started are gone
+ * by then.
+ *
+ * Time slicing is disabled by default.  While it's enabled the engine
+ * doesn't run nodes in parallel. */
+
+/* Sets the time, in milliseconds, after the start of an engine run at which
+ * nodes that support it yield.  0 disables time slicing. */
+void engine_set_time_slice(long long int msec);
+bool engine_time_slice_enabled(void);
+bool engine_time_slice_expired(void);
+void engine_node_yield(struct engine_node *);
+bool engine_node_resuming(const struct engine_node *);
+
+/* Returns true if the last engine run was suspended by a node that
+ * yielded.  engine_node_yield() wakes up the main loop right away so that
+ * the run resumes in the next iteration. */
+bool engine_suspended(void);
+
 /* Check if engine needs to run but didn't. */
 bool engine_need_run(void);
 
@@ -25,6 +25,7 @@
 #include <semaphore.h>
 #include "fatal-signal.h"
 #include "util.h"
+#include "openvswitch/dynamic-string.h"
 #include "openvswitch/vlog.h"
 #include "openvswitch/hmap.h"
 #include "openvswitch/thread.h"
@@ -155,6 +156,9 @@ init_controls(struct worker_pool *pool)
         new_control->data = NULL;
         new_control->pool = pool;
         new_control->worker = 0;
+        new_control->finished_usec = 0;
+        new_control->busy_usec = 0;
+        new_control->idle_usec = 0;
         ovs_mutex_init(&new_control->mutex);
         atomic_init(&new_control->finished, false);
         sprintf(sem_name, WORKER_SEM_NAME, sembase, pool, i);
@@ -170,7 +174,7 @@ init_controls(struct worker_pool *pool)
 static void
 init_threads(struct worker_pool *pool, void *(*start)(void *))
 {
-    for (size_t i = 0; i < pool_size; i++) {
+    for (size_t i = 0; i < pool->size; i++) {
         pool->controls[i].worker =
             ovs_thread_create("worker pool helper", start, &pool->controls[i]);
     }
@@ -184,7 +188,10 @@ ovn_update_worker_pool(size_t requested_pool_size,
     bool test = false;
     char sem_name[256];
 
-    if (requested_pool_size == pool_size) {
+    /* Compare against the size of this pool rather than 'pool_size', there
+     * may be several pools, e.g. one per processing stage.  No pool is the
+     * same as a pool of size 1. */
+    if (requested_pool_size == (*pool ? (*pool)->size : 1)) {
         return POOL_UNCHANGED;
     }
 
@@ -206,6 +213,7 @@ ovn_update_worker_pool(size_t requested_pool_size,
             *pool = xmalloc(sizeof(struct worker_pool));
             (*pool)->size = pool_size;
             (*pool)->controls = NULL;
+            (*pool)->n_runs = 0;
             sprintf(sem_name, MAIN_SEM_NAME, sembase, *pool);
             (*pool)->done = sem_open(sem_name, O_CREAT, S_IRWXU, 0);
             if ((*pool)->done == SEM_FAILED) {
@@ -224,13 +232,15 @@ ovn_update_worker_pool(size_t requested_pool_size,
             free_controls(*pool);
             ovs_list_remove(&(*pool)->list_node);
             (*pool)->size = pool_size;
+            (*pool)->n_runs = 0;
             if (init_controls(*pool) == -1) {
                 goto cleanup;
             }
             init_threads(*pool, start);
         } else {
             VLOG_INFO("Deleting existing pool");
-            worker_pool_hook(NULL);
+            ovs_list_remove(&(*pool)->list_node);
+            free_pool(*pool);
             *pool = NULL;
         }
     }
@@ -301,6 +311,7 @@ ovn_run_pool_callback(struct worker_pool *pool,
                                           void *result_frags, size_t index))
 {
     size_t index, completed;
+    long long int start_usec = time_usec();
 
     /* Ensure that all worker threads see the same data as the
      * main thread.
@@ -353,6 +364,131 @@ ovn_run_pool_callback(struct worker_pool *pool,
             }
         }
     } while (completed < pool->size);
+
+    long long int end_usec = time_usec();
+    for (index = 0; index < pool->size; index++) {
+        struct worker_control *control = &pool->controls[index];
+        long long int finished_usec = MAX(control->finished_usec, start_usec);
+
+        control->busy_usec += finished_usec - start_usec;
+        control->idle_usec += MAX(end_usec - finished_usec, 0);
+    }
+    pool->n_runs++;
+}
+
+void
+ovn_worker_pool_format_stats(const struct worker_pool *pool, struct ds *ds)
+{
+    if (!pool) {
+        ds_put_cstr(ds, "Parallel processing is disabled\n");
+        return;
+    }
+
+    ds_put_format(ds, "Runs: %llu\n", pool->n_runs);
+    for (size_t i = 0; i < pool->size; i++) {
+        const struct worker_control *control = &pool->controls[i];
+        unsigned long long int total = control->busy_usec
+                                       + control->idle_usec;
+
+        ds_put_format(ds, "Worker %"PRIuSIZE": busy %llu ms, idle %llu ms",
+                      i, control->busy_usec / 1000,
+                      control->idle_usec / 1000);
+        if (total) {
+            ds_put_format(ds, " (%llu%% busy)",
+                          control->busy_usec * 100 / total);
+        }
+        ds_put_char(ds, '\n');
+    }
+}
+
+void
+ovn_worker_pool_clear_stats(struct worker_pool *pool)
+{
+    if (!pool) {
+        return;
+    }
+
+    pool->n_runs = 0;
+    for (size_t i = 0; i < pool->size; i++) {
+        pool->controls[i].busy_usec = 0;
+        pool->controls[i].idle_usec = 0;
+    }
+}
+
+/* Average number of chunks in a worker range when the chunk size is picked
+ * automatically.  More chunks means better balancing at the cost of more
+ * atomic operations. */
+#define WORKER_TASK_CHUNKS_PER_WORKER 16
+
+void
+ovn_worker_task_queue_init(struct worker_task_queue *queue, size_t n_items,
+                           size_t n_workers, size_t chunk_size)
+{
+    ovs_assert(n_workers);
+
+    if (!chunk_size) {
+        chunk_size = MAX(1, n_items / (n_workers
+                                       * WORKER_TASK_CHUNKS_PER_WORKER));
+    }
+    queue->chunk_size = chunk_size;
+    queue->n_workers = n_workers;
+    queue->ranges = xmalloc_cacheline(n_workers * sizeof *queue->ranges);
+
+    size_t start = 0;
+    for (size_t i = 0; i < n_workers; i++) {
+        size_t end = n_items * (i + 1) / n_workers;
+
+        atomic_init(&queue->ranges[i].next, start);
+        queue->ranges[i].end = end;
+        start = end;
+    }
+}
+
+void
+ovn_worker_task_queue_destroy(struct worker_task_queue *queue)
+{
+    free_cacheline(queue->ranges);
+    queue->ranges = NULL;
+}
+
+static bool
+worker_task_range_claim(struct worker_task_range *range, size_t chunk_size,
+                        size_t *start, size_t *end)
+{
+    size_t next;
+
+    /* Avoid bumping 'next' of ranges that are already exhausted, it's the
+     * common case when stealing at the end of a run. */
+    atomic_read_relaxed(&range->next, &next);
+    if (next >= range->end) {
+        return false;
+    }
+
+    atomic_add_relaxed(&range->next, chunk_size, &next);
+    if (next >= range->end) {
+        return false;
+    }
+
+    *start = next;
+    *end = MIN(next + chunk_size, range->end);
+    return true;
+}
+
+bool
+ovn_worker_task_queue_next(struct worker_task_queue *queue, size_t worker_id,
+                           size_t *start, size_t *end)
+{
+    /* Own range first, then try to steal from the other workers, starting
+     * with the next one to spread the stealing workers across ranges. */
+    for (size_t i = 0; i < queue->n_workers; i++) {
+        struct worker_task_range *range =
+            &queue->ranges[(worker_id + i) % queue->n_workers];
+
+        if (worker_task_range_claim(range, queue->chunk_size, start, end)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 /* Run a thread pool - basic, does not do results processing.
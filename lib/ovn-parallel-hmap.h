@@ -33,6 +33,10 @@ extern "C" {
 #include "openvswitch/hmap.h"
 #include "openvswitch/thread.h"
 #include "ovs-atomic.h"
+#include "timeval.h"
+#include "util.h"
+
+struct ds;
 
 /* Process this include only if OVS does not supply parallel definitions
  */
@@ -83,6 +87,12 @@ struct worker_control {
     void *data; /* Pointer to data to be processed. */
     pthread_t worker;
     struct worker_pool *pool;
+
+    /* Statistics, updated by the main thread at the end of each run. */
+    long long int finished_usec; /* When the worker completed the last run. */
+    unsigned long long int busy_usec; /* Total time spent processing. */
+    unsigned long long int idle_usec; /* Total time spent waiting for the
+                                       * other workers to complete. */
 };
 
 struct worker_pool {
@@ -90,6 +100,7 @@ struct worker_pool {
     struct ovs_list list_node; /* List of pools - used in cleanup/exit. */
     struct worker_control *controls; /* "Handles" in this pool. */
     sem_t *done; /* Work completion semaphorew. */
+    unsigned long long int n_runs; /* Number of times the pool was run. */
 };
 
 /* Return pool size; bigger than 1 means parallelization has been enabled. */
@@ -153,6 +164,83 @@ void ovn_run_pool_callback(struct worker_pool *pool, void *fin_result,
                            void *fin_result, void *result_frags,
                            size_t index));
 
+/* Append the per worker busy and idle times of 'pool' to 'ds'. */
+void ovn_worker_pool_format_stats(const struct worker_pool *pool,
+                                  struct ds *ds);
+
+/* Reset the statistics of 'pool'. */
+void ovn_worker_pool_clear_stats(struct worker_pool *pool);
+
+/* Work stealing task queue.
+ *
+ * Splitting the work statically between the workers of a pool (e.g.
+ * iterating hash buckets ThreadID, ThreadID + step, ...) leaves most of the
+ * workers idle when the cost of the items is skewed.  A task queue instead
+ * hands out the items, identified by an index in [0, n_items), in chunks.
+ * Each worker initially owns a contiguous range of items and claims chunks
+ * from it.  Once its own range is exhausted, it steals chunks from the
+ * ranges of the other workers, so all the workers keep busy until there is
+ * no more work left.
+ *
+ * The queue needs to be initialized by the main thread before the pool is
+ * run and destroyed after the run. */
+struct worker_task_range {
+    PADDED_MEMBERS(CACHE_LINE_SIZE,
+        atomic_size_t next;   /* Next item to be claimed. */
+        size_t end;           /* One past the last item of the range. */
+    );
+};
+
+struct worker_task_queue {
+    size_t chunk_size;                 /* Number of items claimed at once. */
+    size_t n_workers;
+    struct worker_task_range *ranges;  /* One range per worker. */
+};
+
+/* Initializes 'queue' for 'n_items' split between 'n_workers'.  If
+ * 'chunk_size' is 0, a chunk size is picked so that every worker range
+ * consists of several chunks. */
+void ovn_worker_task_queue_init(struct worker_task_queue *queue,
+                                size_t n_items, size_t n_workers,
+                                size_t chunk_size);
+void ovn_worker_task_queue_destroy(struct worker_task_queue *queue);
+
+/* Claims the next chunk of items [*start, *end) for the worker with id
+ * 'worker_id'.  Returns false if there are no more items to process. */
+bool ovn_worker_task_queue_next(struct worker_task_queue *queue,
+                                size_t worker_id,
+                                size_t *start, size_t *end);
+
+/* Current chunk of items claimed by a worker. */
+struct worker_task_cursor {
+    size_t next;
+    size_t end;
+};
+
+#define WORKER_TASK_CURSOR_INITIALIZER { 0, 0 }
+
+static inline bool
+worker_task_queue_next_item(struct worker_task_queue *queue,
+                            size_t worker_id,
+                            struct worker_task_cursor *cursor, size_t *item)
+{
+    if (cursor->next == cursor->end
+        && !ovn_worker_task_queue_next(queue, worker_id,
+                                       &cursor->next, &cursor->end)) {
+        return false;
+    }
+    *item = cursor->next++;
+    return true;
+}
+
+/* Iterates over all the items that the worker with id 'WORKER_ID' claims
+ * from 'QUEUE', storing the index of each item in 'ITEM'. */
+#define WORKER_TASK_FOR_EACH(ITEM, WORKER_ID, QUEUE)                        \
+    for (struct worker_task_cursor ITEM##_cursor__ =                        \
+             WORKER_TASK_CURSOR_INITIALIZER;                                \
+         worker_task_queue_next_item(QUEUE, WORKER_ID, &ITEM##_cursor__,    \
+                                     &(ITEM));)
+
 
 /* Returns the first node in 'hmap' in the bucket in which the given 'hash'
  * would land, or a null pointer if that bucket is empty. */
@@ -200,8 +288,61 @@ parallel_hmap_next(const struct hmap *hmap,
                 (node->hash & hmap->mask) + pool_size, pool_size));
 }
 
+/* Lock-free concurrent insertion support.
+ *
+ * Multiple threads may insert into the same 'hmap' at the same time by
+ * pushing nodes to the head of a hash bucket with a compare-and-swap and may
+ * look up nodes in the meantime by walking a bucket from the head returned by
+ * hmap_bucket_head_concurrent().  Nodes are never unlinked by concurrent
+ * inserts, so a bucket list seen by a reader stays valid.
+ *
+ * Just like with fast hash inserts, the hmap is never expanded, so it should
+ * be pre-sized (e.g. with fast_hmap_size_for()) and then resized with
+ * hmap_expand() once all the threads are done.  Removal is not allowed while
+ * any thread is still inserting.  Unlike with fast hash inserts, hmap->n is
+ * kept exact at all times. */
+
+/* Returns the current head of the bucket in which 'hash' would land. */
+static inline struct hmap_node *
+hmap_bucket_head_concurrent(const struct hmap *hmap, size_t hash)
+{
+    ATOMIC(struct hmap_node *) *head =
+        (ATOMIC(struct hmap_node *) *) &hmap->buckets[hash & hmap->mask];
+    struct hmap_node *node;
+
+    atomic_read_explicit(head, &node, memory_order_acquire);
+    return node;
+}
+
+/* Inserts 'node' with the given 'hash' at the head of its bucket in 'hmap'
+ * if 'expected_head' is still the head of that bucket.  Returns true if
+ * successful, false if another thread inserted to the same bucket since
+ * 'expected_head' was read.  In the latter case the caller needs to check
+ * the nodes inserted in the meantime, if necessary, and retry with the new
+ * bucket head. */
+static inline bool
+hmap_insert_concurrent(struct hmap *hmap, struct hmap_node *node, size_t hash,
+                       struct hmap_node *expected_head)
+{
+    ATOMIC(struct hmap_node *) *head =
+        (ATOMIC(struct hmap_node *) *) &hmap->buckets[hash & hmap->mask];
+
+    node->hash = hash;
+    node->next = expected_head;
+    if (!atomic_compare_exchange_strong_explicit(head, &expected_head, node,
+                                                 memory_order_release,
+                                                 memory_order_relaxed)) {
+        return false;
+    }
+
+    size_t orig;
+    atomic_add_relaxed((atomic_size_t *) &hmap->n, 1, &orig);
+    return true;
+}
+
 static inline void post_completed_work(struct worker_control *control)
 {
+    control->finished_usec = time_usec();
     atomic_thread_fence(memory_order_release);
     atomic_store_relaxed(&control->finished, true);
     sem_post(control->done);
@@ -297,6 +438,17 @@ static inline void init_hash_row_locks(struct hashrow_locks *hrl)
 #define run_pool_callback(pool, fin_result, result_frags, helper_func) \
     ovn_run_pool_callback(pool, fin_result, result_frags, helper_func)
 
+#define worker_pool_format_stats(pool, ds) \
+    ovn_worker_pool_format_stats(pool, ds)
+
+#define worker_pool_clear_stats(pool) ovn_worker_pool_clear_stats(pool)
+
+#define worker_task_queue_init(queue, n_items, n_workers, chunk_size) \
+    ovn_worker_task_queue_init(queue, n_items, n_workers, chunk_size)
+
+#define worker_task_queue_destroy(queue) \
+    ovn_worker_task_queue_destroy(queue)
+
 
 
 #ifdef __clang__
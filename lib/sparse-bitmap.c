@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2024, Red Hat, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+/* OVS includes */
+#include "bitmap.h"
+#include "ovs-atomic.h"
+#include "util.h"
+
+/* OVN includes */
+#include "sparse-bitmap.h"
+
+static size_t
+sparse_bitmap_n_chunks(size_t n_bits)
+{
+    return DIV_ROUND_UP(n_bits, SPARSE_BITMAP_CHUNK_BITS);
+}
+
+static unsigned long *
+sparse_bitmap_chunk_alloc(void)
+{
+    return xzalloc(SPARSE_BITMAP_CHUNK_LONGS * sizeof(unsigned long));
+}
+
+static bool
+sparse_bitmap_chunk_is_empty(const unsigned long *chunk)
+{
+    for (size_t i = 0; i < SPARSE_BITMAP_CHUNK_LONGS; i++) {
+        if (chunk[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Returns the chunk that contains word 'word_idx' or NULL if it isn't
+ * allocated.  The chunk may be published concurrently by
+ * sparse_bitmap_or_word_concurrent(). */
+static unsigned long *
+sparse_bitmap_get_chunk(const struct sparse_bitmap *sb, size_t word_idx)
+{
+    ATOMIC(unsigned long *) *slot = (ATOMIC(unsigned long *) *)
+        &sb->chunks[word_idx / SPARSE_BITMAP_CHUNK_LONGS];
+    unsigned long *chunk;
+
+    atomic_read_explicit(slot, &chunk, memory_order_acquire);
+    return chunk;
+}
+
+void
+sparse_bitmap_init(struct sparse_bitmap *sb, size_t n_bits)
+{
+    size_t n_chunks = sparse_bitmap_n_chunks(n_bits);
+
+    sb->n_bits = n_bits;
+    sb->chunks = n_chunks ? xcalloc(n_chunks, sizeof *sb->chunks) : NULL;
+}
+
+/* Initializes 'sb' with the same 'n_bits' bits as the plain 'bitmap'. */
+void
+sparse_bitmap_init_from_bitmap(struct sparse_bitmap *sb,
+                               const unsigned long *bitmap, size_t n_bits)
+{
+    sparse_bitmap_init(sb, n_bits);
+    for (size_t i = 0; i < bitmap_n_longs(n_bits); i++) {
+        if (bitmap[i]) {
+            sparse_bitmap_or_word(sb, i, bitmap[i]);
+        }
+    }
+}
+
+void
+sparse_bitmap_clone(struct sparse_bitmap *dst,
+                    const struct sparse_bitmap *src)
+{
+    size_t n_chunks = sparse_bitmap_n_chunks(src->n_bits);
+
+    sparse_bitmap_init(dst, src->n_bits);
+    for (size_t i = 0; i < n_chunks; i++) {
+        if (src->chunks[i]) {
+            dst->chunks[i] = xmemdup(src->chunks[i],
+                                     SPARSE_BITMAP_CHUNK_LONGS
+                                     * sizeof(unsigned long));
+        }
+    }
+}
+
+void
+sparse_bitmap_destroy(struct sparse_bitmap *sb)
+{
+    size_t n_chunks = sparse_bitmap_n_chunks(sb->n_bits);
+
+    for (size_t i = 0; i < n_chunks; i++) {
+        free(sb->chunks[i]);
+    }
+    free(sb->chunks);
+    sb->chunks = NULL;
+    sb->n_bits = 0;
+}
+
+bool
+sparse_bitmap_is_set(const struct sparse_bitmap *sb, size_t idx)
+{
+    size_t word_idx = idx / BITMAP_ULONG_BITS;
+    unsigned long *chunk = sparse_bitmap_get_chunk(sb, word_idx);
+    unsigned long bits;
+
+    if (!chunk) {
+        return false;
+    }
+
+    /* The word may be updated by sparse_bitmap_or_word_concurrent(). */
+    atomic_read_relaxed((atomic_ulong *)
+                        &chunk[word_idx % SPARSE_BITMAP_CHUNK_LONGS], &bits);
+    return bits & bitmap_bit__(idx);
+}
+
+void
+sparse_bitmap_set1(struct sparse_bitmap *sb, size_t idx)
+{
+    sparse_bitmap_or_word(sb, idx / BITMAP_ULONG_BITS, bitmap_bit__(idx));
+}
+
+/* Clears bit 'idx' and frees its chunk if no other bit is set in it. */
+void
+sparse_bitmap_set0(struct sparse_bitmap *sb, size_t idx)
+{
+    size_t chunk_idx = idx / SPARSE_BITMAP_CHUNK_BITS;
+    unsigned long *chunk = sb->chunks[chunk_idx];
+
+    if (chunk) {
+        size_t word_idx = idx / BITMAP_ULONG_BITS;
+
+        chunk[word_idx % SPARSE_BITMAP_CHUNK_LONGS] &= ~bitmap_bit__(idx);
+        if (sparse_bitmap_chunk_is_empty(chunk)) {
+            free(chunk);
+            sb->chunks[chunk_idx] = NULL;
+        }
+    }
+}
+
+/* Sets the bits of 'mask' in word 'word_idx' of 'sb', i.e., in the bits
+ * starting at 'word_idx' * BITMAP_ULONG_BITS. */
+void
+sparse_bitmap_or_word(struct sparse_bitmap *sb, size_t word_idx,
+                      unsigned long mask)
+{
+    unsigned long **slot = &sb->chunks[word_idx / SPARSE_BITMAP_CHUNK_LONGS];
+
+    if (!mask) {
+        return;
+    }
+    if (!*slot) {
+        *slot = sparse_bitmap_chunk_alloc();
+    }
+    (*slot)[word_idx % SPARSE_BITMAP_CHUNK_LONGS] |= mask;
+}
+
+/* Same as sparse_bitmap_or_word(), but may run concurrently in multiple
+ * threads for the same 'sb'.  A missing chunk is published with a
+ * compare-and-swap, the thread that loses the race frees its copy. */
+void
+sparse_bitmap_or_word_concurrent(struct sparse_bitmap *sb, size_t word_idx,
+                                 unsigned long mask)
+{
+    ATOMIC(unsigned long *) *slot = (ATOMIC(unsigned long *) *)
+        &sb->chunks[word_idx / SPARSE_BITMAP_CHUNK_LONGS];
+    unsigned long *chunk;
+
+    if (!mask) {
+        return;
+    }
+    atomic_read_explicit(slot, &chunk, memory_order_acquire);
+    if (!chunk) {
+        unsigned long *new_chunk = sparse_bitmap_chunk_alloc();
+
+        if (atomic_compare_exchange_strong_explicit(slot, &chunk, new_chunk,
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire)) {
+            chunk = new_chunk;
+        } else {
+            free(new_chunk);
+        }
+    }
+
+    /* Other threads may set bits of the same word at the same time, so it
+     * must only be accessed atomically. */
+    atomic_ulong *word = (atomic_ulong *)
+        &chunk[word_idx % SPARSE_BITMAP_CHUNK_LONGS];
+    unsigned long bits;
+
+    atomic_read_relaxed(word, &bits);
+    if ((bits & mask) != mask) {
+        atomic_or_relaxed(word, mask, &bits);
+    }
+}
+
+size_t
+sparse_bitmap_count1(const struct sparse_bitmap *sb)
+{
+    size_t n_chunks = sparse_bitmap_n_chunks(sb->n_bits);
+    size_t count = 0;
+
+    for (size_t i = 0; i < n_chunks; i++) {
+        const unsigned long *chunk = sb->chunks[i];
+
+        if (chunk) {
+            for (size_t j = 0; j < SPARSE_BITMAP_CHUNK_LONGS; j++) {
+                count += count_1bits(chunk[j]);
+            }
+        }
+    }
+    return count;
+}
+
+/* Returns the index of the first 1-bit in 'sb' at or after 'start', or
+ * 'sb->n_bits' if there is none. */
+size_t
+sparse_bitmap_scan(const struct sparse_bitmap *sb, size_t start)
+{
+    size_t n_chunks = sparse_bitmap_n_chunks(sb->n_bits);
+
+    for (size_t i = start / SPARSE_BITMAP_CHUNK_BITS; i < n_chunks; i++) {
+        const unsigned long *chunk = sb->chunks[i];
+
+        if (chunk) {
+            size_t base = i * SPARSE_BITMAP_CHUNK_BITS;
+            size_t end = MIN(SPARSE_BITMAP_CHUNK_BITS, sb->n_bits - base);
+            size_t idx = bitmap_scan(chunk, true,
+                                     start > base ? start - base : 0, end);
+            if (idx < end) {
+                return base + idx;
+            }
+        }
+    }
+    return sb->n_bits;
+}
+
+bool
+sparse_bitmap_equal(const struct sparse_bitmap *a,
+                    const struct sparse_bitmap *b)
+{
+    if (a->n_bits != b->n_bits) {
+        return false;
+    }
+
+    size_t n_chunks = sparse_bitmap_n_chunks(a->n_bits);
+    for (size_t i = 0; i < n_chunks; i++) {
+        const unsigned long *ca = a->chunks[i];
+        const unsigned long *cb = b->chunks[i];
+
+        /* Empty chunks are always freed, so a missing chunk can only be
+         * equal to another missing one. */
+        if (!ca || !cb) {
+            if (ca != cb) {
+                return false;
+            }
+        } else if (memcmp(ca, cb,
+                          SPARSE_BITMAP_CHUNK_LONGS * sizeof *ca)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2024, Red Hat, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OVN_SPARSE_BITMAP_H
+#define OVN_SPARSE_BITMAP_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bitmap.h"
+
+/* Sparse bitmap.
+ * ==============
+ *
+ * A bitmap of a fixed number of bits split into fixed size chunks that are
+ * only allocated once one of their bits is set, and freed again once all of
+ * their bits are cleared.  A bitmap of 'n_bits' with only a few bits set
+ * takes an array of pointers, 1 per SPARSE_BITMAP_CHUNK_BITS bits, plus the
+ * chunks that are in use, instead of the 'n_bits' / 8 bytes of a plain
+ * bitmap.  Counting, scanning and comparing skip the unallocated chunks.
+ *
+ * Thread safety
+ * =============
+ * sparse_bitmap_or_word_concurrent() may be called for the same bitmap from
+ * multiple threads at the same time, and concurrently with
+ * sparse_bitmap_is_set().  All the other functions that modify a bitmap
+ * require exclusive access to it. */
+
+/* Number of 'unsigned long's in a chunk. */
+#define SPARSE_BITMAP_CHUNK_LONGS 8
+#define SPARSE_BITMAP_CHUNK_BITS (SPARSE_BITMAP_CHUNK_LONGS * BITMAP_ULONG_BITS)
+
+struct sparse_bitmap {
+    size_t n_bits;
+    unsigned long **chunks;     /* NULL for the chunks with no bits set. */
+};
+
+void sparse_bitmap_init(struct sparse_bitmap *, size_t n_bits);
+void sparse_bitmap_init_from_bitmap(struct sparse_bitmap *,
+                                    const unsigned long *bitmap,
+                                    size_t n_bits);
+void sparse_bitmap_clone(struct sparse_bitmap *dst,
+                         const struct sparse_bitmap *src);
+void sparse_bitmap_destroy(struct sparse_bitmap *);
+
+bool sparse_bitmap_is_set(const struct sparse_bitmap *, size_t idx);
+void sparse_bitmap_set1(struct sparse_bitmap *, size_t idx);
+void sparse_bitmap_set0(struct sparse_bitmap *, size_t idx);
+void sparse_bitmap_or_word(struct sparse_bitmap *, size_t word_idx,
+                           unsigned long mask);
+void sparse_bitmap_or_word_concurrent(struct sparse_bitmap *,
+                                      size_t word_idx, unsigned long mask);
+
+size_t sparse_bitmap_count1(const struct sparse_bitmap *);
+size_t sparse_bitmap_scan(const struct sparse_bitmap *, size_t start);
+bool sparse_bitmap_equal(const struct sparse_bitmap *,
+                         const struct sparse_bitmap *);
+
+/* Iterates IDX over the indexes of the 1-bits in SB. */
+#define SPARSE_BITMAP_FOR_EACH_1(IDX, SB)                           \
+    for ((IDX) = sparse_bitmap_scan(SB, 0); (IDX) < (SB)->n_bits;   \
+         (IDX) = sparse_bitmap_scan(SB, (IDX) + 1))
+
+#endif /* lib/sparse-bitmap.h */
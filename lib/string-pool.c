@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2024, Red Hat, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+/* OVS includes */
+#include "coverage.h"
+#include "hash.h"
+#include "openvswitch/hmap.h"
+#include "openvswitch/thread.h"
+#include "ovs-atomic.h"
+#include "util.h"
+
+/* OVN includes */
+#include "string-pool.h"
+
+COVERAGE_DEFINE(string_pool_cache_hit);
+COVERAGE_DEFINE(string_pool_shard_lock);
+COVERAGE_DEFINE(string_pool_shard_contended);
+
+struct string_pool_entry {
+    struct hmap_node hmap_node; /* In 'struct string_pool_shard' 'strings'. */
+
+    /* Only drops to 0 with the shard mutex held, see string_pool_release().
+     * May be incremented without the mutex by the owner of a reference. */
+    ATOMIC(size_t) refcnt;
+    size_t len;
+    char string[];
+};
+
+struct string_pool_shard {
+    PADDED_MEMBERS(CACHE_LINE_SIZE,
+        struct ovs_mutex mutex;
+        struct hmap strings; /* Contains 'struct string_pool_entry'. */
+    );
+};
+
+struct string_pool {
+    struct string_pool_shard shards[STRING_POOL_N_SHARDS];
+};
+
+struct string_pool_cache {
+    struct string_pool *pool;
+
+    /* Indexed by string hash.  Each entry holds a reference. */
+    struct string_pool_entry *slots[STRING_POOL_CACHE_SIZE];
+};
+
+static struct string_pool_shard *
+string_pool_get_shard(struct string_pool *pool, uint32_t hash)
+{
+    /* The low bits of the hash select the hmap bucket, use the high ones
+     * to select the shard. */
+    return &pool->shards[(hash >> 24) & (STRING_POOL_N_SHARDS - 1)];
+}
+
+static void
+string_pool_shard_lock(struct string_pool_shard *shard)
+    OVS_ACQUIRES(shard->mutex)
+{
+    COVERAGE_INC(string_pool_shard_lock);
+    if (ovs_mutex_trylock(&shard->mutex)) {
+        COVERAGE_INC(string_pool_shard_contended);
+        ovs_mutex_lock(&shard->mutex);
+    }
+}
+
+static struct string_pool_entry *
+string_pool_find__(const struct string_pool_shard *shard, const char *s,
+                   size_t len, uint32_t hash)
+{
+    struct string_pool_entry *entry;
+    HMAP_FOR_EACH_WITH_HASH (entry, hmap_node, hash, &shard->strings) {
+        if (entry->len == len && !memcmp(entry->string, s, len)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static struct string_pool_entry *
+string_pool_entry_from_string(const char *s)
+{
+    return CONTAINER_OF(s, struct string_pool_entry, string);
+}
+
+struct string_pool *
+string_pool_create(void)
+{
+    struct string_pool *pool = xmalloc(sizeof *pool);
+
+    for (size_t i = 0; i < STRING_POOL_N_SHARDS; i++) {
+        ovs_mutex_init(&pool->shards[i].mutex);
+        hmap_init(&pool->shards[i].strings);
+    }
+    return pool;
+}
+
+/* Destroys 'pool' and all the strings in it, regardless of outstanding
+ * references. */
+void
+string_pool_destroy(struct string_pool *pool)
+{
+    if (!pool) {
+        return;
+    }
+
+    for (size_t i = 0; i < STRING_POOL_N_SHARDS; i++) {
+        struct string_pool_shard *shard = &pool->shards[i];
+        struct string_pool_entry *entry;
+
+        HMAP_FOR_EACH_POP (entry, hmap_node, &shard->strings) {
+            free(entry);
+        }
+        hmap_destroy(&shard->strings);
+        ovs_mutex_destroy(&shard->mutex);
+    }
+    free(pool);
+}
+
+static void
+string_pool_entry_ref(struct string_pool_entry *entry)
+{
+    size_t orig;
+
+    atomic_add_relaxed(&entry->refcnt, 1, &orig);
+}
+
+static struct string_pool_entry *
+string_pool_intern__(struct string_pool *pool, const char *s, size_t len,
+                     uint32_t hash)
+{
+    struct string_pool_shard *shard = string_pool_get_shard(pool, hash);
+    struct string_pool_entry *entry;
+
+    string_pool_shard_lock(shard);
+    entry = string_pool_find__(shard, s, len, hash);
+    if (entry) {
+        string_pool_entry_ref(entry);
+    } else {
+        entry = xmalloc(sizeof *entry + len + 1);
+        atomic_init(&entry->refcnt, 1);
+        entry->len = len;
+        memcpy(entry->string, s, len + 1);
+        hmap_insert(&shard->strings, &entry->hmap_node, hash);
+    }
+    ovs_mutex_unlock(&shard->mutex);
+
+    return entry;
+}
+
+/* Returns the copy of 's' stored in 'pool', adding it if it's not there yet,
+ * and takes a reference on it.  The caller must eventually release the
+ * reference with string_pool_release(). */
+const char *
+string_pool_intern(struct string_pool *pool, const char *s)
+{
+    size_t len = strlen(s);
+
+    return string_pool_intern__(pool, s, len, hash_bytes(s, len, 0))->string;
+}
+
+/* Same as string_pool_intern() but returns NULL if 's' is NULL. */
+const char *
+string_pool_intern_nullable(struct string_pool *pool, const char *s)
+{
+    return s ? string_pool_intern(pool, s) : NULL;
+}
+
+/* Returns the copy of 's' stored in 'pool' without taking a reference, or
+ * NULL if 's' is not in 'pool'. */
+const char *
+string_pool_lookup(struct string_pool *pool, const char *s)
+{
+    size_t len = strlen(s);
+    uint32_t hash = hash_bytes(s, len, 0);
+    struct string_pool_shard *shard = string_pool_get_shard(pool, hash);
+    struct string_pool_entry *entry;
+
+    string_pool_shard_lock(shard);
+    entry = string_pool_find__(shard, s, len, hash);
+    ovs_mutex_unlock(&shard->mutex);
+
+    return entry ? entry->string : NULL;
+}
+
+/* Releases a reference to 's', which must have been returned by
+ * string_pool_intern() on the same 'pool'.  's' may be NULL. */
+void
+string_pool_release(struct string_pool *pool, const char *s)
+{
+    if (!s) {
+        return;
+    }
+
+    struct string_pool_entry *entry = string_pool_entry_from_string(s);
+    size_t refcnt;
+
+    /* Dropping a reference that isn't the last one doesn't need the mutex.
+     * The last reference can't be taken concurrently without the mutex,
+     * since that requires owning another reference. */
+    atomic_read_relaxed(&entry->refcnt, &refcnt);
+    while (refcnt > 1) {
+        if (atomic_compare_exchange_weak_relaxed(&entry->refcnt, &refcnt,
+                                                 refcnt - 1)) {
+            return;
+        }
+    }
+
+    struct string_pool_shard *shard =
+        string_pool_get_shard(pool, entry->hmap_node.hash);
+
+    string_pool_shard_lock(shard);
+    atomic_sub_relaxed(&entry->refcnt, 1, &refcnt);
+    ovs_assert(refcnt);
+    if (refcnt == 1) {
+        hmap_remove(&shard->strings, &entry->hmap_node);
+        free(entry);
+    }
+    ovs_mutex_unlock(&shard->mutex);
+}
+
+/* Creates and returns a cache for the strings of 'pool', see
+ * string_pool_cache_intern(). */
+struct string_pool_cache *
+string_pool_cache_create(struct string_pool *pool)
+{
+    struct string_pool_cache *cache = xzalloc(sizeof *cache);
+
+    cache->pool = pool;
+    return cache;
+}
+
+/* Destroys 'cache' and releases the strings it holds.  Must be called before
+ * destroying the pool of 'cache', by the thread that uses 'cache' or after it
+ * stopped using it. */
+void
+string_pool_cache_destroy(struct string_pool_cache *cache)
+{
+    if (!cache) {
+        return;
+    }
+
+    for (size_t i = 0; i < STRING_POOL_CACHE_SIZE; i++) {
+        if (cache->slots[i]) {
+            string_pool_release(cache->pool, cache->slots[i]->string);
+        }
+    }
+    free(cache);
+}
+
+/* Same as string_pool_intern() on the pool of 'cache'.  The strings found in
+ * 'cache' are referenced without taking any mutex, which avoids contention on
+ * the shards of the strings that are interned over and over. */
+const char *
+string_pool_cache_intern(struct string_pool_cache *cache, const char *s)
+{
+    size_t len = strlen(s);
+    uint32_t hash = hash_bytes(s, len, 0);
+    struct string_pool_entry **slot =
+        &cache->slots[hash & (STRING_POOL_CACHE_SIZE - 1)];
+    struct string_pool_entry *entry = *slot;
+
+    if (entry && entry->hmap_node.hash == hash && entry->len == len
+        && !memcmp(entry->string, s, len)) {
+        COVERAGE_INC(string_pool_cache_hit);
+        string_pool_entry_ref(entry);
+        return entry->string;
+    }
+
+    /* Take one reference for the caller and another one for 'cache'. */
+    entry = string_pool_intern__(cache->pool, s, len, hash);
+    string_pool_entry_ref(entry);
+    if (*slot) {
+        string_pool_release(cache->pool, (*slot)->string);
+    }
+    *slot = entry;
+
+    return entry->string;
+}
+
+/* Same as string_pool_cache_intern() but returns NULL if 's' is NULL. */
+const char *
+string_pool_cache_intern_nullable(struct string_pool_cache *cache,
+                                  const char *s)
+{
+    return s ? string_pool_cache_intern(cache, s) : NULL;
+}
+
+/* Returns the number of distinct strings in 'pool'. */
+size_t
+string_pool_count(struct string_pool *pool)
+{
+    size_t n = 0;
+
+    for (size_t i = 0; i < STRING_POOL_N_SHARDS; i++) {
+        struct string_pool_shard *shard = &pool->shards[i];
+
+        string_pool_shard_lock(shard);
+        n += hmap_count(&shard->strings);
+        ovs_mutex_unlock(&shard->mutex);
+    }
+    return n;
+}
+
+/* Returns the number of distinct strings in the shard with index 'shard_idx'
+ * of 'pool'. */
+size_t
+string_pool_shard_count(struct string_pool *pool, size_t shard_idx)
+{
+    ovs_assert(shard_idx < STRING_POOL_N_SHARDS);
+
+    struct string_pool_shard *shard = &pool->shards[shard_idx];
+    size_t n;
+
+    string_pool_shard_lock(shard);
+    n = hmap_count(&shard->strings);
+    ovs_mutex_unlock(&shard->mutex);
+    return n;
+}
+
+/* Returns the approximate number of bytes used by the strings in 'pool'. */
+size_t
+string_pool_bytes(struct string_pool *pool)
+{
+    size_t n = 0;
+
+    for (size_t i = 0; i < STRING_POOL_N_SHARDS; i++) {
+        struct string_pool_shard *shard = &pool->shards[i];
+        struct string_pool_entry *entry;
+
+        string_pool_shard_lock(shard);
+        HMAP_FOR_EACH (entry, hmap_node, &shard->strings) {
+            n += sizeof *entry + entry->len + 1;
+        }
+        ovs_mutex_unlock(&shard->mutex);
+    }
+    return n;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2024, Red Hat, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OVN_STRING_POOL_H
+#define OVN_STRING_POOL_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* String pool.
+ * ============
+ *
+ * A string pool stores each distinct string exactly once.  Interning a string
+ * returns a pointer to the pooled copy and takes a reference on it, so that
+ * two strings interned in the same pool are equal if and only if the returned
+ * pointers are equal.  Each reference must be dropped with
+ * string_pool_release(); the pooled copy is freed once its last reference
+ * goes away.
+ *
+ * Thread safety
+ * =============
+ * The pool is split into a fixed number of shards selected by the string
+ * hash, each protected by its own mutex, so it is safe to intern, look up
+ * and release strings from multiple threads concurrently.  Pointers returned
+ * by string_pool_lookup() don't hold a reference and stay valid only as long
+ * as some other reference to the same string is kept.
+ *
+ * The few strings that are interned most often, e.g. "1" or "next;", always
+ * map to the same shards, so threads that intern them at a high rate would
+ * serialize on those shards' mutexes.  Such threads should use a
+ * string_pool_cache each: it keeps a reference to the strings it recently
+ * interned and references them again without any mutex.  A cache must only
+ * be used by one thread at a time.  The "string_pool_shard_contended"
+ * coverage counter reports how often a shard mutex was already taken. */
+
+/* Number of shards, must be a power of 2. */
+#define STRING_POOL_N_SHARDS 64
+
+/* Number of slots of a string pool cache, must be a power of 2.  A string
+ * 's' goes to the slot selected by the low bits of
+ * hash_bytes(s, strlen(s), 0). */
+#define STRING_POOL_CACHE_SIZE 1024
+
+struct string_pool;
+
+struct string_pool *string_pool_create(void);
+void string_pool_destroy(struct string_pool *);
+
+const char *string_pool_intern(struct string_pool *, const char *);
+const char *string_pool_intern_nullable(struct string_pool *, const char *);
+const char *string_pool_lookup(struct string_pool *, const char *);
+void string_pool_release(struct string_pool *, const char *);
+
+struct string_pool_cache;
+
+struct string_pool_cache *string_pool_cache_create(struct string_pool *);
+void string_pool_cache_destroy(struct string_pool_cache *);
+const char *string_pool_cache_intern(struct string_pool_cache *,
+                                     const char *);
+const char *string_pool_cache_intern_nullable(struct string_pool_cache *,
+                                              const char *);
+
+size_t string_pool_count(struct string_pool *);
+size_t string_pool_shard_count(struct string_pool *, size_t shard_idx);
+size_t string_pool_bytes(struct string_pool *);
+
+#endif /* lib/string-pool.h */
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2024, Red Hat, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include "bitmap.h"
+#include "openvswitch/thread.h"
+#include "ovs-thread.h"
+#include "random.h"
+#include "util.h"
+
+#include "lib/sparse-bitmap.h"
+#include "tests/ovstest.h"
+#include "tests/test-utils.h"
+
+static size_t
+n_allocated_chunks(const struct sparse_bitmap *sb)
+{
+    size_t n_chunks = DIV_ROUND_UP(sb->n_bits, SPARSE_BITMAP_CHUNK_BITS);
+    size_t n = 0;
+
+    for (size_t i = 0; i < n_chunks; i++) {
+        n += sb->chunks[i] != NULL;
+    }
+    return n;
+}
+
+/* Checks that 'sb' has the same bits set as the plain 'bitmap', through all
+ * the ways of reading it. */
+static void
+check_equal_to_bitmap(const struct sparse_bitmap *sb,
+                      const unsigned long *bitmap, size_t n_bits)
+{
+    ovs_assert(sb->n_bits == n_bits);
+    for (size_t i = 0; i < n_bits; i++) {
+        ovs_assert(sparse_bitmap_is_set(sb, i) == bitmap_is_set(bitmap, i));
+    }
+    ovs_assert(sparse_bitmap_count1(sb) == bitmap_count1(bitmap, n_bits));
+
+    /* Back to a plain bitmap. */
+    unsigned long *dense = bitmap_allocate(n_bits);
+    size_t idx;
+    SPARSE_BITMAP_FOR_EACH_1 (idx, sb) {
+        ovs_assert(!bitmap_is_set(dense, idx));
+        bitmap_set1(dense, idx);
+    }
+    ovs_assert(bitmap_equal(dense, bitmap, n_bits));
+    bitmap_free(dense);
+}
+
+static void
+test_sparse_bitmap_chunks(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    size_t n_bits = 10 * SPARSE_BITMAP_CHUNK_BITS + 3;
+    struct sparse_bitmap sb;
+
+    /* No chunk is allocated until a bit is set in it. */
+    sparse_bitmap_init(&sb, n_bits);
+    ovs_assert(!n_allocated_chunks(&sb));
+    ovs_assert(!sparse_bitmap_count1(&sb));
+    ovs_assert(sparse_bitmap_scan(&sb, 0) == n_bits);
+
+    sparse_bitmap_set1(&sb, 5);
+    sparse_bitmap_set1(&sb, 6);
+    ovs_assert(n_allocated_chunks(&sb) == 1);
+    ovs_assert(sb.chunks[0]);
+
+    sparse_bitmap_set1(&sb, n_bits - 1);
+    ovs_assert(n_allocated_chunks(&sb) == 2);
+    ovs_assert(sb.chunks[10]);
+
+    sparse_bitmap_or_word(&sb, 3 * SPARSE_BITMAP_CHUNK_LONGS + 1, 0);
+    ovs_assert(n_allocated_chunks(&sb) == 2);
+    sparse_bitmap_or_word(&sb, 3 * SPARSE_BITMAP_CHUNK_LONGS + 1, 0x5);
+    ovs_assert(n_allocated_chunks(&sb) == 3);
+    ovs_assert(sb.chunks[3]);
+    ovs_assert(sparse_bitmap_count1(&sb) == 5);
+
+    /* A chunk is freed once its last bit is cleared. */
+    sparse_bitmap_set0(&sb, 5);
+    ovs_assert(sb.chunks[0]);
+    sparse_bitmap_set0(&sb, 6);
+    ovs_assert(!sb.chunks[0]);
+    sparse_bitmap_set0(&sb, 6);
+    ovs_assert(!sb.chunks[0]);
+    ovs_assert(n_allocated_chunks(&sb) == 2);
+
+    /* Equal bitmaps compare equal, whatever their history. */
+    struct sparse_bitmap clone;
+    sparse_bitmap_clone(&clone, &sb);
+    ovs_assert(sparse_bitmap_equal(&sb, &clone));
+    ovs_assert(clone.chunks[3] != sb.chunks[3]);
+    sparse_bitmap_set1(&clone, 7);
+    ovs_assert(!sparse_bitmap_equal(&sb, &clone));
+    sparse_bitmap_set0(&clone, 7);
+    ovs_assert(!clone.chunks[0]);
+    ovs_assert(sparse_bitmap_equal(&sb, &clone));
+    sparse_bitmap_destroy(&clone);
+
+    sparse_bitmap_destroy(&sb);
+
+    /* An empty bitmap has no chunks at all. */
+    sparse_bitmap_init(&sb, 0);
+    ovs_assert(!sb.chunks);
+    ovs_assert(!sparse_bitmap_count1(&sb));
+    ovs_assert(sparse_bitmap_scan(&sb, 0) == 0);
+    sparse_bitmap_destroy(&sb);
+}
+
+static void
+test_sparse_bitmap_scan(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    size_t n_bits = 4 * SPARSE_BITMAP_CHUNK_BITS + 17;
+    size_t bits[] = {
+        0,
+        SPARSE_BITMAP_CHUNK_BITS - 1,
+        SPARSE_BITMAP_CHUNK_BITS,
+        SPARSE_BITMAP_CHUNK_BITS + 1,
+        /* Chunk 2 stays empty. */
+        3 * SPARSE_BITMAP_CHUNK_BITS + BITMAP_ULONG_BITS - 1,
+        3 * SPARSE_BITMAP_CHUNK_BITS + BITMAP_ULONG_BITS,
+        4 * SPARSE_BITMAP_CHUNK_BITS + 16,
+    };
+    struct sparse_bitmap sb;
+
+    sparse_bitmap_init(&sb, n_bits);
+    for (size_t i = 0; i < ARRAY_SIZE(bits); i++) {
+        sparse_bitmap_set1(&sb, bits[i]);
+    }
+    ovs_assert(sparse_bitmap_count1(&sb) == ARRAY_SIZE(bits));
+    ovs_assert(!sb.chunks[2]);
+
+    /* The iteration crosses the chunk boundaries and skips the empty
+     * chunk. */
+    size_t i = 0, idx;
+    SPARSE_BITMAP_FOR_EACH_1 (idx, &sb) {
+        ovs_assert(i < ARRAY_SIZE(bits));
+        ovs_assert(idx == bits[i++]);
+    }
+    ovs_assert(i == ARRAY_SIZE(bits));
+
+    /* Scanning from any position finds the next bit. */
+    for (size_t start = 0, j = 0; start <= n_bits; start++) {
+        while (j < ARRAY_SIZE(bits) && bits[j] < start) {
+            j++;
+        }
+        ovs_assert(sparse_bitmap_scan(&sb, start)
+                   == (j < ARRAY_SIZE(bits) ? bits[j] : n_bits));
+    }
+
+    sparse_bitmap_destroy(&sb);
+}
+
+static void
+test_sparse_bitmap_convert(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    size_t sizes[] = {
+        1, BITMAP_ULONG_BITS, SPARSE_BITMAP_CHUNK_BITS - 1,
+        SPARSE_BITMAP_CHUNK_BITS, SPARSE_BITMAP_CHUNK_BITS + 1,
+        5 * SPARSE_BITMAP_CHUNK_BITS + 33,
+    };
+
+    random_set_seed(0x1234);
+    for (size_t i = 0; i < ARRAY_SIZE(sizes); i++) {
+        size_t n_bits = sizes[i];
+
+        /* Empty, full, sparse and dense bitmaps. */
+        for (unsigned int density = 0; density <= 4; density++) {
+            unsigned long *bitmap = bitmap_allocate(n_bits);
+            struct sparse_bitmap sb;
+
+            for (size_t j = 0; j < n_bits; j++) {
+                bool set = (density == 4 ? true
+                            : density == 0 ? false
+                            : random_range(16) < density * density);
+                bitmap_set(bitmap, j, set);
+            }
+
+            sparse_bitmap_init_from_bitmap(&sb, bitmap, n_bits);
+            check_equal_to_bitmap(&sb, bitmap, n_bits);
+            if (!density) {
+                ovs_assert(!n_allocated_chunks(&sb));
+            } else if (density == 4) {
+                ovs_assert(n_allocated_chunks(&sb)
+                           == DIV_ROUND_UP(n_bits, SPARSE_BITMAP_CHUNK_BITS));
+            }
+
+            /* Clearing all the bits frees all the chunks. */
+            for (size_t j = 0; j < n_bits; j++) {
+                sparse_bitmap_set0(&sb, j);
+            }
+            ovs_assert(!n_allocated_chunks(&sb));
+
+            sparse_bitmap_destroy(&sb);
+            bitmap_free(bitmap);
+        }
+    }
+}
+
+#define N_CONCURRENT_BITS (3 * SPARSE_BITMAP_CHUNK_BITS)
+
+struct thread_aux {
+    struct sparse_bitmap *sb;
+    unsigned int id;
+    unsigned int n_threads;
+    struct ovs_barrier *barrier;
+};
+
+/* Each thread sets every 'n_threads'th bit, so all the threads set bits in
+ * the same words and race to publish the same chunks. */
+static void *
+sparse_bitmap_thread(void *aux_)
+{
+    struct thread_aux *aux = aux_;
+
+    ovs_barrier_block(aux->barrier);
+    for (size_t i = aux->id; i < N_CONCURRENT_BITS; i += aux->n_threads) {
+        sparse_bitmap_or_word_concurrent(aux->sb, i / BITMAP_ULONG_BITS,
+                                         bitmap_bit__(i));
+        ovs_assert(sparse_bitmap_is_set(aux->sb, i));
+    }
+    return NULL;
+}
+
+static void
+test_sparse_bitmap_concurrent(struct ovs_cmdl_context *ctx)
+{
+    unsigned int n_threads, n_rounds;
+
+    if (!test_read_uint_value(ctx, 1, "n_threads", &n_threads)
+        || !test_read_uint_value(ctx, 2, "n_rounds", &n_rounds)) {
+        return;
+    }
+
+    pthread_t *threads = xmalloc(n_threads * sizeof *threads);
+    struct thread_aux *aux = xmalloc(n_threads * sizeof *aux);
+    struct ovs_barrier barrier;
+
+    ovs_barrier_init(&barrier, n_threads);
+    for (unsigned int round = 0; round < n_rounds; round++) {
+        struct sparse_bitmap sb;
+
+        sparse_bitmap_init(&sb, N_CONCURRENT_BITS);
+        for (unsigned int i = 0; i < n_threads; i++) {
+            aux[i] = (struct thread_aux) {
+                .sb = &sb,
+                .id = i,
+                .n_threads = n_threads,
+                .barrier = &barrier,
+            };
+            threads[i] = ovs_thread_create("sparse_bitmap_test",
+                                           sparse_bitmap_thread, &aux[i]);
+        }
+        for (unsigned int i = 0; i < n_threads; i++) {
+            xpthread_join(threads[i], NULL);
+        }
+
+        /* No bit and no chunk got lost. */
+        ovs_assert(sparse_bitmap_count1(&sb) == N_CONCURRENT_BITS);
+        ovs_assert(n_allocated_chunks(&sb) == 3);
+        sparse_bitmap_destroy(&sb);
+    }
+    ovs_barrier_destroy(&barrier);
+
+    free(aux);
+    free(threads);
+}
+
+static void
+test_sparse_bitmap_main(int argc, char *argv[])
+{
+    set_program_name(argv[0]);
+    static const struct ovs_cmdl_command commands[] = {
+        {"chunks", NULL, 0, 0, test_sparse_bitmap_chunks, OVS_RO},
+        {"scan", NULL, 0, 0, test_sparse_bitmap_scan, OVS_RO},
+        {"convert", NULL, 0, 0, test_sparse_bitmap_convert, OVS_RO},
+        {"concurrent", NULL, 2, 2, test_sparse_bitmap_concurrent, OVS_RO},
+        {NULL, NULL, 0, 0, NULL, OVS_RO},
+    };
+    struct ovs_cmdl_context ctx;
+    ctx.argc = argc - 1;
+    ctx.argv = argv + 1;
+    ovs_cmdl_run_command(&ctx, commands);
+}
+
+OVSTEST_REGISTER("test-sparse-bitmap", test_sparse_bitmap_main);
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2024, Red Hat, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include "hash.h"
+#include "openvswitch/thread.h"
+#include "ovs-thread.h"
+#include "util.h"
+
+#include "lib/string-pool.h"
+#include "tests/ovstest.h"
+#include "tests/test-utils.h"
+
+static size_t
+cache_slot(const char *s)
+{
+    return hash_bytes(s, strlen(s), 0) & (STRING_POOL_CACHE_SIZE - 1);
+}
+
+static void
+test_string_pool_refcount(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct string_pool *pool = string_pool_create();
+
+    /* Equal strings are interned once. */
+    char buf[] = "next;";
+    const char *a = string_pool_intern(pool, "next;");
+    const char *b = string_pool_intern(pool, buf);
+    ovs_assert(a == b);
+    ovs_assert(a != buf);
+    ovs_assert(!strcmp(a, "next;"));
+    ovs_assert(string_pool_count(pool) == 1);
+    ovs_assert(string_pool_lookup(pool, "next;") == a);
+    ovs_assert(!string_pool_lookup(pool, "drop;"));
+
+    const char *c = string_pool_intern(pool, "drop;");
+    ovs_assert(c != a);
+    ovs_assert(string_pool_count(pool) == 2);
+
+    /* A string stays in the pool until its last reference is released. */
+    string_pool_release(pool, a);
+    ovs_assert(string_pool_lookup(pool, "next;") == b);
+    string_pool_release(pool, b);
+    ovs_assert(!string_pool_lookup(pool, "next;"));
+    ovs_assert(string_pool_count(pool) == 1);
+
+    /* The empty string is a string like the others. */
+    const char *empty = string_pool_intern(pool, "");
+    ovs_assert(empty && !*empty);
+    ovs_assert(string_pool_count(pool) == 2);
+    string_pool_release(pool, empty);
+
+    ovs_assert(!string_pool_intern_nullable(pool, NULL));
+    string_pool_release(pool, NULL);
+
+    string_pool_release(pool, c);
+    ovs_assert(!string_pool_count(pool));
+    ovs_assert(!string_pool_bytes(pool));
+
+    string_pool_destroy(pool);
+}
+
+static void
+test_string_pool_shards(struct ovs_cmdl_context *ctx)
+{
+    unsigned int n_strings = 64 * STRING_POOL_N_SHARDS;
+
+    if (ctx->argc > 1
+        && !test_read_uint_value(ctx, 1, "n_strings", &n_strings)) {
+        return;
+    }
+
+    struct string_pool *pool = string_pool_create();
+    const char **strings = xmalloc(n_strings * sizeof *strings);
+
+    for (unsigned int i = 0; i < n_strings; i++) {
+        char *s = xasprintf("ip4.dst == 10.0.%u.%u", i / 256, i % 256);
+
+        strings[i] = string_pool_intern(pool, s);
+        free(s);
+    }
+    ovs_assert(string_pool_count(pool) == n_strings);
+
+    /* Every shard gets its share of the strings, with some slack for the
+     * hash distribution. */
+    size_t avg = n_strings / STRING_POOL_N_SHARDS;
+    size_t total = 0;
+    for (size_t i = 0; i < STRING_POOL_N_SHARDS; i++) {
+        size_t n = string_pool_shard_count(pool, i);
+
+        ovs_assert(n >= avg / 2);
+        ovs_assert(n <= 2 * avg);
+        total += n;
+    }
+    ovs_assert(total == n_strings);
+
+    for (unsigned int i = 0; i < n_strings; i++) {
+        string_pool_release(pool, strings[i]);
+    }
+    for (size_t i = 0; i < STRING_POOL_N_SHARDS; i++) {
+        ovs_assert(!string_pool_shard_count(pool, i));
+    }
+
+    free(strings);
+    string_pool_destroy(pool);
+}
+
+/* Returns a string that is different from 's' but uses the same cache
+ * slot. */
+static char *
+cache_slot_collision(const char *s)
+{
+    for (unsigned int i = 0; ; i++) {
+        char *t = xasprintf("collision-%u", i);
+
+        if (cache_slot(t) == cache_slot(s) && strcmp(t, s)) {
+            return t;
+        }
+        free(t);
+    }
+}
+
+static void
+test_string_pool_cache(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct string_pool *pool = string_pool_create();
+    struct string_pool_cache *cache = string_pool_cache_create(pool);
+
+    /* The cache keeps a reference to the strings it interned. */
+    const char *a = string_pool_cache_intern(cache, "next;");
+    ovs_assert(a == string_pool_lookup(pool, "next;"));
+    string_pool_release(pool, a);
+    ovs_assert(string_pool_lookup(pool, "next;") == a);
+
+    /* A cache hit references the same string again. */
+    const char *b = string_pool_cache_intern(cache, "next;");
+    ovs_assert(b == a);
+
+    /* Strings interned directly in the pool are the same as the ones
+     * interned through the cache. */
+    const char *c = string_pool_intern(pool, "next;");
+    ovs_assert(c == a);
+    string_pool_release(pool, c);
+
+    ovs_assert(!string_pool_cache_intern_nullable(cache, NULL));
+
+    /* A string using the same slot evicts "next;" from the cache, which
+     * releases its reference. */
+    char *collision = cache_slot_collision("next;");
+    const char *d = string_pool_cache_intern(cache, collision);
+    ovs_assert(d != a);
+    ovs_assert(!strcmp(d, collision));
+    ovs_assert(string_pool_count(pool) == 2);
+    string_pool_release(pool, b);
+    ovs_assert(!string_pool_lookup(pool, "next;"));
+    ovs_assert(string_pool_count(pool) == 1);
+
+    /* The cache keeps 'collision' alive after its last outside reference is
+     * released.  Interning "next;" again finds the slot holding the other
+     * string, interns "next;" in the pool and reuses the slot, releasing
+     * 'collision'. */
+    string_pool_release(pool, d);
+    ovs_assert(string_pool_lookup(pool, collision) == d);
+    const char *e = string_pool_intern(pool, "next;");
+    const char *f = string_pool_cache_intern(cache, "next;");
+    ovs_assert(f == e);
+    ovs_assert(!string_pool_lookup(pool, collision));
+    ovs_assert(string_pool_count(pool) == 1);
+
+    /* Destroying the cache drops its references. */
+    string_pool_release(pool, e);
+    string_pool_release(pool, f);
+    ovs_assert(string_pool_lookup(pool, "next;") == f);
+    string_pool_cache_destroy(cache);
+    ovs_assert(!string_pool_count(pool));
+
+    free(collision);
+    string_pool_destroy(pool);
+}
+
+#define N_THREAD_STRINGS 2000
+#define N_THREAD_ROUNDS 20
+
+struct thread_aux {
+    struct string_pool *pool;
+    unsigned int id;
+};
+
+/* Interns and releases the same strings over and over through a cache, as
+ * the threads of a parallel lflow build do, with every other string also
+ * interned directly in the pool. */
+static void *
+string_pool_thread(void *aux_)
+{
+    struct thread_aux *aux = aux_;
+    struct string_pool_cache *cache = string_pool_cache_create(aux->pool);
+    const char **strings = xmalloc(N_THREAD_STRINGS * sizeof *strings);
+
+    for (unsigned int round = 0; round < N_THREAD_ROUNDS; round++) {
+        for (unsigned int i = 0; i < N_THREAD_STRINGS; i++) {
+            /* Half of the strings are shared by all the threads. */
+            char *s = (i % 2
+                       ? xasprintf("shared-%u", i)
+                       : xasprintf("thread-%u-%u", aux->id, i));
+
+            strings[i] = (i % 4 == 1
+                          ? string_pool_intern(aux->pool, s)
+                          : string_pool_cache_intern(cache, s));
+            ovs_assert(!strcmp(strings[i], s));
+            free(s);
+        }
+        for (unsigned int i = 0; i < N_THREAD_STRINGS; i++) {
+            string_pool_release(aux->pool, strings[i]);
+        }
+    }
+
+    free(strings);
+    string_pool_cache_destroy(cache);
+    return NULL;
+}
+
+static void
+test_string_pool_threads(struct ovs_cmdl_context *ctx)
+{
+    unsigned int n_threads;
+
+    if (!test_read_uint_value(ctx, 1, "n_threads", &n_threads)) {
+        return;
+    }
+
+    struct string_pool *pool = string_pool_create();
+    pthread_t *threads = xmalloc(n_threads * sizeof *threads);
+    struct thread_aux *aux = xmalloc(n_threads * sizeof *aux);
+
+    for (unsigned int i = 0; i < n_threads; i++) {
+        aux[i].pool = pool;
+        aux[i].id = i;
+        threads[i] = ovs_thread_create("string_pool_test",
+                                       string_pool_thread, &aux[i]);
+    }
+    for (unsigned int i = 0; i < n_threads; i++) {
+        xpthread_join(threads[i], NULL);
+    }
+    ovs_assert(!string_pool_count(pool));
+
+    free(aux);
+    free(threads);
+    string_pool_destroy(pool);
+}
+
+static void
+test_string_pool_main(int argc, char *argv[])
+{
+    set_program_name(argv[0]);
+    static const struct ovs_cmdl_command commands[] = {
+        {"refcount", NULL, 0, 0, test_string_pool_refcount, OVS_RO},
+        {"shards", NULL, 0, 1, test_string_pool_shards, OVS_RO},
+        {"cache", NULL, 0, 0, test_string_pool_cache, OVS_RO},
+        {"threads", NULL, 1, 1, test_string_pool_threads, OVS_RO},
+        {NULL, NULL, 0, 0, NULL, OVS_RO},
+    };
+    struct ovs_cmdl_context ctx;
+    ctx.argc = argc - 1;
+    ctx.argv = argv + 1;
+    ovs_cmdl_run_command(&ctx, commands);
+}
+
+OVSTEST_REGISTER("test-string-pool", test_string_pool_main);
@@ -44,6 +44,13 @@ aging_waker_schedule_next_wake(struct aging_waker *waker, int64_t next_wake_ms)
     if (next_wake_ms < INT64_MAX) {
         waker->should_schedule = true;
         waker->next_wake_msec = time_msec() + next_wake_ms;
+    }
+}
+
+void
+aging_waker_wait(const struct aging_waker *waker)
+{
+    if (waker->should_schedule) {
         poll_timer_wait_until(waker->next_wake_msec);
     }
 }
@@ -376,7 +383,9 @@ mac_binding_aging_run_for_datapath(const struct sbrec_datapath_binding *dp,
     const struct sbrec_mac_binding *mb;
     SBREC_MAC_BINDING_FOR_EACH_EQUAL (mb, mb_index_row, mb_by_datapath) {
         if (aging_context_handle_timestamp(ctx, mb->timestamp, mb->ip)) {
+            engine_txn_lock();
             sbrec_mac_binding_delete(mb);
+            engine_txn_unlock();
             if (aging_context_is_at_limit(ctx)) {
                 break;
             }
@@ -514,7 +523,9 @@ fdb_run_for_datapath(const struct sbrec_datapath_binding *dp,
     const struct sbrec_fdb *fdb;
     SBREC_FDB_FOR_EACH_EQUAL (fdb, fdb_index_row, fdb_by_dp_key) {
         if (aging_context_handle_timestamp(ctx, fdb->timestamp, NULL)) {
+            engine_txn_lock();
             sbrec_fdb_delete(fdb);
+            engine_txn_unlock();
             if (aging_context_is_at_limit(ctx)) {
                 break;
             }
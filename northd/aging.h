@@ -18,6 +18,13 @@
 
 #include "lib/inc-proc-eng.h"
 
+struct aging_waker;
+
+/* Arms the poll loop timer for the next run of the aging node that
+ * scheduled 'waker'.  The aging nodes may run in the engine worker threads,
+ * so this must be called by the thread that runs the engine. */
+void aging_waker_wait(const struct aging_waker *waker);
+
 /* The MAC binding aging node functions. */
 void en_mac_binding_aging_run(struct engine_node *node, void *data);
 void *en_mac_binding_aging_init(struct engine_node *node,
@@ -5,6 +5,8 @@ northd_ovn_northd_SOURCES = \
 	northd/aging.h \
 	northd/debug.c \
 	northd/debug.h \
+	northd/dp-refcnts.c \
+	northd/dp-refcnts.h \
 	northd/northd.c \
 	northd/northd.h \
 	northd/ovn-northd.c \
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2024, Red Hat, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include "dp-refcnts.h"
+#include "util.h"
+
+void
+dp_refcnts_init(struct dp_refcnts *dp_refcnts)
+{
+    memset(dp_refcnts, 0, sizeof *dp_refcnts);
+}
+
+void
+dp_refcnts_destroy(struct dp_refcnts *dp_refcnts)
+{
+    free(dp_refcnts->array);
+    dp_refcnts_init(dp_refcnts);
+}
+
+static struct dp_refcnt *
+dp_refcnts_entries(const struct dp_refcnts *dp_refcnts)
+{
+    return dp_refcnts->array
+           ? dp_refcnts->array
+           : CONST_CAST(struct dp_refcnt *, dp_refcnts->inline_refcnts);
+}
+
+/* Returns the position of 'dp_index' in the sorted 'dp_refcnts', or the
+ * position where it should be inserted if it's not there. */
+static size_t
+dp_refcnts_bsearch(const struct dp_refcnts *dp_refcnts, size_t dp_index)
+{
+    const struct dp_refcnt *entries = dp_refcnts_entries(dp_refcnts);
+    size_t low = 0, high = dp_refcnts->n;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+
+        if (entries[mid].dp_index < dp_index) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/* Counts one more use of the datapath 'dp_index', that is already used by
+ * the lflow. */
+void
+dp_refcnt_use(struct dp_refcnts *dp_refcnts, size_t dp_index)
+{
+    size_t pos = dp_refcnts_bsearch(dp_refcnts, dp_index);
+    struct dp_refcnt *entries = dp_refcnts_entries(dp_refcnts);
+
+    if (pos < dp_refcnts->n && entries[pos].dp_index == dp_index) {
+        /* A released counter is created again on the second use. */
+        entries[pos].refcnt = entries[pos].refcnt ? entries[pos].refcnt + 1
+                                                  : 2;
+        return;
+    }
+
+    if (!dp_refcnts->array && dp_refcnts->n == DP_REFCNTS_N_INLINE) {
+        /* Move the inline counters to the heap. */
+        dp_refcnts->allocated = 2 * DP_REFCNTS_N_INLINE;
+        dp_refcnts->array = xmalloc(dp_refcnts->allocated
+                                    * sizeof *dp_refcnts->array);
+        memcpy(dp_refcnts->array, dp_refcnts->inline_refcnts,
+               sizeof dp_refcnts->inline_refcnts);
+    } else if (dp_refcnts->array
+               && dp_refcnts->n == dp_refcnts->allocated) {
+        dp_refcnts->allocated *= 2;
+        dp_refcnts->array = xrealloc(dp_refcnts->array,
+                                     dp_refcnts->allocated
+                                     * sizeof *dp_refcnts->array);
+    }
+    entries = dp_refcnts_entries(dp_refcnts);
+
+    memmove(&entries[pos + 1], &entries[pos],
+            (dp_refcnts->n - pos) * sizeof *entries);
+    entries[pos].dp_index = dp_index;
+    /* The counter is created on the second (!) use. */
+    entries[pos].refcnt = 2;
+    dp_refcnts->n++;
+}
+
+/* Decrements the datapath's refcnt in 'dp_refcnts' if it exists and returns
+ * true if the refcnt is 0 or if the dp refcnt doesn't exist.
+ *
+ * A counter that drops to 0 is only removed by dp_refcnts_compact(), which
+ * the caller should call once it is done releasing counters. */
+bool
+dp_refcnt_release(struct dp_refcnts *dp_refcnts, size_t dp_index)
+{
+    size_t pos = dp_refcnts_bsearch(dp_refcnts, dp_index);
+    struct dp_refcnt *entries = dp_refcnts_entries(dp_refcnts);
+
+    if (pos == dp_refcnts->n || entries[pos].dp_index != dp_index
+        || !entries[pos].refcnt) {
+        return true;
+    }
+
+    return !--entries[pos].refcnt;
+}
+
+/* Removes the released counters from 'dp_refcnts', in a single pass. */
+void
+dp_refcnts_compact(struct dp_refcnts *dp_refcnts)
+{
+    struct dp_refcnt *entries = dp_refcnts_entries(dp_refcnts);
+    size_t n = 0;
+
+    for (size_t i = 0; i < dp_refcnts->n; i++) {
+        if (entries[i].refcnt) {
+            entries[n++] = entries[i];
+        }
+    }
+    dp_refcnts->n = n;
+
+    if (!dp_refcnts->n && dp_refcnts->array) {
+        dp_refcnts_destroy(dp_refcnts);
+    }
+}
+
+/* Returns the reference counter of 'dp_index', or 0 if it has none. */
+uint32_t
+dp_refcnt_get(const struct dp_refcnts *dp_refcnts, size_t dp_index)
+{
+    size_t pos = dp_refcnts_bsearch(dp_refcnts, dp_index);
+    const struct dp_refcnt *entries = dp_refcnts_entries(dp_refcnts);
+
+    return (pos < dp_refcnts->n && entries[pos].dp_index == dp_index
+            ? entries[pos].refcnt
+            : 0);
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2024, Red Hat, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NORTHD_DP_REFCNTS_H
+#define NORTHD_DP_REFCNTS_H 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Used for the datapath reference counting for a given 'struct ovn_lflow'.
+ * See 'dp_refcnts' in 'struct ovn_lflow'.
+ * For a given lflow L(M, A) with match - M and actions - A, it can be
+ * referenced by multiple lflow_refs for the same datapath
+ * Eg. Two lflow_ref's - op->lflow_ref and op->stateful_lflow_ref of a
+ * datapath can have a reference to the same lflow L (M, A).  In this it
+ * is important to maintain this reference count so that the sync to the
+ * SB DB logical_flow is correct. */
+struct dp_refcnt {
+    uint32_t dp_index; /* datapath index. */
+    uint32_t refcnt;   /* reference counter, 0 if released. */
+};
+
+/* Number of 'struct dp_refcnt' stored without a heap allocation. */
+#define DP_REFCNTS_N_INLINE 2
+
+/* Set of 'struct dp_refcnt', sorted by 'dp_index'.  Most lflows have no
+ * reference counters at all, and most of the others have one or two, so
+ * these are stored inline.  Larger sets move to the heap allocated
+ * 'array', which is kept until the set gets empty.
+ *
+ * A counter that drops to zero stays in the set, as a released counter,
+ * until dp_refcnts_compact().  This way releasing the counters of many
+ * datapaths doesn't move the rest of the array every time. */
+struct dp_refcnts {
+    uint32_t n;                 /* Number of reference counters. */
+    uint32_t allocated;         /* Capacity of 'array'. */
+    struct dp_refcnt *array;    /* If nonnull, holds all the counters. */
+    struct dp_refcnt inline_refcnts[DP_REFCNTS_N_INLINE];
+};
+
+void dp_refcnts_init(struct dp_refcnts *);
+void dp_refcnts_destroy(struct dp_refcnts *);
+
+void dp_refcnt_use(struct dp_refcnts *, size_t dp_index);
+bool dp_refcnt_release(struct dp_refcnts *, size_t dp_index);
+void dp_refcnts_compact(struct dp_refcnts *);
+
+uint32_t dp_refcnt_get(const struct dp_refcnts *, size_t dp_index);
+
+#endif /* northd/dp-refcnts.h */
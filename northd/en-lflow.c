@@ -147,6 +147,13 @@ lflow_northd_handler(struct engine_node *node,
         return false;
     }
 
+    if (northd_has_lr_routes_in_tracked_data(&northd_data->trk_data)
+        && !lflow_handle_northd_lr_route_changes(
+               eng_ctx->ovnsb_idl_txn, &northd_data->trk_data.trk_route_lrs,
+               &lflow_input, lflow_data->lflow_table)) {
+        return false;
+    }
+
     engine_set_node_state(node, EN_UPDATED);
     return true;
 }
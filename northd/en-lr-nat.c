@@ -28,6 +28,7 @@
 
 /* OVN includes */
 #include "en-lr-nat.h"
+#include "lib/arena.h"
 #include "lib/inc-proc-eng.h"
 #include "lib/lb.h"
 #include "lib/ovn-nb-idl.h"
@@ -39,7 +40,7 @@
 VLOG_DEFINE_THIS_MODULE(en_lr_nat);
 
 /* Static function declarations. */
-static void lr_nat_table_init(struct lr_nat_table *);
+static void lr_nat_table_init(struct lr_nat_table *, struct arena *);
 static void lr_nat_table_clear(struct lr_nat_table *);
 static void lr_nat_table_destroy(struct lr_nat_table *);
 static void lr_nat_table_build(struct lr_nat_table *,
@@ -54,7 +55,6 @@ static void lr_nat_record_init(struct lr_nat_record *,
 static void lr_nat_record_clear(struct lr_nat_record *);
 static void lr_nat_record_reinit(struct lr_nat_record *,
                                  const struct ovn_datapath *);
-static void lr_nat_record_destroy(struct lr_nat_record *);
 
 static bool get_force_snat_ip(const struct ovn_datapath *,
                               const char *key_type,
@@ -73,11 +73,11 @@ lr_nat_table_find_by_index(const struct lr_nat_table *table,
 /* 'lr_nat' engine node manages the NB logical router NAT data.
  */
 void *
-en_lr_nat_init(struct engine_node *node OVS_UNUSED,
+en_lr_nat_init(struct engine_node *node,
                struct engine_arg *arg OVS_UNUSED)
 {
     struct ed_type_lr_nat_data *data = xzalloc(sizeof *data);
-    lr_nat_table_init(&data->lr_nats);
+    lr_nat_table_init(&data->lr_nats, engine_node_enable_arena(node));
     hmapx_init(&data->trk_data.crupdated);
     return data;
 }
@@ -148,10 +148,11 @@ lr_nat_northd_handler(struct engine_node *node, void *data_)
 
 /* static functions. */
 static void
-lr_nat_table_init(struct lr_nat_table *table)
+lr_nat_table_init(struct lr_nat_table *table, struct arena *arena)
 {
     *table = (struct lr_nat_table) {
         .entries = HMAP_INITIALIZER(&table->entries),
+        .arena = arena,
     };
 }
 
@@ -160,8 +161,9 @@ lr_nat_table_clear(struct lr_nat_table *table)
 {
     struct lr_nat_record *lrnat_rec;
     HMAP_FOR_EACH_POP (lrnat_rec, key_node, &table->entries) {
-        lr_nat_record_destroy(lrnat_rec);
+        lr_nat_record_clear(lrnat_rec);
     }
+    arena_reset(table->arena);
 
     free(table->array);
     table->array = NULL;
@@ -202,7 +204,8 @@ lr_nat_record_create(struct lr_nat_table *table,
 {
     ovs_assert(od->nbr);
 
-    struct lr_nat_record *lrnat_rec = xzalloc(sizeof *lrnat_rec);
+    struct lr_nat_record *lrnat_rec =
+        arena_zalloc(table->arena, sizeof *lrnat_rec);
     lr_nat_record_init(lrnat_rec, od);
 
     hmap_insert(&table->entries, &lrnat_rec->key_node,
@@ -350,13 +353,6 @@ lr_nat_record_reinit(struct lr_nat_record *lrnat_rec,
     lr_nat_record_init(lrnat_rec, od);
 }
 
-static void
-lr_nat_record_destroy(struct lr_nat_record *lrnat_rec)
-{
-    lr_nat_record_clear(lrnat_rec);
-    free(lrnat_rec);
-}
-
 static void
 snat_ip_add(struct lr_nat_record *lrnat_rec, const char *ip,
             struct ovn_nat *nat_entry)
@@ -85,6 +85,9 @@ struct lr_nat_table {
 
     /* The array index of each element in 'entries'. */
     struct lr_nat_record **array;
+
+    /* The records are allocated from the engine node's arena. */
+    struct arena *arena;
 };
 
 const struct lr_nat_record * lr_nat_table_find_by_index(
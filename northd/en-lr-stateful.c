@@ -34,6 +34,7 @@
 #include "en-lr-nat.h"
 #include "en-lr-stateful.h"
 #include "lb.h"
+#include "lib/arena.h"
 #include "lib/inc-proc-eng.h"
 #include "lib/lb.h"
 #include "lib/ovn-nb-idl.h"
@@ -46,7 +47,8 @@
 VLOG_DEFINE_THIS_MODULE(en_lr_stateful);
 
 /* Static function declarations. */
-static void lr_stateful_table_init(struct lr_stateful_table *);
+static void lr_stateful_table_init(struct lr_stateful_table *,
+                                   struct arena *);
 static void lr_stateful_table_clear(struct lr_stateful_table *);
 static void lr_stateful_table_destroy(struct lr_stateful_table *);
 static struct lr_stateful_record *lr_stateful_table_find_(
@@ -68,7 +70,7 @@ static struct lr_stateful_record *lr_stateful_record_create(
     const struct ovn_datapath *od,
     const struct hmap *lb_datapaths_map,
     const struct hmap *lbgrp_datapaths_map);
-static void lr_stateful_record_destroy(struct lr_stateful_record *);
+static void lr_stateful_record_clear(struct lr_stateful_record *);
 
 static void build_lrouter_lb_reachable_ips(struct lr_stateful_record *,
                                            const struct ovn_datapath *,
@@ -86,11 +88,11 @@ static void remove_lrouter_lb_reachable_ips(struct lr_stateful_record *,
 /* 'lr_stateful' engine node manages the NB logical router LB data.
  */
 void *
-en_lr_stateful_init(struct engine_node *node OVS_UNUSED,
+en_lr_stateful_init(struct engine_node *node,
                     struct engine_arg *arg OVS_UNUSED)
 {
     struct ed_type_lr_stateful *data = xzalloc(sizeof *data);
-    lr_stateful_table_init(&data->table);
+    lr_stateful_table_init(&data->table, engine_node_enable_arena(node));
     hmapx_init(&data->trk_data.crupdated);
     return data;
 }
@@ -373,10 +375,11 @@ lr_stateful_table_find_by_index(const struct lr_stateful_table *table,
 
 /* static functions. */
 static void
-lr_stateful_table_init(struct lr_stateful_table *table)
+lr_stateful_table_init(struct lr_stateful_table *table, struct arena *arena)
 {
     *table = (struct lr_stateful_table) {
         .entries = HMAP_INITIALIZER(&table->entries),
+        .arena = arena,
     };
 }
 
@@ -392,8 +395,9 @@ lr_stateful_table_clear(struct lr_stateful_table *table)
 {
     struct lr_stateful_record *lr_stateful_rec;
     HMAP_FOR_EACH_POP (lr_stateful_rec, key_node, &table->entries) {
-        lr_stateful_record_destroy(lr_stateful_rec);
+        lr_stateful_record_clear(lr_stateful_rec);
     }
+    arena_reset(table->arena);
 
     free(table->array);
     table->array = NULL;
@@ -448,7 +452,7 @@ lr_stateful_record_create(struct lr_stateful_table *table,
                          const struct hmap *lbgrp_datapaths_map)
 {
     struct lr_stateful_record *lr_stateful_rec =
-        xzalloc(sizeof *lr_stateful_rec);
+        arena_zalloc(table->arena, sizeof *lr_stateful_rec);
     lr_stateful_rec->nbr_uuid = od->nbr->header_.uuid;
     lr_stateful_rec->lrnat_rec = lrnat_rec;
     lr_stateful_rec->lr_index = od->index;
@@ -532,11 +536,10 @@ lr_stateful_record_create(struct lr_stateful_table *table,
 }
 
 static void
-lr_stateful_record_destroy(struct lr_stateful_record *lr_stateful_rec)
+lr_stateful_record_clear(struct lr_stateful_record *lr_stateful_rec)
 {
     ovn_lb_ip_set_destroy(lr_stateful_rec->lb_ips);
     lflow_ref_destroy(lr_stateful_rec->lflow_ref);
-    free(lr_stateful_rec);
 }
 
 static struct lr_stateful_input
@@ -92,6 +92,9 @@ struct lr_stateful_table {
 
     /* The array index of each element in 'entries'. */
     struct lr_stateful_record **array;
+
+    /* The records are allocated from the engine node's arena. */
+    struct arena *arena;
 };
 
 #define LR_STATEFUL_TABLE_FOR_EACH(LR_LB_NAT_REC, TABLE) \
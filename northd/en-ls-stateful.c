@@ -33,6 +33,7 @@
 #include "en-lb-data.h"
 #include "en-ls-stateful.h"
 #include "en-port-group.h"
+#include "lib/arena.h"
 #include "lib/inc-proc-eng.h"
 #include "lib/lb.h"
 #include "lib/ovn-nb-idl.h"
@@ -45,7 +46,8 @@
 VLOG_DEFINE_THIS_MODULE(en_ls_stateful);
 
 /* Static function declarations. */
-static void ls_stateful_table_init(struct ls_stateful_table *);
+static void ls_stateful_table_init(struct ls_stateful_table *,
+                                   struct arena *);
 static void ls_stateful_table_clear(struct ls_stateful_table *);
 static void ls_stateful_table_destroy(struct ls_stateful_table *);
 static struct ls_stateful_record *ls_stateful_table_find_(
@@ -61,7 +63,7 @@ static struct ls_stateful_record *ls_stateful_record_create(
     struct ls_stateful_table *,
     const struct ovn_datapath *,
     const struct ls_port_group_table *);
-static void ls_stateful_record_destroy(struct ls_stateful_record *);
+static void ls_stateful_record_clear(struct ls_stateful_record *);
 static void ls_stateful_record_init(
     struct ls_stateful_record *,
     const struct ovn_datapath *,
@@ -89,11 +91,11 @@ struct ls_stateful_input {
 
 /* public functions. */
 void *
-en_ls_stateful_init(struct engine_node *node OVS_UNUSED,
+en_ls_stateful_init(struct engine_node *node,
                     struct engine_arg *arg OVS_UNUSED)
 {
     struct ed_type_ls_stateful *data = xzalloc(sizeof *data);
-    ls_stateful_table_init(&data->table);
+    ls_stateful_table_init(&data->table, engine_node_enable_arena(node));
     hmapx_init(&data->trk_data.crupdated);
     return data;
 }
@@ -213,7 +215,8 @@ ls_stateful_port_group_handler(struct engine_node *node, void *data_)
 
         if ((had_stateful_acl != ls_stateful_rec->has_stateful_acl)
             || (had_acls != ls_stateful_rec->has_acls)
-            || max_acl_tier != ls_stateful_rec->max_acl_tier) {
+            || max_acl_tier != ls_stateful_rec->max_acl_tier
+            || hmapx_contains(&pg_data->ls_with_changed_acls, ls_pg->nbs)) {
             modified = true;
         }
 
@@ -231,10 +234,11 @@ ls_stateful_port_group_handler(struct engine_node *node, void *data_)
 
 /* static functions. */
 static void
-ls_stateful_table_init(struct ls_stateful_table *table)
+ls_stateful_table_init(struct ls_stateful_table *table, struct arena *arena)
 {
     *table = (struct ls_stateful_table) {
         .entries = HMAP_INITIALIZER(&table->entries),
+        .arena = arena,
     };
 }
 
@@ -250,8 +254,9 @@ ls_stateful_table_clear(struct ls_stateful_table *table)
 {
     struct ls_stateful_record *ls_stateful_rec;
     HMAP_FOR_EACH_POP (ls_stateful_rec, key_node, &table->entries) {
-        ls_stateful_record_destroy(ls_stateful_rec);
+        ls_stateful_record_clear(ls_stateful_rec);
     }
+    arena_reset(table->arena);
 }
 
 static void
@@ -286,7 +291,7 @@ ls_stateful_record_create(struct ls_stateful_table *table,
                           const struct ls_port_group_table *ls_pgs)
 {
     struct ls_stateful_record *ls_stateful_rec =
-        xzalloc(sizeof *ls_stateful_rec);
+        arena_zalloc(table->arena, sizeof *ls_stateful_rec);
     ls_stateful_rec->ls_index = od->index;
     ls_stateful_rec->nbs_uuid = od->nbs->header_.uuid;
     ls_stateful_record_init(ls_stateful_rec, od, NULL, ls_pgs);
@@ -299,10 +304,9 @@ ls_stateful_record_create(struct ls_stateful_table *table,
 }
 
 static void
-ls_stateful_record_destroy(struct ls_stateful_record *ls_stateful_rec)
+ls_stateful_record_clear(struct ls_stateful_record *ls_stateful_rec)
 {
     lflow_ref_destroy(ls_stateful_rec->lflow_ref);
-    free(ls_stateful_rec);
 }
 
 static void
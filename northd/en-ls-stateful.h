@@ -75,6 +75,9 @@ struct ls_stateful_record {
 
 struct ls_stateful_table {
     struct hmap entries;
+
+    /* The records are allocated from the engine node's arena. */
+    struct arena *arena;
 };
 
 #define LS_STATEFUL_TABLE_FOR_EACH(LS_STATEFUL_REC, TABLE) \
@@ -79,6 +79,29 @@ en_sync_meters_run(struct engine_node *node, void *data_)
     engine_set_node_state(node, EN_UPDATED);
 }
 
+/* ACLs only matter to this node if they log with a meter, because every ACL
+ * that logs with a fair meter gets its own copy of the meter in the SB.
+ * Changes to any other ACL are ignored. */
+bool
+sync_meters_nb_acl_handler(struct engine_node *node, void *data OVS_UNUSED)
+{
+    const struct nbrec_acl_table *acl_table =
+        EN_OVSDB_GET(engine_get_input("NB_acl", node));
+    const struct nbrec_acl *acl;
+
+    NBREC_ACL_TABLE_FOR_EACH_TRACKED (acl, acl_table) {
+        if (nbrec_acl_is_new(acl) || nbrec_acl_is_deleted(acl)) {
+            if (acl->log && acl->meter) {
+                return false;
+            }
+        } else if (nbrec_acl_is_updated(acl, NBREC_ACL_COL_LOG)
+                   || nbrec_acl_is_updated(acl, NBREC_ACL_COL_METER)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 const struct nbrec_meter*
 fair_meter_lookup_by_name(const struct shash *meter_groups,
                           const char *meter_name)
@@ -176,6 +176,149 @@ northd_sb_port_binding_handler(struct engine_node *node,
     return true;
 }
 
+/* Only the name, hostname, encapsulation types and other_config of a
+ * chassis are used by northd.  Changes to the other columns, e.g. nb_cfg
+ * or external_ids, are ignored. */
+bool
+northd_sb_chassis_handler(struct engine_node *node, void *data OVS_UNUSED)
+{
+    const struct sbrec_chassis_table *sbrec_chassis_table =
+        EN_OVSDB_GET(engine_get_input("SB_chassis", node));
+    const struct sbrec_chassis *chassis;
+
+    SBREC_CHASSIS_TABLE_FOR_EACH_TRACKED (chassis, sbrec_chassis_table) {
+        if (sbrec_chassis_is_new(chassis)
+            || sbrec_chassis_is_deleted(chassis)
+            || sbrec_chassis_is_updated(chassis, SBREC_CHASSIS_COL_NAME)
+            || sbrec_chassis_is_updated(chassis, SBREC_CHASSIS_COL_HOSTNAME)
+            || sbrec_chassis_is_updated(chassis, SBREC_CHASSIS_COL_ENCAPS)
+            || sbrec_chassis_is_updated(chassis,
+                                        SBREC_CHASSIS_COL_OTHER_CONFIG)) {
+            return false;
+        }
+
+        for (size_t i = 0; i < chassis->n_encaps; i++) {
+            if (sbrec_encap_row_get_seqno(chassis->encaps[i],
+                                          OVSDB_IDL_CHANGE_MODIFY) > 0
+                && sbrec_encap_is_updated(chassis->encaps[i],
+                                          SBREC_ENCAP_COL_TYPE)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool
+northd_sb_fdb_handler(struct engine_node *node, void *data)
+{
+    struct northd_data *nd = data;
+    const struct sbrec_fdb_table *sbrec_fdb_table =
+        EN_OVSDB_GET(engine_get_input("SB_fdb", node));
+
+    return northd_handle_sb_fdb_changes(sbrec_fdb_table,
+                                        &nd->ls_datapaths.datapaths);
+}
+
+/* The service monitors are created and updated by northd, ovn-controller
+ * only updates their 'status', which affects the load balancer backends. */
+bool
+northd_sb_service_monitor_handler(struct engine_node *node,
+                                  void *data OVS_UNUSED)
+{
+    const struct sbrec_service_monitor_table *sbrec_svc_monitor_table =
+        EN_OVSDB_GET(engine_get_input("SB_service_monitor", node));
+    const struct sbrec_service_monitor *svc_mon;
+
+    SBREC_SERVICE_MONITOR_TABLE_FOR_EACH_TRACKED (svc_mon,
+                                                  sbrec_svc_monitor_table) {
+        if (sbrec_service_monitor_is_deleted(svc_mon)
+            || (!sbrec_service_monitor_is_new(svc_mon)
+                && sbrec_service_monitor_is_updated(
+                       svc_mon, SBREC_SERVICE_MONITOR_COL_STATUS))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* The HA_Chassis_Group, DNS and IP_Multicast tables are only written by
+ * northd.  Inserted and updated rows are the notification of northd's own
+ * transactions and don't need to be handled.  Fall back to recompute for
+ * deleted rows, so that rows that are still needed get recreated. */
+bool
+northd_sb_ha_chassis_group_handler(struct engine_node *node,
+                                   void *data OVS_UNUSED)
+{
+    const struct sbrec_ha_chassis_group_table *sbrec_ha_chassis_group_table =
+        EN_OVSDB_GET(engine_get_input("SB_ha_chassis_group", node));
+    const struct sbrec_ha_chassis_group *sb_ha_chassis_group;
+
+    SBREC_HA_CHASSIS_GROUP_TABLE_FOR_EACH_TRACKED (
+            sb_ha_chassis_group, sbrec_ha_chassis_group_table) {
+        if (sbrec_ha_chassis_group_is_deleted(sb_ha_chassis_group)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+northd_sb_dns_handler(struct engine_node *node, void *data OVS_UNUSED)
+{
+    const struct sbrec_dns_table *sbrec_dns_table =
+        EN_OVSDB_GET(engine_get_input("SB_dns", node));
+    const struct sbrec_dns *sb_dns;
+
+    SBREC_DNS_TABLE_FOR_EACH_TRACKED (sb_dns, sbrec_dns_table) {
+        if (sbrec_dns_is_deleted(sb_dns)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+northd_sb_ip_multicast_handler(struct engine_node *node,
+                               void *data OVS_UNUSED)
+{
+    const struct sbrec_ip_multicast_table *sbrec_ip_multicast_table =
+        EN_OVSDB_GET(engine_get_input("SB_ip_multicast", node));
+    const struct sbrec_ip_multicast *sb_ip_multicast;
+
+    SBREC_IP_MULTICAST_TABLE_FOR_EACH_TRACKED (sb_ip_multicast,
+                                               sbrec_ip_multicast_table) {
+        if (sbrec_ip_multicast_is_deleted(sb_ip_multicast)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* The Mirror table is only written by northd too, but the Port_Bindings
+ * reference the SB Mirrors by row: build_ports() looks the SB Mirror of an
+ * attached NB mirror up before sync_mirrors() inserts it, so a mirror that
+ * is created and attached in the same transaction, or an SB Mirror that is
+ * recreated, is only set in the Port_Binding's 'mirror_rules' by the next
+ * recompute.  Fall back to recompute for inserted and deleted rows. */
+bool
+northd_sb_mirror_handler(struct engine_node *node, void *data OVS_UNUSED)
+{
+    const struct sbrec_mirror_table *sbrec_mirror_table =
+        EN_OVSDB_GET(engine_get_input("SB_mirror", node));
+    const struct sbrec_mirror *sb_mirror;
+
+    SBREC_MIRROR_TABLE_FOR_EACH_TRACKED (sb_mirror, sbrec_mirror_table) {
+        if (sbrec_mirror_is_new(sb_mirror)
+            || sbrec_mirror_is_deleted(sb_mirror)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool
 northd_nb_logical_router_handler(struct engine_node *node,
                                  void *data)
@@ -18,6 +18,13 @@ bool northd_global_config_handler(struct engine_node *, void *data OVS_UNUSED);
 bool northd_nb_logical_switch_handler(struct engine_node *, void *data);
 bool northd_nb_logical_router_handler(struct engine_node *, void *data);
 bool northd_sb_port_binding_handler(struct engine_node *, void *data);
+bool northd_sb_chassis_handler(struct engine_node *, void *data);
+bool northd_sb_fdb_handler(struct engine_node *, void *data);
+bool northd_sb_service_monitor_handler(struct engine_node *, void *data);
+bool northd_sb_ha_chassis_group_handler(struct engine_node *, void *data);
+bool northd_sb_dns_handler(struct engine_node *, void *data);
+bool northd_sb_ip_multicast_handler(struct engine_node *, void *data);
+bool northd_sb_mirror_handler(struct engine_node *, void *data);
 bool northd_lb_data_handler(struct engine_node *, void *data);
 
 #endif /* EN_NORTHD_H */
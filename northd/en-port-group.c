@@ -463,6 +463,7 @@ en_port_group_init(struct engine_node *node OVS_UNUSED,
 
     ls_port_group_table_init(&pg_data->ls_port_groups);
     port_group_ls_table_init(&pg_data->port_groups_lses);
+    hmapx_init(&pg_data->ls_with_changed_acls);
     return pg_data;
 }
 
@@ -473,6 +474,7 @@ en_port_group_cleanup(void *data_)
 
     ls_port_group_table_destroy(&data->ls_port_groups);
     port_group_ls_table_destroy(&data->port_groups_lses);
+    hmapx_destroy(&data->ls_with_changed_acls);
 }
 
 void
@@ -481,6 +483,7 @@ en_port_group_clear_tracked_data(void *data_)
     struct port_group_data *data = data_;
 
     data->ls_port_groups_sets_changed = true;
+    hmapx_clear(&data->ls_with_changed_acls);
 }
 
 void
@@ -508,6 +511,22 @@ en_port_group_run(struct engine_node *node, void *data_)
     engine_set_node_state(node, EN_UPDATED);
 }
 
+static bool
+is_pg_acls_changed(const struct nbrec_port_group *nb_pg)
+{
+    if (nbrec_port_group_is_updated(nb_pg, NBREC_PORT_GROUP_COL_ACLS)) {
+        return true;
+    }
+
+    for (size_t i = 0; i < nb_pg->n_acls; i++) {
+        if (nbrec_acl_row_get_seqno(nb_pg->acls[i],
+                                    OVSDB_IDL_CHANGE_MODIFY) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool
 port_group_nb_port_group_handler(struct engine_node *node, void *data_)
 {
@@ -576,6 +595,24 @@ port_group_nb_port_group_handler(struct engine_node *node, void *data_)
             }
         }
         ds_destroy(&sb_pg_name);
+
+        /* Track the switches that need their ACL flows regenerated. */
+        NBREC_PORT_GROUP_TABLE_FOR_EACH_TRACKED (nb_pg, nb_pg_table) {
+            if (!is_pg_acls_changed(nb_pg)) {
+                continue;
+            }
+
+            struct port_group_ls_record *pg_ls =
+                port_group_ls_table_find(&data->port_groups_lses, nb_pg);
+            if (!pg_ls) {
+                continue;
+            }
+
+            struct hmapx_node *hmapx_node;
+            HMAPX_FOR_EACH (hmapx_node, &pg_ls->switches) {
+                hmapx_add(&data->ls_with_changed_acls, hmapx_node->data);
+            }
+        }
     }
 
     data->ls_port_groups_sets_changed = !success;
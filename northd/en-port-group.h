@@ -105,6 +105,10 @@ struct port_group_data {
     struct ls_port_group_table ls_port_groups;
     struct port_group_ls_table port_groups_lses;
     bool ls_port_groups_sets_changed;
+
+    /* Logical switches ('struct nbrec_logical_switch *') with ports in a
+     * port group whose ACLs were added, deleted or updated. */
+    struct hmapx ls_with_changed_acls;
 };
 
 void *en_port_group_init(struct engine_node *, struct engine_arg *);
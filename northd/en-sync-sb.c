@@ -33,6 +33,7 @@
 #include "lib/ovn-nb-idl.h"
 #include "lib/ovn-sb-idl.h"
 #include "lib/ovn-util.h"
+#include "lib/sparse-bitmap.h"
 #include "lflow-mgr.h"
 #include "northd.h"
 
@@ -435,10 +436,12 @@ sync_addr_set(struct ovsdb_idl_txn *ovnsb_txn, const char *name,
     sb_address_set = shash_find_and_delete(sb_address_sets,
                                            name);
     if (!sb_address_set) {
+        engine_txn_lock();
         sb_address_set = sbrec_address_set_insert(ovnsb_txn);
         sbrec_address_set_set_name(sb_address_set, name);
         sbrec_address_set_set_addresses(sb_address_set, addresses->arr,
                                         addresses->n);
+        engine_txn_unlock();
     } else {
         update_sb_addr_set(addresses, sb_address_set);
     }
@@ -552,10 +555,12 @@ sync_addr_sets(struct ovsdb_idl_txn *ovnsb_txn,
     }
 
     struct shash_node *node;
+    engine_txn_lock();
     SHASH_FOR_EACH_SAFE (node, &sb_address_sets) {
         sbrec_address_set_delete(node->data);
         shash_delete(&sb_address_sets, node);
     }
+    engine_txn_unlock();
     shash_destroy(&sb_address_sets);
 }
 
@@ -576,8 +581,10 @@ update_sb_addr_set(struct sorted_array *nb_addresses,
 {
     struct sorted_array sb_addresses =
         sorted_array_from_dbrec(sb_as, addresses);
+    engine_txn_lock();
     sorted_array_apply_diff(nb_addresses, &sb_addresses,
                             sb_addr_set_apply_diff, sb_as);
+    engine_txn_unlock();
     sorted_array_destroy(&sb_addresses);
 }
 
@@ -693,16 +700,20 @@ sb_lb_table_build_and_sync(
         const char *nb_lb_uuid = smap_get(&sbrec_lb->external_ids, "lb_id");
         struct uuid lb_uuid;
         if (!nb_lb_uuid || !uuid_from_string(&lb_uuid, nb_lb_uuid)) {
+            engine_txn_lock();
             sbrec_load_balancer_delete(sbrec_lb);
+            engine_txn_unlock();
             continue;
         }
 
         sb_lb = sb_lb_table_find(&tmp_sb_lbs, &lb_uuid);
         if (sb_lb) {
             sb_lb->sbrec_lb = sbrec_lb;
+            engine_txn_lock();
             bool success = sync_sb_lb_record(sb_lb, sbrec_lb, sb_dpgrp_table,
                                              sb_lbs, ovnsb_txn, ls_datapaths,
                                              lr_datapaths, chassis_features);
+            engine_txn_unlock();
             /* Since we are rebuilding and syncing,  sync_sb_lb_record should
              * not return false. */
             ovs_assert(success);
@@ -711,14 +722,18 @@ sb_lb_table_build_and_sync(
             hmap_insert(&sb_lbs->entries, &sb_lb->key_node,
                         uuid_hash(&sb_lb->lb_dps->lb->nlb->header_.uuid));
         } else {
+            engine_txn_lock();
             sbrec_load_balancer_delete(sbrec_lb);
+            engine_txn_unlock();
         }
     }
 
     HMAP_FOR_EACH_POP (sb_lb, key_node, &tmp_sb_lbs) {
+        engine_txn_lock();
         bool success = sync_sb_lb_record(sb_lb, NULL, sb_dpgrp_table, sb_lbs,
                                          ovnsb_txn, ls_datapaths, lr_datapaths,
                                          chassis_features);
+        engine_txn_unlock();
         /* Since we are rebuilding and syncing,  sync_sb_lb_record should not
          * return false. */
         ovs_assert(success);
@@ -771,10 +786,12 @@ sync_sb_lb_record(struct sb_lb_record *sb_lb,
     }
 
     if (lb_dps->n_nb_ls) {
+        struct sparse_bitmap ls_map;
+
+        sparse_bitmap_init_from_bitmap(&ls_map, lb_dps->nb_ls_map,
+                                       ods_size(ls_datapaths));
         sb_lb->ls_dpg = ovn_dp_group_get(&sb_lbs->ls_dp_groups,
-                                         lb_dps->n_nb_ls,
-                                         lb_dps->nb_ls_map,
-                                         ods_size(ls_datapaths));
+                                         lb_dps->n_nb_ls, &ls_map);
         if (sb_lb->ls_dpg) {
             /* Update the dpg's sb dp_group. */
             sb_lb->ls_dpg->dp_group =
@@ -798,15 +815,16 @@ sync_sb_lb_record(struct sb_lb_record *sb_lb,
                             "have been referencing the dp group ["UUID_FMT"]",
                             sb_lb->lb_dps->lb->nlb->name,
                             UUID_ARGS(&sb_lb->ls_dpg->dpg_uuid));
+                sparse_bitmap_destroy(&ls_map);
                 return false;
             }
         } else {
             sb_lb->ls_dpg = ovn_dp_group_create(
                 ovnsb_txn, &sb_lbs->ls_dp_groups, sbrec_ls_dp_group,
-                lb_dps->n_nb_ls, lb_dps->nb_ls_map,
-                ods_size(ls_datapaths), true,
+                lb_dps->n_nb_ls, &ls_map, true,
                 ls_datapaths, lr_datapaths);
         }
+        sparse_bitmap_destroy(&ls_map);
 
         if (chassis_features->ls_dpg_column) {
             sbrec_load_balancer_set_ls_datapath_group(sbrec_lb,
@@ -826,10 +844,12 @@ sync_sb_lb_record(struct sb_lb_record *sb_lb,
 
 
     if (lb_dps->n_nb_lr) {
+        struct sparse_bitmap lr_map;
+
+        sparse_bitmap_init_from_bitmap(&lr_map, lb_dps->nb_lr_map,
+                                       ods_size(lr_datapaths));
         sb_lb->lr_dpg = ovn_dp_group_get(&sb_lbs->lr_dp_groups,
-                                         lb_dps->n_nb_lr,
-                                         lb_dps->nb_lr_map,
-                                         ods_size(lr_datapaths));
+                                         lb_dps->n_nb_lr, &lr_map);
         if (sb_lb->lr_dpg) {
             /* Update the dpg's sb dp_group. */
             sb_lb->lr_dpg->dp_group =
@@ -853,15 +873,16 @@ sync_sb_lb_record(struct sb_lb_record *sb_lb,
                             "have been referencing the dp group ["UUID_FMT"]",
                             sb_lb->lb_dps->lb->nlb->name,
                             UUID_ARGS(&sb_lb->lr_dpg->dpg_uuid));
+                sparse_bitmap_destroy(&lr_map);
                 return false;
             }
         } else {
             sb_lb->lr_dpg = ovn_dp_group_create(
                 ovnsb_txn, &sb_lbs->lr_dp_groups, sbrec_lr_dp_group,
-                lb_dps->n_nb_lr, lb_dps->nb_lr_map,
-                ods_size(lr_datapaths), false,
+                lb_dps->n_nb_lr, &lr_map, false,
                 ls_datapaths, lr_datapaths);
         }
+        sparse_bitmap_destroy(&lr_map);
 
         sbrec_load_balancer_set_lr_datapath_group(sbrec_lb,
                                                   sb_lb->lr_dpg->dp_group);
@@ -931,7 +952,9 @@ sync_changed_lbs(struct sb_lb_table *sb_lbs,
                 sbrec_load_balancer_table_get_for_uuid(sb_lb_table,
                                                        &sb_lb->sb_uuid);
             if (sbrec_lb) {
+                engine_txn_lock();
                 sbrec_load_balancer_delete(sbrec_lb);
+                engine_txn_unlock();
             }
 
             hmap_remove(&sb_lbs->entries, &sb_lb->key_node);
@@ -965,16 +988,22 @@ sync_changed_lbs(struct sb_lb_table *sb_lbs,
                 sbrec_load_balancer_table_get_for_uuid(sb_lb_table,
                                                        &sb_lb->sb_uuid);
             if (sbrec_lb) {
+                engine_txn_lock();
                 sbrec_load_balancer_delete(sbrec_lb);
+                engine_txn_unlock();
             }
 
             hmap_remove(&sb_lbs->entries, &sb_lb->key_node);
             free(sb_lb);
         }
 
-        if (!sync_sb_lb_record(sb_lb, sb_lb->sbrec_lb, sb_dpgrp_table, sb_lbs,
-                               ovnsb_txn, ls_datapaths, lr_datapaths,
-                               chassis_features)) {
+        engine_txn_lock();
+        bool success = sync_sb_lb_record(sb_lb, sb_lb->sbrec_lb,
+                                         sb_dpgrp_table, sb_lbs, ovnsb_txn,
+                                         ls_datapaths, lr_datapaths,
+                                         chassis_features);
+        engine_txn_unlock();
+        if (!success) {
             return false;
         }
     }
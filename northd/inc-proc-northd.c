@@ -181,15 +181,20 @@ void inc_proc_northd_init(struct ovsdb_idl_loop *nb,
     engine_add_input(&en_northd, &en_nb_static_mac_binding, NULL);
     engine_add_input(&en_northd, &en_nb_chassis_template_var, NULL);
 
-    engine_add_input(&en_northd, &en_sb_chassis, NULL);
-    engine_add_input(&en_northd, &en_sb_mirror, NULL);
-    engine_add_input(&en_northd, &en_sb_meter, NULL);
+    engine_add_input(&en_northd, &en_sb_chassis, northd_sb_chassis_handler);
+    engine_add_input(&en_northd, &en_sb_mirror, northd_sb_mirror_handler);
+    /* SB meters are synced by the en_sync_meters node, northd doesn't
+     * use them. */
+    engine_add_input(&en_northd, &en_sb_meter, engine_noop_handler);
     engine_add_input(&en_northd, &en_sb_datapath_binding, NULL);
-    engine_add_input(&en_northd, &en_sb_dns, NULL);
-    engine_add_input(&en_northd, &en_sb_ha_chassis_group, NULL);
-    engine_add_input(&en_northd, &en_sb_ip_multicast, NULL);
-    engine_add_input(&en_northd, &en_sb_service_monitor, NULL);
-    engine_add_input(&en_northd, &en_sb_fdb, NULL);
+    engine_add_input(&en_northd, &en_sb_dns, northd_sb_dns_handler);
+    engine_add_input(&en_northd, &en_sb_ha_chassis_group,
+                     northd_sb_ha_chassis_group_handler);
+    engine_add_input(&en_northd, &en_sb_ip_multicast,
+                     northd_sb_ip_multicast_handler);
+    engine_add_input(&en_northd, &en_sb_service_monitor,
+                     northd_sb_service_monitor_handler);
+    engine_add_input(&en_northd, &en_sb_fdb, northd_sb_fdb_handler);
     engine_add_input(&en_northd, &en_sb_static_mac_binding, NULL);
     engine_add_input(&en_northd, &en_sb_chassis_template_var, NULL);
     engine_add_input(&en_northd, &en_global_config,
@@ -237,12 +242,16 @@ void inc_proc_northd_init(struct ovsdb_idl_loop *nb,
     engine_add_input(&en_fdb_aging, &en_global_config,
                      node_global_config_handler);
 
-    engine_add_input(&en_sync_meters, &en_nb_acl, NULL);
+    engine_add_input(&en_sync_meters, &en_nb_acl, sync_meters_nb_acl_handler);
     engine_add_input(&en_sync_meters, &en_nb_meter, NULL);
     engine_add_input(&en_sync_meters, &en_sb_meter, NULL);
 
     engine_add_input(&en_lflow, &en_nb_bfd, NULL);
-    engine_add_input(&en_lflow, &en_nb_acl, NULL);
+    /* No need for a handler for NB ACL changes.  The ACLs are referenced
+     * by logical switches and port groups, ACL changes are tracked by the
+     * northd and port_group nodes and the ACL flows are regenerated
+     * through the ls_stateful node. */
+    engine_add_input(&en_lflow, &en_nb_acl, engine_noop_handler);
     engine_add_input(&en_lflow, &en_sync_meters, NULL);
     engine_add_input(&en_lflow, &en_sb_bfd, NULL);
     engine_add_input(&en_lflow, &en_sb_logical_flow, NULL);
@@ -335,6 +344,23 @@ void inc_proc_northd_init(struct ovsdb_idl_loop *nb,
     struct ovsdb_idl_index *fdb_by_dp_key =
         ovsdb_idl_index_create1(sb->idl, &sbrec_fdb_col_dp_key);
 
+    /* These nodes only build their own data from the data of their inputs
+     * and may run in parallel with the other thread safe nodes. */
+    engine_set_node_thread_safe(&en_lb_data);
+    engine_set_node_thread_safe(&en_lr_nat);
+    engine_set_node_thread_safe(&en_lr_stateful);
+    engine_set_node_thread_safe(&en_ls_stateful);
+
+    /* These nodes write to the SB transaction with engine_txn_lock() held.
+     * No other thread safe node uses the SB tables they write, respectively
+     * Address_Set, Load_Balancer and Logical_DP_Group, Port_Binding,
+     * MAC_Binding and FDB. */
+    engine_set_node_thread_safe(&en_sync_to_sb_addr_set);
+    engine_set_node_thread_safe(&en_sync_to_sb_lb);
+    engine_set_node_thread_safe(&en_sync_to_sb_pb);
+    engine_set_node_thread_safe(&en_mac_binding_aging);
+    engine_set_node_thread_safe(&en_fdb_aging);
+
     engine_init(&en_northd_output, &engine_arg);
 
     engine_ovsdb_node_add_index(&en_sb_chassis,
@@ -412,6 +438,8 @@ bool inc_proc_northd_run(struct ovsdb_idl_txn *ovnnb_txn,
 
     engine_set_context(&eng_ctx);
     engine_run(true);
+    aging_waker_wait(engine_get_internal_data(&en_mac_binding_aging_waker));
+    aging_waker_wait(engine_get_internal_data(&en_fdb_aging_waker));
 
     if (!engine_has_run()) {
         if (engine_need_run()) {
@@ -433,6 +461,8 @@ bool inc_proc_northd_run(struct ovsdb_idl_txn *ovnnb_txn,
     /* Postpone the next run by length of current run with maximum capped
      * by "northd-backoff-interval-ms" interval. */
     ctx->next_run_ms = now + MIN(now - start, ctx->backoff_ms);
+    ctx->run_duration_ms = now - start;
+    ctx->coalesce_end_ms = 0;
 
     return engine_has_updated();
 }
@@ -446,14 +476,33 @@ void inc_proc_northd_cleanup(void)
 bool
 inc_proc_northd_can_run(struct northd_engine_context *ctx)
 {
-    if (ctx->recompute || time_msec() >= ctx->next_run_ms ||
+    if (ctx->recompute ||
         ctx->nb_idl_duration_ms >= IDL_LOOP_MAX_DURATION_MS ||
         ctx->sb_idl_duration_ms >= IDL_LOOP_MAX_DURATION_MS) {
         return true;
     }
 
-    poll_timer_wait_until(ctx->next_run_ms);
-    return false;
+    int64_t now = time_msec();
+    if (now < ctx->next_run_ms) {
+        poll_timer_wait_until(ctx->next_run_ms);
+        return false;
+    }
+
+    /* The backoff above already delays the runs after an expensive one.
+     * After a cheap run, the fixed cost of a run dominates, so wait up to
+     * "northd-coalesce-interval-ms" for more changes and process them all
+     * in a single run. */
+    if (ctx->input_changed && ctx->coalesce_ms &&
+        ctx->run_duration_ms < ctx->coalesce_ms) {
+        if (!ctx->coalesce_end_ms) {
+            ctx->coalesce_end_ms = now + ctx->coalesce_ms;
+        }
+        if (now < ctx->coalesce_end_ms) {
+            poll_timer_wait_until(ctx->coalesce_end_ms);
+            return false;
+        }
+    }
+    return true;
 }
 
 static void
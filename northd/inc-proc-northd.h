@@ -10,9 +10,14 @@
 
 struct northd_engine_context {
     int64_t next_run_ms;
+    int64_t coalesce_end_ms;    /* End of the current coalescing window, or 0
+                                 * if there is none. */
     uint64_t nb_idl_duration_ms;
     uint64_t sb_idl_duration_ms;
+    uint64_t run_duration_ms;   /* Duration of the last engine run. */
     uint32_t backoff_ms;
+    uint32_t coalesce_ms;
+    bool input_changed;         /* NB or SB changed since the last run. */
     bool recompute;
 };
 
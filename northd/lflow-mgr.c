@@ -19,12 +19,18 @@
 /* OVS includes */
 #include "include/openvswitch/thread.h"
 #include "lib/bitmap.h"
+#include "lib/ovs-atomic.h"
+#include "lib/ovs-thread.h"
+#include "lib/uuid.h"
 #include "openvswitch/vlog.h"
 
 /* OVN includes */
 #include "debug.h"
+#include "dp-refcnts.h"
 #include "lflow-mgr.h"
 #include "lib/ovn-parallel-hmap.h"
+#include "lib/sparse-bitmap.h"
+#include "lib/string-pool.h"
 
 VLOG_DEFINE_THIS_MODULE(lflow_mgr);
 
@@ -33,17 +39,19 @@ struct ovn_lflow;
 
 static void ovn_lflow_init(struct ovn_lflow *, struct ovn_datapath *od,
                            size_t dp_bitmap_len, enum ovn_stage stage,
-                           uint16_t priority, char *match,
-                           char *actions, char *io_port,
-                           char *ctrl_meter, char *stage_hint,
+                           uint16_t priority, const char *match,
+                           const char *actions, const char *io_port,
+                           const char *ctrl_meter, char *stage_hint,
                            const char *where);
-static struct ovn_lflow *ovn_lflow_find(const struct hmap *lflows,
+static struct ovn_lflow *ovn_lflow_find(const struct lflow_table *,
                                         enum ovn_stage stage,
                                         uint16_t priority, const char *match,
                                         const char *actions,
                                         const char *ctrl_meter, uint32_t hash);
 static void ovn_lflow_destroy(struct lflow_table *lflow_table,
                               struct ovn_lflow *lflow);
+static void ovn_lflow_free(struct lflow_table *lflow_table,
+                           struct ovn_lflow *lflow);
 static char *ovn_lflow_hint(const struct ovsdb_idl_row *row);
 
 static struct ovn_lflow *do_ovn_lflow_add(
@@ -58,16 +66,19 @@ static struct ovn_lflow *do_ovn_lflow_add(
 static struct ovs_mutex *lflow_hash_lock(const struct hmap *lflow_table,
                                          uint32_t hash);
 static void lflow_hash_unlock(struct ovs_mutex *hash_lock);
+static void lflow_ref_nodes_lock(struct lflow_ref *,
+                                 const struct ovs_mutex *hash_lock);
+static void lflow_ref_nodes_unlock(struct lflow_ref *,
+                                   const struct ovs_mutex *hash_lock);
 
 static struct sbrec_logical_dp_group *ovn_sb_insert_or_update_logical_dp_group(
     struct ovsdb_idl_txn *ovnsb_txn,
     struct sbrec_logical_dp_group *,
-    const unsigned long *dpg_bitmap,
+    const struct sparse_bitmap *dpg_bitmap,
     const struct ovn_datapaths *);
-static struct ovn_dp_group *ovn_dp_group_find(const struct hmap *dp_groups,
-                                              const unsigned long *dpg_bitmap,
-                                              size_t bitmap_len,
-                                              uint32_t hash);
+static struct ovn_dp_group *ovn_dp_group_find(
+    const struct hmap *dp_groups, const struct sparse_bitmap *dpg_bitmap,
+    uint32_t hash);
 static void ovn_dp_group_use(struct ovn_dp_group *);
 static void ovn_dp_group_release(struct hmap *dp_groups,
                                  struct ovn_dp_group *);
@@ -97,33 +108,26 @@ static bool sync_lflow_to_sb(struct ovn_lflow *,
 /* TODO:  Move the parallization logic to this module to avoid accessing
  * and modifying in both northd.c and lflow-mgr.c. */
 extern int parallelization_state;
-extern thread_local size_t thread_lflow_counter;
-
-struct dp_refcnt;
-static struct dp_refcnt *dp_refcnt_find(struct hmap *dp_refcnts_map,
-                                        size_t dp_index);
-static void dp_refcnt_use(struct hmap *dp_refcnts_map, size_t dp_index);
-static bool dp_refcnt_release(struct hmap *dp_refcnts_map, size_t dp_index);
-static void ovn_lflow_clear_dp_refcnts_map(struct ovn_lflow *);
+
 static struct lflow_ref_node *lflow_ref_node_find(struct hmap *lflow_ref_nodes,
                                                   struct ovn_lflow *lflow,
                                                   uint32_t lflow_hash);
 static void lflow_ref_node_destroy(struct lflow_ref_node *);
 
 static bool lflow_hash_lock_initialized = false;
-/* The lflow_hash_lock is a mutex array that protects updates to the shared
- * lflow table across threads when parallel lflow build and dp-group are both
- * enabled. To avoid high contention between threads, a big array of mutexes
- * are used instead of just one. This is possible because when parallel build
- * is used we only use hmap_insert_fast() to update the hmap, which would not
- * touch the bucket array but only the list in a single bucket. We only need to
- * make sure that when adding lflows to the same hash bucket, the same lock is
- * used, so that no two threads can add to the bucket at the same time.  It is
- * ok that the same lock is used to protect multiple buckets, so a fixed sized
- * mutex array is used instead of 1-1 mapping to the hash buckets. This
- * simplies the implementation while effectively reduces lock contention
- * because the chance that different threads contending the same lock amongst
- * the big number of locks is very low. */
+/* When parallel lflow build is enabled, lflows are inserted to the shared
+ * lflow table without any locking, see do_ovn_lflow_add_concurrent(), and
+ * the datapaths are added to the lflow's dp group bitmap with atomic
+ * operations.
+ *
+ * The lflow_hash_lock is a mutex array that only protects the lflow_ref
+ * bookkeeping of an existing lflow (its 'referenced_by' list and
+ * 'dp_refcnts'), which can be updated by several threads at the same
+ * time for different lflow_refs.  To avoid high contention between threads,
+ * a big array of mutexes is used instead of just one.  It is ok that the
+ * same lock is used to protect multiple lflows, so a fixed sized mutex array
+ * is used.  The chance that different threads contend for the same lock
+ * amongst the big number of locks is very low. */
 #define LFLOW_HASH_LOCK_MASK 0xFFFF
 static struct ovs_mutex lflow_hash_locks[LFLOW_HASH_LOCK_MASK + 1];
 
@@ -161,14 +165,17 @@ struct ovn_lflow {
     struct hmap_node hmap_node;
 
     struct ovn_datapath *od;     /* 'logical_datapath' in SB schema.  */
-    unsigned long *dpg_bitmap;   /* Bitmap of all datapaths by their 'index'.*/
+    struct sparse_bitmap dpg_bitmap; /* All datapaths by their 'index'. */
     enum ovn_stage stage;
     uint16_t priority;
-    char *match;
-    char *actions;
-    char *io_port;
+
+    /* Strings interned in the 'strings' pool of the lflow_table, so they
+     * can be compared by pointer. */
+    const char *match;
+    const char *actions;
+    const char *io_port;
     char *stage_hint;
-    char *ctrl_meter;
+    const char *ctrl_meter;
     size_t n_ods;                /* Number of datapaths referenced by 'od' and
                                   * 'dpg_bitmap'. */
     struct ovn_dp_group *dpg;    /* Link to unique Sb datapath group. */
@@ -176,9 +183,9 @@ struct ovn_lflow {
 
     struct uuid sb_uuid;         /* SB DB row uuid, specified by northd. */
     struct ovs_list referenced_by;  /* List of struct lflow_ref_node. */
-    struct hmap dp_refcnts_map; /* Maintains the number of times this ovn_lflow
-                                 * is referenced by a given datapath.
-                                 * Contains 'struct dp_refcnt' in the map. */
+    struct dp_refcnts dp_refcnts; /* Maintains the number of times this
+                                   * ovn_lflow is referenced by a given
+                                   * datapath. */
 };
 
 /* Logical flow table. */
@@ -187,13 +194,66 @@ struct lflow_table {
     struct hmap ls_dp_groups; /* hmap of logical switch dp groups. */
     struct hmap lr_dp_groups; /* hmap of logical router dp groups. */
     ssize_t max_seen_lflow_size;
+
+    /* Interned strings of all the lflows in 'entries'.  Many lflows share
+     * the same match, actions etc., this way they are stored only once. */
+    struct string_pool *strings;
+
+    /* Caches of 'strings' of the threads that added lflows to the table, see
+     * lflow_table_strings_cache(). */
+    uint64_t id;                      /* Unique among all the tables. */
+    struct ovs_mutex caches_mutex;
+    struct string_pool_cache **caches OVS_GUARDED;
+    size_t n_caches OVS_GUARDED;
+    size_t allocated_caches OVS_GUARDED;
+};
+
+/* The string pool cache of the calling thread for the lflow table with id
+ * 'table_id'. */
+struct lflow_strings_cache_ptr {
+    uint64_t table_id;
+    struct string_pool_cache *cache;
 };
 
+DEFINE_STATIC_PER_THREAD_DATA(struct lflow_strings_cache_ptr,
+                              lflow_strings_cache_ptr, { 0, NULL });
+
+/* Returns the string pool cache of the calling thread for 'lflow_table',
+ * creating it if needed.  The caches are only destroyed along with the
+ * table, so a thread's cache is looked up by table id rather than by
+ * pointer: a new table may be allocated at the address of a destroyed one.
+ * If a thread alternates between several tables, it gets a new cache each
+ * time, so that should be avoided; ovn-northd has a single lflow table. */
+static struct string_pool_cache *
+lflow_table_strings_cache(struct lflow_table *lflow_table)
+{
+    struct lflow_strings_cache_ptr *ptr = lflow_strings_cache_ptr_get();
+
+    if (ptr->table_id != lflow_table->id) {
+        ptr->table_id = lflow_table->id;
+        ptr->cache = string_pool_cache_create(lflow_table->strings);
+
+        ovs_mutex_lock(&lflow_table->caches_mutex);
+        if (lflow_table->n_caches >= lflow_table->allocated_caches) {
+            lflow_table->caches = x2nrealloc(lflow_table->caches,
+                                             &lflow_table->allocated_caches,
+                                             sizeof *lflow_table->caches);
+        }
+        lflow_table->caches[lflow_table->n_caches++] = ptr->cache;
+        ovs_mutex_unlock(&lflow_table->caches_mutex);
+    }
+    return ptr->cache;
+}
+
 struct lflow_table *
 lflow_table_alloc(void)
 {
+    static atomic_uint64_t next_id = 1;
     struct lflow_table *lflow_table = xzalloc(sizeof *lflow_table);
     lflow_table->max_seen_lflow_size = 128;
+    lflow_table->strings = string_pool_create();
+    atomic_add_relaxed(&next_id, 1, &lflow_table->id);
+    ovs_mutex_init(&lflow_table->caches_mutex);
 
     return lflow_table;
 }
@@ -226,6 +286,17 @@ lflow_table_destroy(struct lflow_table *lflow_table)
     hmap_destroy(&lflow_table->entries);
     ovn_dp_groups_destroy(&lflow_table->ls_dp_groups);
     ovn_dp_groups_destroy(&lflow_table->lr_dp_groups);
+
+    /* All the threads that used a cache are done with the table by now. */
+    ovs_mutex_lock(&lflow_table->caches_mutex);
+    for (size_t i = 0; i < lflow_table->n_caches; i++) {
+        string_pool_cache_destroy(lflow_table->caches[i]);
+    }
+    free(lflow_table->caches);
+    ovs_mutex_unlock(&lflow_table->caches_mutex);
+    ovs_mutex_destroy(&lflow_table->caches_mutex);
+
+    string_pool_destroy(lflow_table->strings);
     free(lflow_table);
 }
 
@@ -240,10 +311,118 @@ lflow_table_expand(struct lflow_table *lflow_table)
     }
 }
 
+/* Returns the lflow in 'lflow_table' that corresponds to the SB 'sbflow', or
+ * NULL if there is none or if 'sbflow' has no valid logical datapath.
+ *
+ * Only reads 'lflow_table' and the datapaths, so it's safe to call from
+ * multiple threads as long as nothing modifies them. */
+static struct ovn_lflow *
+lflow_table_find_sbflow(const struct lflow_table *lflow_table,
+                        const struct ovn_datapaths *ls_datapaths,
+                        const struct ovn_datapaths *lr_datapaths,
+                        const struct sbrec_logical_flow *sbflow)
+{
+    struct sbrec_logical_dp_group *dp_group = sbflow->logical_dp_group;
+    struct ovn_datapath *logical_datapath_od = NULL;
+    size_t i;
+
+    /* Find one valid datapath to get the datapath type. */
+    struct sbrec_datapath_binding *dp = sbflow->logical_datapath;
+    if (dp) {
+        logical_datapath_od = ovn_datapath_from_sbrec(
+            &ls_datapaths->datapaths, &lr_datapaths->datapaths, dp);
+        if (logical_datapath_od
+            && ovn_datapath_is_stale(logical_datapath_od)) {
+            logical_datapath_od = NULL;
+        }
+    }
+    for (i = 0; dp_group && i < dp_group->n_datapaths; i++) {
+        logical_datapath_od = ovn_datapath_from_sbrec(
+            &ls_datapaths->datapaths, &lr_datapaths->datapaths,
+            dp_group->datapaths[i]);
+        if (logical_datapath_od
+            && !ovn_datapath_is_stale(logical_datapath_od)) {
+            break;
+        }
+        logical_datapath_od = NULL;
+    }
+
+    if (!logical_datapath_od) {
+        /* This lflow has no valid logical datapaths. */
+        return NULL;
+    }
+
+    enum ovn_pipeline pipeline
+        = !strcmp(sbflow->pipeline, "ingress") ? P_IN : P_OUT;
+
+    return ovn_lflow_find(
+        lflow_table,
+        ovn_stage_build(ovn_datapath_get_type(logical_datapath_od),
+                        pipeline, sbflow->table_id),
+        sbflow->priority, sbflow->match, sbflow->actions,
+        sbflow->controller_meter, sbflow->hash);
+}
+
+/* An SB Logical_Flow row and the lflow it corresponds to, if any. */
+struct lflow_sync_item {
+    const struct sbrec_logical_flow *sbflow;
+    struct ovn_lflow *lflow;
+};
+
+/* Work shared by all the threads of 'lflow_sync_pool'. */
+struct lflow_sync_work {
+    const struct lflow_table *lflow_table;
+    const struct ovn_datapaths *ls_datapaths;
+    const struct ovn_datapaths *lr_datapaths;
+    struct lflow_sync_item *items;
+    struct worker_task_queue tasks;  /* Indexes of 'items'. */
+};
+
+static struct worker_pool *lflow_sync_pool = NULL;
+
+static void *
+lflow_sync_thread(void *arg)
+{
+    struct worker_control *control = (struct worker_control *) arg;
+    struct lflow_sync_work *work;
+    size_t i;
+
+    while (!stop_parallel_processing()) {
+        wait_for_work(control);
+        work = (struct lflow_sync_work *) control->data;
+        if (stop_parallel_processing()) {
+            return NULL;
+        }
+        if (work) {
+            WORKER_TASK_FOR_EACH (i, control->id, &work->tasks) {
+                struct lflow_sync_item *item = &work->items[i];
+
+                item->lflow = lflow_table_find_sbflow(work->lflow_table,
+                                                      work->ls_datapaths,
+                                                      work->lr_datapaths,
+                                                      item->sbflow);
+            }
+        }
+        post_completed_work(control);
+    }
+    return NULL;
+}
+
+static void
+lflow_sync_noop_callback(struct worker_pool *pool OVS_UNUSED,
+                         void *fin_result OVS_UNUSED,
+                         void *result_frags OVS_UNUSED,
+                         size_t index OVS_UNUSED)
+{
+    /* Do nothing */
+}
+
+/* Updates the number of threads used to compare the SB logical flows with
+ * the lflow table in lflow_table_sync_to_sb(). */
 void
-lflow_table_set_size(struct lflow_table *lflow_table, size_t size)
+lflow_sync_update_worker_pool(int n_threads)
 {
-    lflow_table->entries.n = size;
+    update_worker_pool(n_threads, &lflow_sync_pool, lflow_sync_thread);
 }
 
 void
@@ -262,50 +441,58 @@ lflow_table_sync_to_sb(struct lflow_table *lflow_table,
     fast_hmap_size_for(&lflows_temp,
                        lflow_table->max_seen_lflow_size);
 
-    /* Push changes to the Logical_Flow table to database. */
+    /* Match each SB Logical_Flow row with its lflow first.  This only reads
+     * the lflow table, so it's done by the worker pool if parallelization
+     * is enabled.  The changes to the database are then pushed by the main
+     * thread. */
     const struct sbrec_logical_flow *sbflow;
-    SBREC_LOGICAL_FLOW_TABLE_FOR_EACH_SAFE (sbflow, sb_flow_table) {
-        struct sbrec_logical_dp_group *dp_group = sbflow->logical_dp_group;
-        struct ovn_datapath *logical_datapath_od = NULL;
-        size_t i;
-
-        /* Find one valid datapath to get the datapath type. */
-        struct sbrec_datapath_binding *dp = sbflow->logical_datapath;
-        if (dp) {
-            logical_datapath_od = ovn_datapath_from_sbrec(
-                &ls_datapaths->datapaths, &lr_datapaths->datapaths, dp);
-            if (logical_datapath_od
-                && ovn_datapath_is_stale(logical_datapath_od)) {
-                logical_datapath_od = NULL;
-            }
-        }
-        for (i = 0; dp_group && i < dp_group->n_datapaths; i++) {
-            logical_datapath_od = ovn_datapath_from_sbrec(
-                &ls_datapaths->datapaths, &lr_datapaths->datapaths,
-                dp_group->datapaths[i]);
-            if (logical_datapath_od
-                && !ovn_datapath_is_stale(logical_datapath_od)) {
-                break;
-            }
-            logical_datapath_od = NULL;
-        }
+    size_t n_items = 0, allocated_items = lflow_table->max_seen_lflow_size;
+    struct lflow_sync_item *items = xmalloc(MAX(allocated_items, 1)
+                                            * sizeof *items);
 
-        if (!logical_datapath_od) {
-            /* This lflow has no valid logical datapaths. */
-            sbrec_logical_flow_delete(sbflow);
-            continue;
+    SBREC_LOGICAL_FLOW_TABLE_FOR_EACH (sbflow, sb_flow_table) {
+        if (n_items >= allocated_items) {
+            items = x2nrealloc(items, &allocated_items, sizeof *items);
         }
+        items[n_items++] = (struct lflow_sync_item) { .sbflow = sbflow };
+    }
 
-        enum ovn_pipeline pipeline
-            = !strcmp(sbflow->pipeline, "ingress") ? P_IN : P_OUT;
+    if (parallelization_state == STATE_USE_PARALLELIZATION
+        && lflow_sync_pool) {
+        struct lflow_sync_work work = {
+            .lflow_table = lflow_table,
+            .ls_datapaths = ls_datapaths,
+            .lr_datapaths = lr_datapaths,
+            .items = items,
+        };
+
+        worker_task_queue_init(&work.tasks, n_items, lflow_sync_pool->size,
+                               0);
+        for (size_t i = 0; i < lflow_sync_pool->size; i++) {
+            lflow_sync_pool->controls[i].data = &work;
+        }
+        run_pool_callback(lflow_sync_pool, NULL, NULL,
+                          lflow_sync_noop_callback);
+        worker_task_queue_destroy(&work.tasks);
+    } else {
+        for (size_t i = 0; i < n_items; i++) {
+            items[i].lflow = lflow_table_find_sbflow(lflow_table,
+                                                     ls_datapaths,
+                                                     lr_datapaths,
+                                                     items[i].sbflow);
+        }
+    }
 
-        lflow = ovn_lflow_find(
-            lflows,
-            ovn_stage_build(ovn_datapath_get_type(logical_datapath_od),
-                            pipeline, sbflow->table_id),
-            sbflow->priority, sbflow->match, sbflow->actions,
-            sbflow->controller_meter, sbflow->hash);
-        if (lflow) {
+    /* Push changes to the Logical_Flow table to database. */
+    for (size_t i = 0; i < n_items; i++) {
+        sbflow = items[i].sbflow;
+        lflow = items[i].lflow;
+
+        /* The lflows of a full recompute have no SB row assigned until
+         * sync_lflow_to_sb() is called for them, so a non-zero 'sb_uuid'
+         * means that an earlier row already matched the same lflow, i.e.
+         * 'sbflow' is a duplicate. */
+        if (lflow && uuid_is_zero(&lflow->sb_uuid)) {
             sync_lflow_to_sb(lflow, ovnsb_txn, lflow_table, ls_datapaths,
                              lr_datapaths, ovn_internal_version_changed,
                              sbflow, dpgrp_table);
@@ -317,6 +504,7 @@ lflow_table_sync_to_sb(struct lflow_table *lflow_table,
             sbrec_logical_flow_delete(sbflow);
         }
     }
+    free(items);
 
     HMAP_FOR_EACH_SAFE (lflow, hmap_node, lflows) {
         sync_lflow_to_sb(lflow, ovnsb_txn, lflow_table, ls_datapaths,
@@ -490,27 +678,23 @@ lflow_table_sync_to_sb(struct lflow_table *lflow_table,
  *
  * Thread safety in lflow_ref
  * ==========================
- * The function lflow_table_add_lflow() is not thread safe for lflow_ref.
- * Client should ensure that same instance of lflow_ref's are not used
- * by multiple threads when calling lflow_table_add_lflow().
+ * During the parallel lflow build, several threads may call
+ * lflow_table_add_lflow() for the same lflow_ref, e.g. when the flows of a
+ * single large router are built by several tasks.  The lflow_ref_node of an
+ * lflow is only accessed with the lflow's hash lock held, but the
+ * 'lflow_ref_nodes' hmap itself is shared by all the lflows of the
+ * lflow_ref, so it is protected by the lflow_ref's own 'nodes_mutex'.
+ * The mutex is only taken when parallelization is in use, nested inside of
+ * a hash lock.
  *
- * One way to ensure thread safety is to maintain array of hash locks
- * in each lflow_ref just like how we have static variable lflow_hash_locks
- * of type ovs_mutex. This would mean that client has to reconsile the
- * lflow_ref hmap lflow_ref_nodes (by calling hmap_expand()) after the
- * lflow generation is complete.  (See lflow_table_expand()).
- *
- * Presently the client of lflow manager (northd.c) doesn't call
- * lflow_table_add_lflow() in multiple threads for the same lflow_ref.
- * But it may change in the future and we may need to add the thread
- * safety support.
- *
- * Until then care should be taken by the contributors to avoid this
- * scenario.
+ * All the other lflow_ref functions are not thread safe.
  */
 struct lflow_ref {
     /* hmap of lfow ref nodes. hmap_node is 'struct lflow_ref_node *'. */
     struct hmap lflow_ref_nodes;
+
+    /* Protects 'lflow_ref_nodes' during the parallel lflow build. */
+    struct ovs_mutex nodes_mutex;
 };
 
 struct lflow_ref_node {
@@ -527,9 +711,8 @@ struct lflow_ref_node {
     /* Indicates whether the lflow was added with a dp_group using the
      * ovn_lflow_add_with_dp_group() macro. */
     bool dpgrp_lflow;
-    /* dpgrp bitmap and bitmap length.  Valid only of dpgrp_lflow is true. */
-    unsigned long *dpgrp_bitmap;
-    size_t dpgrp_bitmap_len;
+    /* dpgrp bitmap.  Valid only of dpgrp_lflow is true. */
+    struct sparse_bitmap dpgrp_bitmap;
 
     /* Index id of the datapath this lflow_ref_node belongs to.
      * Valid only if dpgrp_lflow is false. */
@@ -548,6 +731,7 @@ lflow_ref_create(void)
 {
     struct lflow_ref *lflow_ref = xzalloc(sizeof *lflow_ref);
     hmap_init(&lflow_ref->lflow_ref_nodes);
+    ovs_mutex_init(&lflow_ref->nodes_mutex);
     return lflow_ref;
 }
 
@@ -565,6 +749,7 @@ lflow_ref_destroy(struct lflow_ref *lflow_ref)
 {
     lflow_ref_clear(lflow_ref);
     hmap_destroy(&lflow_ref->lflow_ref_nodes);
+    ovs_mutex_destroy(&lflow_ref->nodes_mutex);
     free(lflow_ref);
 }
 
@@ -582,16 +767,19 @@ lflow_ref_unlink_lflows(struct lflow_ref *lflow_ref)
     HMAP_FOR_EACH (lrn, ref_node, &lflow_ref->lflow_ref_nodes) {
         if (lrn->dpgrp_lflow) {
             size_t index;
-            BITMAP_FOR_EACH_1 (index, lrn->dpgrp_bitmap_len,
-                               lrn->dpgrp_bitmap) {
-                if (dp_refcnt_release(&lrn->lflow->dp_refcnts_map, index)) {
-                    bitmap_set0(lrn->lflow->dpg_bitmap, index);
+            SPARSE_BITMAP_FOR_EACH_1 (index, &lrn->dpgrp_bitmap) {
+                if (dp_refcnt_release(&lrn->lflow->dp_refcnts, index)) {
+                    sparse_bitmap_set0(&lrn->lflow->dpg_bitmap, index);
                 }
             }
+            /* Remove the released counters at once, instead of moving the
+             * rest of the array for each of the datapaths. */
+            dp_refcnts_compact(&lrn->lflow->dp_refcnts);
         } else {
-            if (dp_refcnt_release(&lrn->lflow->dp_refcnts_map,
+            if (dp_refcnt_release(&lrn->lflow->dp_refcnts,
                                   lrn->dp_index)) {
-                bitmap_set0(lrn->lflow->dpg_bitmap, lrn->dp_index);
+                sparse_bitmap_set0(&lrn->lflow->dpg_bitmap, lrn->dp_index);
+                dp_refcnts_compact(&lrn->lflow->dp_refcnts);
             }
         }
 
@@ -646,10 +834,8 @@ lflow_ref_sync_lflows(struct lflow_ref *lflow_ref,
  *    - if not present, then it creates an lflow_ref_node object for
  *      the [L(M, A), dp index] and adds ito the lflow_ref hmap.
  *
- * Note that this function is not thread safe for 'lflow_ref'.
- * If 2 or more threads calls this function for the same 'lflow_ref',
- * then it may corrupt the hmap.  Caller should ensure thread safety
- * for such scenarios.
+ * Several threads may call this function for the same 'lflow_ref' during
+ * the parallel lflow build, see "Thread safety in lflow_ref" above.
  */
 void
 lflow_table_add_lflow(struct lflow_table *lflow_table,
@@ -674,7 +860,6 @@ lflow_table_add_lflow(struct lflow_table *lflow_table,
                                  priority, match,
                                  actions);
 
-    hash_lock = lflow_hash_lock(&lflow_table->entries, hash);
     struct ovn_lflow *lflow =
         do_ovn_lflow_add(lflow_table,
                          od ? ods_size(od->datapaths) : dp_bitmap_len,
@@ -682,6 +867,14 @@ lflow_table_add_lflow(struct lflow_table *lflow_table,
                          io_port, ctrl_meter, stage_hint, where);
 
     if (lflow_ref) {
+        /* The datapath reference counting below depends on the dp group
+         * bitmap of the lflow, so update both under the hash lock. */
+        hash_lock = lflow_hash_lock(&lflow_table->entries, hash);
+
+        /* Only this thread can add a node for 'lflow' to 'lflow_ref', as it
+         * holds the hash lock, but the other threads may be adding nodes for
+         * other lflows. */
+        lflow_ref_nodes_lock(lflow_ref, hash_lock);
         struct lflow_ref_node *lrn =
             lflow_ref_node_find(&lflow_ref->lflow_ref_nodes, lflow, hash);
         if (!lrn) {
@@ -690,38 +883,42 @@ lflow_table_add_lflow(struct lflow_table *lflow_table,
             lrn->lflow_ref = lflow_ref;
             lrn->dpgrp_lflow = !od;
             if (lrn->dpgrp_lflow) {
-                lrn->dpgrp_bitmap = bitmap_clone(dp_bitmap, dp_bitmap_len);
-                lrn->dpgrp_bitmap_len = dp_bitmap_len;
+                sparse_bitmap_init_from_bitmap(&lrn->dpgrp_bitmap, dp_bitmap,
+                                               dp_bitmap_len);
             } else {
                 lrn->dp_index = od->index;
             }
             ovs_list_insert(&lflow->referenced_by, &lrn->ref_list_node);
             hmap_insert(&lflow_ref->lflow_ref_nodes, &lrn->ref_node, hash);
         }
+        lflow_ref_nodes_unlock(lflow_ref, hash_lock);
 
         if (!lrn->linked) {
             if (lrn->dpgrp_lflow) {
-                ovs_assert(lrn->dpgrp_bitmap_len == dp_bitmap_len);
+                ovs_assert(lrn->dpgrp_bitmap.n_bits == dp_bitmap_len);
                 size_t index;
                 BITMAP_FOR_EACH_1 (index, dp_bitmap_len, dp_bitmap) {
                     /* Allocate a reference counter only if already used. */
-                    if (bitmap_is_set(lflow->dpg_bitmap, index)) {
-                        dp_refcnt_use(&lflow->dp_refcnts_map, index);
+                    if (sparse_bitmap_is_set(&lflow->dpg_bitmap, index)) {
+                        dp_refcnt_use(&lflow->dp_refcnts, index);
                     }
                 }
             } else {
                 /* Allocate a reference counter only if already used. */
-                if (bitmap_is_set(lflow->dpg_bitmap, lrn->dp_index)) {
-                    dp_refcnt_use(&lflow->dp_refcnts_map, lrn->dp_index);
+                if (sparse_bitmap_is_set(&lflow->dpg_bitmap,
+                                         lrn->dp_index)) {
+                    dp_refcnt_use(&lflow->dp_refcnts, lrn->dp_index);
                 }
             }
         }
         lrn->linked = true;
-    }
 
-    ovn_dp_group_add_with_reference(lflow, od, dp_bitmap, dp_bitmap_len);
+        ovn_dp_group_add_with_reference(lflow, od, dp_bitmap, dp_bitmap_len);
 
-    lflow_hash_unlock(hash_lock);
+        lflow_hash_unlock(hash_lock);
+    } else {
+        ovn_dp_group_add_with_reference(lflow, od, dp_bitmap, dp_bitmap_len);
+    }
 }
 
 void
@@ -738,13 +935,12 @@ lflow_table_add_lflow_default_drop(struct lflow_table *lflow_table,
 
 struct ovn_dp_group *
 ovn_dp_group_get(struct hmap *dp_groups, size_t desired_n,
-                 const unsigned long *desired_bitmap,
-                 size_t bitmap_len)
+                 const struct sparse_bitmap *desired_bitmap)
 {
     uint32_t hash;
 
     hash = hash_int(desired_n, 0);
-    return ovn_dp_group_find(dp_groups, desired_bitmap, bitmap_len, hash);
+    return ovn_dp_group_find(dp_groups, desired_bitmap, hash);
 }
 
 /* Creates a new datapath group and adds it to 'dp_groups'.
@@ -756,8 +952,7 @@ ovn_dp_group_create(struct ovsdb_idl_txn *ovnsb_txn,
                     struct hmap *dp_groups,
                     struct sbrec_logical_dp_group *sb_group,
                     size_t desired_n,
-                    const unsigned long *desired_bitmap,
-                    size_t bitmap_len,
+                    const struct sparse_bitmap *desired_bitmap,
                     bool is_switch,
                     const struct ovn_datapaths *ls_datapaths,
                     const struct ovn_datapaths *lr_datapaths)
@@ -765,10 +960,10 @@ ovn_dp_group_create(struct ovsdb_idl_txn *ovnsb_txn,
     struct ovn_dp_group *dpg;
 
     bool update_dp_group = false, can_modify = false;
-    unsigned long *dpg_bitmap;
+    struct sparse_bitmap dpg_bitmap;
     size_t i, n = 0;
 
-    dpg_bitmap = sb_group ? bitmap_allocate(bitmap_len) : NULL;
+    sparse_bitmap_init(&dpg_bitmap, desired_bitmap->n_bits);
     for (i = 0; sb_group && i < sb_group->n_datapaths; i++) {
         struct ovn_datapath *datapath_od;
 
@@ -779,25 +974,25 @@ ovn_dp_group_create(struct ovsdb_idl_txn *ovnsb_txn,
         if (!datapath_od || ovn_datapath_is_stale(datapath_od)) {
             break;
         }
-        bitmap_set1(dpg_bitmap, datapath_od->index);
+        sparse_bitmap_set1(&dpg_bitmap, datapath_od->index);
         n++;
     }
     if (!sb_group || i != sb_group->n_datapaths) {
         /* No group or stale group.  Not going to be used. */
         update_dp_group = true;
         can_modify = true;
-    } else if (!bitmap_equal(dpg_bitmap, desired_bitmap, bitmap_len)) {
+    } else if (!sparse_bitmap_equal(&dpg_bitmap, desired_bitmap)) {
         /* The group in Sb is different. */
         update_dp_group = true;
         /* We can modify existing group if it's not already in use. */
-        can_modify = !ovn_dp_group_find(dp_groups, dpg_bitmap,
-                                        bitmap_len, hash_int(n, 0));
+        can_modify = !ovn_dp_group_find(dp_groups, &dpg_bitmap,
+                                        hash_int(n, 0));
     }
 
-    bitmap_free(dpg_bitmap);
+    sparse_bitmap_destroy(&dpg_bitmap);
 
     dpg = xzalloc(sizeof *dpg);
-    dpg->bitmap = bitmap_clone(desired_bitmap, bitmap_len);
+    sparse_bitmap_clone(&dpg->bitmap, desired_bitmap);
     if (!update_dp_group) {
         dpg->dp_group = sb_group;
     } else {
@@ -855,10 +1050,11 @@ lflow_hash_lock_destroy(void)
 static void
 ovn_lflow_init(struct ovn_lflow *lflow, struct ovn_datapath *od,
                size_t dp_bitmap_len, enum ovn_stage stage, uint16_t priority,
-               char *match, char *actions, char *io_port, char *ctrl_meter,
-               char *stage_hint, const char *where)
+               const char *match, const char *actions, const char *io_port,
+               const char *ctrl_meter, char *stage_hint,
+               const char *where)
 {
-    lflow->dpg_bitmap = bitmap_allocate(dp_bitmap_len);
+    sparse_bitmap_init(&lflow->dpg_bitmap, dp_bitmap_len);
     lflow->od = od;
     lflow->stage = stage;
     lflow->priority = priority;
@@ -870,7 +1066,7 @@ ovn_lflow_init(struct ovn_lflow *lflow, struct ovn_datapath *od,
     lflow->dpg = NULL;
     lflow->where = where;
     lflow->sb_uuid = UUID_ZERO;
-    hmap_init(&lflow->dp_refcnts_map);
+    dp_refcnts_init(&lflow->dp_refcnts);
     ovs_list_init(&lflow->referenced_by);
 }
 
@@ -899,34 +1095,99 @@ lflow_hash_unlock(struct ovs_mutex *hash_lock)
     }
 }
 
+/* Locks the 'lflow_ref_nodes' of 'lflow_ref' if 'hash_lock' is held, i.e.
+ * during the parallel lflow build. */
+static void
+lflow_ref_nodes_lock(struct lflow_ref *lflow_ref,
+                     const struct ovs_mutex *hash_lock)
+    OVS_NO_THREAD_SAFETY_ANALYSIS
+{
+    if (hash_lock) {
+        ovs_mutex_lock(&lflow_ref->nodes_mutex);
+    }
+}
+
+static void
+lflow_ref_nodes_unlock(struct lflow_ref *lflow_ref,
+                       const struct ovs_mutex *hash_lock)
+    OVS_NO_THREAD_SAFETY_ANALYSIS
+{
+    if (hash_lock) {
+        ovs_mutex_unlock(&lflow_ref->nodes_mutex);
+    }
+}
+
+/* Lookups compare the strings rather than looking up their interned copies,
+ * which would take the string pool mutexes for every lflow added.  The
+ * strings of 'a' are interned, so if the caller's strings are interned in
+ * the same pool too, which 'interned' tells, equal strings have equal
+ * pointers and comparing the pointers is enough.  Otherwise the pointers are
+ * still compared first, which avoids the strcmp() whenever the caller
+ * passes the lflow's own strings. */
 static bool
 ovn_lflow_equal(const struct ovn_lflow *a, enum ovn_stage stage,
                 uint16_t priority, const char *match,
-                const char *actions, const char *ctrl_meter)
+                const char *actions, const char *ctrl_meter, bool interned)
 {
-    return (a->stage == stage
-            && a->priority == priority
-            && !strcmp(a->match, match)
-            && !strcmp(a->actions, actions)
-            && nullable_string_is_equal(a->ctrl_meter, ctrl_meter));
+    if (a->stage != stage || a->priority != priority) {
+        return false;
+    }
+    if (interned) {
+        return (a->match == match
+                && a->actions == actions
+                && a->ctrl_meter == ctrl_meter);
+    }
+    return ((a->match == match || !strcmp(a->match, match))
+            && (a->actions == actions || !strcmp(a->actions, actions))
+            && (a->ctrl_meter == ctrl_meter
+                || nullable_string_is_equal(a->ctrl_meter, ctrl_meter)));
 }
 
 static struct ovn_lflow *
-ovn_lflow_find(const struct hmap *lflows,
+ovn_lflow_find(const struct lflow_table *lflow_table,
                enum ovn_stage stage, uint16_t priority,
                const char *match, const char *actions,
                const char *ctrl_meter, uint32_t hash)
 {
     struct ovn_lflow *lflow;
-    HMAP_FOR_EACH_WITH_HASH (lflow, hmap_node, hash, lflows) {
+    HMAP_FOR_EACH_WITH_HASH (lflow, hmap_node, hash, &lflow_table->entries) {
         if (ovn_lflow_equal(lflow, stage, priority, match, actions,
-                            ctrl_meter)) {
+                            ctrl_meter, false)) {
             return lflow;
         }
     }
     return NULL;
 }
 
+/* Searches the bucket list starting at 'first' and ending right before
+ * 'last' for an lflow.  'interned' tells whether 'match', 'actions' and
+ * 'ctrl_meter' are interned in the string pool of the lflow table, see
+ * ovn_lflow_equal(). */
+static struct ovn_lflow *
+ovn_lflow_find_in_bucket(const struct hmap_node *first,
+                         const struct hmap_node *last,
+                         enum ovn_stage stage, uint16_t priority,
+                         const char *match, const char *actions,
+                         const char *ctrl_meter, bool interned,
+                         uint32_t hash)
+{
+    for (const struct hmap_node *node = first; node != last;
+         node = node->next) {
+        if (node->hash != hash) {
+            continue;
+        }
+
+        struct ovn_lflow *lflow = CONTAINER_OF(node, struct ovn_lflow,
+                                               hmap_node);
+        if (ovn_lflow_equal(lflow, stage, priority, match, actions,
+                            ctrl_meter, interned)) {
+            return lflow;
+        }
+    }
+    return NULL;
+}
+
+/* Stage hints are unique per row, so they are not worth interning. */
 static char *
 ovn_lflow_hint(const struct ovsdb_idl_row *row)
 {
@@ -940,13 +1201,20 @@ static void
 ovn_lflow_destroy(struct lflow_table *lflow_table, struct ovn_lflow *lflow)
 {
     hmap_remove(&lflow_table->entries, &lflow->hmap_node);
-    bitmap_free(lflow->dpg_bitmap);
-    free(lflow->match);
-    free(lflow->actions);
-    free(lflow->io_port);
+    ovn_lflow_free(lflow_table, lflow);
+}
+
+/* Frees 'lflow', which must not be in the 'lflow_table' entries. */
+static void
+ovn_lflow_free(struct lflow_table *lflow_table, struct ovn_lflow *lflow)
+{
+    sparse_bitmap_destroy(&lflow->dpg_bitmap);
+    string_pool_release(lflow_table->strings, lflow->match);
+    string_pool_release(lflow_table->strings, lflow->actions);
+    string_pool_release(lflow_table->strings, lflow->io_port);
     free(lflow->stage_hint);
-    free(lflow->ctrl_meter);
-    ovn_lflow_clear_dp_refcnts_map(lflow);
+    string_pool_release(lflow_table->strings, lflow->ctrl_meter);
+    dp_refcnts_destroy(&lflow->dp_refcnts);
     struct lflow_ref_node *lrn;
     LIST_FOR_EACH_SAFE (lrn, ref_list_node, &lflow->referenced_by) {
         lflow_ref_node_destroy(lrn);
@@ -954,6 +1222,75 @@ ovn_lflow_destroy(struct lflow_table *lflow_table, struct ovn_lflow *lflow)
     free(lflow);
 }
 
+static struct ovn_lflow *
+ovn_lflow_alloc(struct lflow_table *lflow_table, size_t dp_bitmap_len,
+                enum ovn_stage stage, uint16_t priority,
+                const char *match, const char *actions,
+                const char *io_port, const char *ctrl_meter,
+                const struct ovsdb_idl_row *stage_hint,
+                const char *where)
+{
+    struct string_pool_cache *strings = lflow_table_strings_cache(lflow_table);
+    struct ovn_lflow *lflow = xzalloc(sizeof *lflow);
+
+    /* While adding new logical flows we're not setting single datapath, but
+     * collecting a group.  'od' will be updated later for all flows with only
+     * one datapath in a group, so it could be hashed correctly. */
+    ovn_lflow_init(lflow, NULL, dp_bitmap_len, stage, priority,
+                   string_pool_cache_intern(strings, match),
+                   string_pool_cache_intern(strings, actions),
+                   string_pool_cache_intern_nullable(strings, io_port),
+                   string_pool_cache_intern_nullable(strings, ctrl_meter),
+                   ovn_lflow_hint(stage_hint), where);
+    return lflow;
+}
+
+/* Version of do_ovn_lflow_add() that may run concurrently in multiple
+ * threads.  The new lflow is pushed to its hash bucket with a
+ * compare-and-swap.  If that fails because other threads added lflows to the
+ * same bucket in the meantime, only those new lflows need to be checked for
+ * a duplicate before retrying. */
+static struct ovn_lflow *
+do_ovn_lflow_add_concurrent(struct lflow_table *lflow_table,
+                            size_t dp_bitmap_len, uint32_t hash,
+                            enum ovn_stage stage, uint16_t priority,
+                            const char *match, const char *actions,
+                            const char *io_port, const char *ctrl_meter,
+                            const struct ovsdb_idl_row *stage_hint,
+                            const char *where)
+{
+    struct hmap *entries = &lflow_table->entries;
+    struct hmap_node *head = hmap_bucket_head_concurrent(entries, hash);
+    struct ovn_lflow *lflow = NULL;
+
+    lflow = ovn_lflow_find_in_bucket(head, NULL, stage, priority, match,
+                                     actions, ctrl_meter, false, hash);
+    if (lflow) {
+        return lflow;
+    }
+
+    struct ovn_lflow *new_lflow =
+        ovn_lflow_alloc(lflow_table, dp_bitmap_len, stage, priority, match,
+                        actions, io_port, ctrl_meter, stage_hint, where);
+
+    while (!hmap_insert_concurrent(entries, &new_lflow->hmap_node, hash,
+                                   head)) {
+        struct hmap_node *old_head = head;
+
+        head = hmap_bucket_head_concurrent(entries, hash);
+        lflow = ovn_lflow_find_in_bucket(head, old_head, stage, priority,
+                                         new_lflow->match, new_lflow->actions,
+                                         new_lflow->ctrl_meter, true, hash);
+        if (lflow) {
+            /* Another thread added the same lflow first. */
+            ovn_lflow_free(lflow_table, new_lflow);
+            return lflow;
+        }
+    }
+
+    return new_lflow;
+}
+
 static struct ovn_lflow *
 do_ovn_lflow_add(struct lflow_table *lflow_table, size_t dp_bitmap_len,
                  uint32_t hash, enum ovn_stage stage, uint16_t priority,
@@ -961,37 +1298,28 @@ do_ovn_lflow_add(struct lflow_table *lflow_table, size_t dp_bitmap_len,
                  const char *io_port, const char *ctrl_meter,
                  const struct ovsdb_idl_row *stage_hint,
                  const char *where)
-    OVS_REQUIRES(fake_hash_mutex)
 {
-    struct ovn_lflow *old_lflow;
     struct ovn_lflow *lflow;
 
     ovs_assert(dp_bitmap_len);
 
-    old_lflow = ovn_lflow_find(&lflow_table->entries, stage,
-                               priority, match, actions, ctrl_meter, hash);
-    if (old_lflow) {
-        return old_lflow;
+    if (parallelization_state == STATE_USE_PARALLELIZATION) {
+        return do_ovn_lflow_add_concurrent(lflow_table, dp_bitmap_len, hash,
+                                           stage, priority, match, actions,
+                                           io_port, ctrl_meter, stage_hint,
+                                           where);
     }
 
-    lflow = xzalloc(sizeof *lflow);
-    /* While adding new logical flows we're not setting single datapath, but
-     * collecting a group.  'od' will be updated later for all flows with only
-     * one datapath in a group, so it could be hashed correctly. */
-    ovn_lflow_init(lflow, NULL, dp_bitmap_len, stage, priority,
-                   xstrdup(match), xstrdup(actions),
-                   io_port ? xstrdup(io_port) : NULL,
-                   nullable_xstrdup(ctrl_meter),
-                   ovn_lflow_hint(stage_hint), where);
-
-    if (parallelization_state != STATE_USE_PARALLELIZATION) {
-        hmap_insert(&lflow_table->entries, &lflow->hmap_node, hash);
-    } else {
-        hmap_insert_fast(&lflow_table->entries, &lflow->hmap_node,
-                         hash);
-        thread_lflow_counter++;
+    lflow = ovn_lflow_find(lflow_table, stage, priority, match, actions,
+                           ctrl_meter, hash);
+    if (lflow) {
+        return lflow;
     }
 
+    lflow = ovn_lflow_alloc(lflow_table, dp_bitmap_len, stage, priority,
+                            match, actions, io_port, ctrl_meter, stage_hint,
+                            where);
+    hmap_insert(&lflow_table->entries, &lflow->hmap_node, hash);
     return lflow;
 }
 
@@ -1009,29 +1337,25 @@ sync_lflow_to_sb(struct ovn_lflow *lflow,
     struct ovn_dp_group *pre_sync_dpg = lflow->dpg;
     struct ovn_datapath **datapaths_array;
     struct hmap *dp_groups;
-    size_t n_datapaths;
     bool is_switch;
 
     if (ovn_stage_to_datapath_type(lflow->stage) == DP_SWITCH) {
-        n_datapaths = ods_size(ls_datapaths);
         datapaths_array = ls_datapaths->array;
         dp_groups = &lflow_table->ls_dp_groups;
         is_switch = true;
     } else {
-        n_datapaths = ods_size(lr_datapaths);
         datapaths_array = lr_datapaths->array;
         dp_groups = &lflow_table->lr_dp_groups;
         is_switch = false;
     }
 
-    lflow->n_ods = bitmap_count1(lflow->dpg_bitmap, n_datapaths);
+    lflow->n_ods = sparse_bitmap_count1(&lflow->dpg_bitmap);
     ovs_assert(lflow->n_ods);
 
     if (lflow->n_ods == 1) {
         /* There is only one datapath, so it should be moved out of the
          * group to a single 'od'. */
-        size_t index = bitmap_scan(lflow->dpg_bitmap, true, 0,
-                                    n_datapaths);
+        size_t index = sparse_bitmap_scan(&lflow->dpg_bitmap, 0);
 
         lflow->od = datapaths_array[index];
         lflow->dpg = NULL;
@@ -1129,8 +1453,7 @@ sync_lflow_to_sb(struct ovn_lflow *lflow,
     } else {
         sbrec_logical_flow_set_logical_datapath(sbflow, NULL);
         lflow->dpg = ovn_dp_group_get(dp_groups, lflow->n_ods,
-                                      lflow->dpg_bitmap,
-                                      n_datapaths);
+                                      &lflow->dpg_bitmap);
         if (lflow->dpg) {
             /* Update the dpg's sb dp_group. */
             lflow->dpg->dp_group = sbrec_logical_dp_group_table_get_for_uuid(
@@ -1161,8 +1484,8 @@ sync_lflow_to_sb(struct ovn_lflow *lflow,
         } else {
             lflow->dpg = ovn_dp_group_create(
                                 ovnsb_txn, dp_groups, sbrec_dp_group,
-                                lflow->n_ods, lflow->dpg_bitmap,
-                                n_datapaths, is_switch,
+                                lflow->n_ods, &lflow->dpg_bitmap,
+                                is_switch,
                                 ls_datapaths,
                                 lr_datapaths);
         }
@@ -1180,13 +1503,12 @@ sync_lflow_to_sb(struct ovn_lflow *lflow,
 
 static struct ovn_dp_group *
 ovn_dp_group_find(const struct hmap *dp_groups,
-                  const unsigned long *dpg_bitmap, size_t bitmap_len,
-                  uint32_t hash)
+                  const struct sparse_bitmap *dpg_bitmap, uint32_t hash)
 {
     struct ovn_dp_group *dpg;
 
     HMAP_FOR_EACH_WITH_HASH (dpg, node, hash, dp_groups) {
-        if (bitmap_equal(dpg->bitmap, dpg_bitmap, bitmap_len)) {
+        if (sparse_bitmap_equal(&dpg->bitmap, dpg_bitmap)) {
             return dpg;
         }
     }
@@ -1216,7 +1538,7 @@ ovn_dp_group_release(struct hmap *dp_groups, struct ovn_dp_group *dpg)
 static void
 ovn_dp_group_destroy(struct ovn_dp_group *dpg)
 {
-    bitmap_free(dpg->bitmap);
+    sparse_bitmap_destroy(&dpg->bitmap);
     free(dpg);
 }
 
@@ -1224,14 +1546,14 @@ static struct sbrec_logical_dp_group *
 ovn_sb_insert_or_update_logical_dp_group(
                             struct ovsdb_idl_txn *ovnsb_txn,
                             struct sbrec_logical_dp_group *dp_group,
-                            const unsigned long *dpg_bitmap,
+                            const struct sparse_bitmap *dpg_bitmap,
                             const struct ovn_datapaths *datapaths)
 {
     const struct sbrec_datapath_binding **sb;
     size_t n = 0, index;
 
-    sb = xmalloc(bitmap_count1(dpg_bitmap, ods_size(datapaths)) * sizeof *sb);
-    BITMAP_FOR_EACH_1 (index, ods_size(datapaths), dpg_bitmap) {
+    sb = xmalloc(sparse_bitmap_count1(dpg_bitmap) * sizeof *sb);
+    SPARSE_BITMAP_FOR_EACH_1 (index, dpg_bitmap) {
         sb[n++] = datapaths->array[index]->sb;
     }
     if (!dp_group) {
@@ -1246,21 +1568,42 @@ ovn_sb_insert_or_update_logical_dp_group(
     return dp_group;
 }
 
+/* Sets the bits of 'mask' in the word 'word_idx' of an lflow dp group
+ * bitmap.  When lflows are built in parallel the same lflow may get
+ * datapaths added by several threads at a time, so use atomic operations. */
+static void
+ovn_dp_group_bitmap_or_word(struct sparse_bitmap *dpg_bitmap,
+                            size_t word_idx, unsigned long mask)
+{
+    if (parallelization_state == STATE_USE_PARALLELIZATION) {
+        sparse_bitmap_or_word_concurrent(dpg_bitmap, word_idx, mask);
+    } else {
+        sparse_bitmap_or_word(dpg_bitmap, word_idx, mask);
+    }
+}
+
 /* Adds an OVN datapath to a datapath group of existing logical flow.
- * Version to use when hash bucket locking is NOT required or the corresponding
- * hash lock is already taken. */
+ * It is safe to call this function for the same 'lflow' from multiple
+ * threads concurrently. */
 static void
 ovn_dp_group_add_with_reference(struct ovn_lflow *lflow_ref,
                                 const struct ovn_datapath *od,
                                 const unsigned long *dp_bitmap,
                                 size_t bitmap_len)
-    OVS_REQUIRES(fake_hash_mutex)
 {
     if (od) {
-        bitmap_set1(lflow_ref->dpg_bitmap, od->index);
+        ovn_dp_group_bitmap_or_word(&lflow_ref->dpg_bitmap,
+                                    od->index / BITMAP_ULONG_BITS,
+                                    bitmap_bit__(od->index));
     }
     if (dp_bitmap) {
-        bitmap_or(lflow_ref->dpg_bitmap, dp_bitmap, bitmap_len);
+        size_t n = bitmap_n_longs(bitmap_len);
+        for (size_t i = 0; i < n; i++) {
+            if (dp_bitmap[i]) {
+                ovn_dp_group_bitmap_or_word(&lflow_ref->dpg_bitmap, i,
+                                            dp_bitmap[i]);
+            }
+        }
     }
 }
 
@@ -1292,9 +1635,7 @@ lflow_ref_sync_lflows__(struct lflow_ref  *lflow_ref,
             n_datapaths = ods_size(lr_datapaths);
         }
 
-        size_t n_ods = bitmap_count1(lflow->dpg_bitmap, n_datapaths);
-
-        if (n_ods) {
+        if (sparse_bitmap_scan(&lflow->dpg_bitmap, 0) < n_datapaths) {
             if (!sync_lflow_to_sb(lflow, ovnsb_txn, lflow_table, ls_datapaths,
                                   lr_datapaths, ovn_internal_version_changed,
                                   sblflow, dpgrp_table)) {
@@ -1318,82 +1659,6 @@ lflow_ref_sync_lflows__(struct lflow_ref  *lflow_ref,
     return true;
 }
 
-/* Used for the datapath reference counting for a given 'struct ovn_lflow'.
- * See the hmap 'dp_refcnts_map in 'struct ovn_lflow'.
- * For a given lflow L(M, A) with match - M and actions - A, it can be
- * referenced by multiple lflow_refs for the same datapath
- * Eg. Two lflow_ref's - op->lflow_ref and op->stateful_lflow_ref of a
- * datapath can have a reference to the same lflow L (M, A).  In this it
- * is important to maintain this reference count so that the sync to the
- * SB DB logical_flow is correct. */
-struct dp_refcnt {
-    struct hmap_node key_node;
-
-    size_t dp_index; /* datapath index.  Also used as hmap key. */
-    size_t refcnt;   /* reference counter. */
-};
-
-static struct dp_refcnt *
-dp_refcnt_find(struct hmap *dp_refcnts_map, size_t dp_index)
-{
-    struct dp_refcnt *dp_refcnt;
-    HMAP_FOR_EACH_WITH_HASH (dp_refcnt, key_node, dp_index, dp_refcnts_map) {
-        if (dp_refcnt->dp_index == dp_index) {
-            return dp_refcnt;
-        }
-    }
-
-    return NULL;
-}
-
-static void
-dp_refcnt_use(struct hmap *dp_refcnts_map, size_t dp_index)
-{
-    struct dp_refcnt *dp_refcnt = dp_refcnt_find(dp_refcnts_map, dp_index);
-
-    if (!dp_refcnt) {
-        dp_refcnt = xmalloc(sizeof *dp_refcnt);
-        dp_refcnt->dp_index = dp_index;
-        /* Allocation is happening on the second (!) use. */
-        dp_refcnt->refcnt = 1;
-
-        hmap_insert(dp_refcnts_map, &dp_refcnt->key_node, dp_index);
-    }
-
-    dp_refcnt->refcnt++;
-}
-
-/* Decrements the datapath's refcnt from the 'dp_refcnts_map' if it exists
- * and returns true if the refcnt is 0 or if the dp refcnt doesn't exist. */
-static bool
-dp_refcnt_release(struct hmap *dp_refcnts_map, size_t dp_index)
-{
-    struct dp_refcnt *dp_refcnt = dp_refcnt_find(dp_refcnts_map, dp_index);
-    if (!dp_refcnt) {
-        return true;
-    }
-
-    if (!--dp_refcnt->refcnt) {
-        hmap_remove(dp_refcnts_map, &dp_refcnt->key_node);
-        free(dp_refcnt);
-        return true;
-    }
-
-    return false;
-}
-
-static void
-ovn_lflow_clear_dp_refcnts_map(struct ovn_lflow *lflow)
-{
-    struct dp_refcnt *dp_refcnt;
-
-    HMAP_FOR_EACH_POP (dp_refcnt, key_node, &lflow->dp_refcnts_map) {
-        free(dp_refcnt);
-    }
-
-    hmap_destroy(&lflow->dp_refcnts_map);
-}
-
 static struct lflow_ref_node *
 lflow_ref_node_find(struct hmap *lflow_ref_nodes, struct ovn_lflow *lflow,
                     uint32_t lflow_hash)
@@ -1414,7 +1679,7 @@ lflow_ref_node_destroy(struct lflow_ref_node *lrn)
     hmap_remove(&lrn->lflow_ref->lflow_ref_nodes, &lrn->ref_node);
     ovs_list_remove(&lrn->ref_list_node);
     if (lrn->dpgrp_lflow) {
-        bitmap_free(lrn->dpgrp_bitmap);
+        sparse_bitmap_destroy(&lrn->dpgrp_bitmap);
     }
     free(lrn);
 }
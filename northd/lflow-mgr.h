@@ -18,6 +18,7 @@
 
 #include "include/openvswitch/hmap.h"
 #include "include/openvswitch/uuid.h"
+#include "lib/sparse-bitmap.h"
 
 #include "northd.h"
 
@@ -32,7 +33,6 @@ void lflow_table_init(struct lflow_table *);
 void lflow_table_clear(struct lflow_table *);
 void lflow_table_destroy(struct lflow_table *);
 void lflow_table_expand(struct lflow_table *);
-void lflow_table_set_size(struct lflow_table *, size_t);
 void lflow_table_sync_to_sb(struct lflow_table *,
                             struct ovsdb_idl_txn *ovnsb_txn,
                             const struct ovn_datapaths *ls_datapaths,
@@ -44,6 +44,7 @@ void lflow_table_destroy(struct lflow_table *);
 
 void lflow_hash_lock_init(void);
 void lflow_hash_lock_destroy(void);
+void lflow_sync_update_worker_pool(int n_threads);
 
 /* lflow mgr manages logical flows for a resource (like logical port
  * or datapath). */
@@ -142,7 +143,7 @@ void lflow_table_add_lflow_default_drop(struct lflow_table *,
 struct sbrec_logical_dp_group;
 
 struct ovn_dp_group {
-    unsigned long *bitmap;
+    struct sparse_bitmap bitmap;
     const struct sbrec_logical_dp_group *dp_group;
     struct uuid dpg_uuid;
     struct hmap_node node;
@@ -157,14 +158,14 @@ ovn_dp_groups_init(struct hmap *dp_groups)
 
 void ovn_dp_groups_clear(struct hmap *dp_groups);
 void ovn_dp_groups_destroy(struct hmap *dp_groups);
-struct ovn_dp_group *ovn_dp_group_get(struct hmap *dp_groups, size_t desired_n,
-                                      const unsigned long *desired_bitmap,
-                                      size_t bitmap_len);
+struct ovn_dp_group *ovn_dp_group_get(
+    struct hmap *dp_groups, size_t desired_n,
+    const struct sparse_bitmap *desired_bitmap);
 struct ovn_dp_group *ovn_dp_group_create(
     struct ovsdb_idl_txn *ovnsb_txn, struct hmap *dp_groups,
     struct sbrec_logical_dp_group *sb_group,
-    size_t desired_n, const unsigned long *desired_bitmap,
-    size_t bitmap_len, bool is_switch,
+    size_t desired_n, const struct sparse_bitmap *desired_bitmap,
+    bool is_switch,
     const struct ovn_datapaths *ls_datapaths,
     const struct ovn_datapaths *lr_datapaths);
 
@@ -181,7 +182,7 @@ dec_ovn_dp_group_ref(struct hmap *dp_groups, struct ovn_dp_group *dpg)
 
     if (!dpg->refcnt) {
         hmap_remove(dp_groups, &dpg->node);
-        free(dpg->bitmap);
+        sparse_bitmap_destroy(&dpg->bitmap);
         free(dpg);
     }
 }
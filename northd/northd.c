@@ -51,6 +51,7 @@
 #include "en-lr-stateful.h"
 #include "en-ls-stateful.h"
 #include "lib/ovn-parallel-hmap.h"
+#include "lib/inc-proc-eng.h"
 #include "ovn/actions.h"
 #include "ovn/features.h"
 #include "ovn/logical-fields.h"
@@ -438,6 +439,9 @@ ovn_datapath_create(struct hmap *datapaths, const struct uuid *key,
     od->lr_group = NULL;
     hmap_init(&od->ports);
     sset_init(&od->router_ips);
+    if (nbr) {
+        od->route_lflow_ref = lflow_ref_create();
+    }
     return od;
 }
 
@@ -467,6 +471,9 @@ ovn_datapath_destroy(struct hmap *datapaths, struct ovn_datapath *od)
         destroy_mcast_info_for_datapath(od);
         destroy_ports_for_datapath(od);
         sset_destroy(&od->router_ips);
+        if (od->nbr) {
+            lflow_ref_destroy(od->route_lflow_ref);
+        }
         free(od);
     }
 }
@@ -858,6 +865,7 @@ join_datapaths(const struct nbrec_logical_switch_table *nbrec_ls_table,
         if (od) {
             if (!od->nbs) {
                 od->nbr = nbr;
+                od->route_lflow_ref = lflow_ref_create();
                 ovs_list_remove(&od->list);
                 ovs_list_push_back(both, &od->list);
                 ovn_datapath_update_external_ids(od);
@@ -3270,22 +3278,22 @@ cleanup_sb_ha_chassis_groups(
     }
 }
 
+static bool
+fdb_entry_is_stale(const struct sbrec_fdb *fdb_e, struct hmap *ls_datapaths)
+{
+    struct ovn_datapath *od
+        = ovn_datapath_find_by_key(ls_datapaths, fdb_e->dp_key);
+
+    return !od || !ovn_tnlid_present(&od->port_tnlids, fdb_e->port_key);
+}
+
 static void
 cleanup_stale_fdb_entries(const struct sbrec_fdb_table *sbrec_fdb_table,
                           struct hmap *ls_datapaths)
 {
     const struct sbrec_fdb *fdb_e;
     SBREC_FDB_TABLE_FOR_EACH_SAFE (fdb_e, sbrec_fdb_table) {
-        bool delete = true;
-        struct ovn_datapath *od
-            = ovn_datapath_find_by_key(ls_datapaths, fdb_e->dp_key);
-        if (od) {
-            if (ovn_tnlid_present(&od->port_tnlids, fdb_e->port_key)) {
-                delete = false;
-            }
-        }
-
-        if (delete) {
+        if (fdb_entry_is_stale(fdb_e, ls_datapaths)) {
             sbrec_fdb_delete(fdb_e);
         }
     }
@@ -3877,14 +3885,18 @@ sync_pb_for_lsp(struct ovn_port *op,
             nats[n_nats - 1] = ds_steal_cstr(&garp_info);
             ds_destroy(&garp_info);
         }
+        engine_txn_lock();
         sbrec_port_binding_set_nat_addresses(op->sb,
                                                 (const char **) nats, n_nats);
+        engine_txn_unlock();
         for (size_t i = 0; i < n_nats; i++) {
             free(nats[i]);
         }
         free(nats);
     } else {
+        engine_txn_lock();
         sbrec_port_binding_set_nat_addresses(op->sb, NULL, 0);
+        engine_txn_unlock();
     }
 }
 
@@ -3947,7 +3959,9 @@ sync_pb_for_lrp(struct ovn_port *op,
         smap_add(&new, "ipv6_ra_pd_list", ipv6_pd_list);
     }
 
+    engine_txn_lock();
     sbrec_port_binding_set_options(op->sb, &new);
+    engine_txn_unlock();
     smap_destroy(&new);
 }
 
@@ -4233,6 +4247,7 @@ destroy_northd_data_tracked_changes(struct northd_data *nd)
     destroy_tracked_ovn_ports(&trk_changes->trk_lsps);
     destroy_tracked_lbs(&trk_changes->trk_lbs);
     hmapx_clear(&trk_changes->trk_nat_lrs);
+    hmapx_clear(&trk_changes->trk_route_lrs);
     hmapx_clear(&trk_changes->ls_with_changed_lbs);
     hmapx_clear(&trk_changes->ls_with_changed_acls);
     trk_changes->type = NORTHD_TRACKED_NONE;
@@ -4249,6 +4264,7 @@ init_northd_tracked_data(struct northd_data *nd)
     hmapx_init(&trk_data->trk_lbs.crupdated);
     hmapx_init(&trk_data->trk_lbs.deleted);
     hmapx_init(&trk_data->trk_nat_lrs);
+    hmapx_init(&trk_data->trk_route_lrs);
     hmapx_init(&trk_data->ls_with_changed_lbs);
     hmapx_init(&trk_data->ls_with_changed_acls);
 }
@@ -4264,6 +4280,7 @@ destroy_northd_tracked_data(struct northd_data *nd)
     hmapx_destroy(&trk_data->trk_lbs.crupdated);
     hmapx_destroy(&trk_data->trk_lbs.deleted);
     hmapx_destroy(&trk_data->trk_nat_lrs);
+    hmapx_destroy(&trk_data->trk_route_lrs);
     hmapx_destroy(&trk_data->ls_with_changed_lbs);
     hmapx_destroy(&trk_data->ls_with_changed_acls);
 }
@@ -4751,7 +4768,9 @@ lr_changes_can_be_handled(const struct nbrec_logical_router *lr)
         if (nbrec_logical_router_is_updated(lr, col)) {
             if (col == NBREC_LOGICAL_ROUTER_COL_LOAD_BALANCER
                 || col == NBREC_LOGICAL_ROUTER_COL_LOAD_BALANCER_GROUP
-                || col == NBREC_LOGICAL_ROUTER_COL_NAT) {
+                || col == NBREC_LOGICAL_ROUTER_COL_NAT
+                || col == NBREC_LOGICAL_ROUTER_COL_POLICIES
+                || col == NBREC_LOGICAL_ROUTER_COL_STATIC_ROUTES) {
                 continue;
             }
             return false;
@@ -4770,19 +4789,34 @@ lr_changes_can_be_handled(const struct nbrec_logical_router *lr)
                                 OVSDB_IDL_CHANGE_MODIFY) > 0) {
         return false;
     }
-    for (size_t i = 0; i < lr->n_policies; i++) {
-        if (nbrec_logical_router_policy_row_get_seqno(lr->policies[i],
+    return true;
+}
+
+/* Returns true if the static routes or the routing policies of the logical
+ * router 'nbr' have changed. */
+static bool
+is_lr_routes_changed(const struct nbrec_logical_router *nbr)
+{
+    if (nbrec_logical_router_is_updated(nbr,
+                                        NBREC_LOGICAL_ROUTER_COL_POLICIES)
+        || nbrec_logical_router_is_updated(
+               nbr, NBREC_LOGICAL_ROUTER_COL_STATIC_ROUTES)) {
+        return true;
+    }
+
+    for (size_t i = 0; i < nbr->n_policies; i++) {
+        if (nbrec_logical_router_policy_row_get_seqno(nbr->policies[i],
                                 OVSDB_IDL_CHANGE_MODIFY) > 0) {
-            return false;
+            return true;
         }
     }
-    for (size_t i = 0; i < lr->n_static_routes; i++) {
+    for (size_t i = 0; i < nbr->n_static_routes; i++) {
         if (nbrec_logical_router_static_route_row_get_seqno(
-            lr->static_routes[i], OVSDB_IDL_CHANGE_MODIFY) > 0) {
-            return false;
+            nbr->static_routes[i], OVSDB_IDL_CHANGE_MODIFY) > 0) {
+            return true;
         }
     }
-    return true;
+    return false;
 }
 
 static bool
@@ -4827,31 +4861,44 @@ northd_handle_lr_changes(const struct northd_input *ni,
         }
 
         /* Presently only able to handle load balancer,
-         * load balancer group changes and NAT changes. */
+         * load balancer group, NAT, static route and routing policy
+         * changes. */
         if (!lr_changes_can_be_handled(changed_lr)) {
             goto fail;
         }
 
-        if (is_lr_nats_changed(changed_lr)) {
-            struct ovn_datapath *od = ovn_datapath_find_(
-                                    &nd->lr_datapaths.datapaths,
-                                    &changed_lr->header_.uuid);
+        bool nats_changed = is_lr_nats_changed(changed_lr);
+        bool routes_changed = is_lr_routes_changed(changed_lr);
+        if (!nats_changed && !routes_changed) {
+            continue;
+        }
 
-            if (!od) {
-                static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 1);
-                VLOG_WARN_RL(&rl, "Internal error: a tracked updated LR "
-                            "doesn't exist in lr_datapaths: "UUID_FMT,
-                            UUID_ARGS(&changed_lr->header_.uuid));
-                goto fail;
-            }
+        struct ovn_datapath *od = ovn_datapath_find_(
+                                &nd->lr_datapaths.datapaths,
+                                &changed_lr->header_.uuid);
 
+        if (!od) {
+            static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 1);
+            VLOG_WARN_RL(&rl, "Internal error: a tracked updated LR "
+                        "doesn't exist in lr_datapaths: "UUID_FMT,
+                        UUID_ARGS(&changed_lr->header_.uuid));
+            goto fail;
+        }
+
+        if (nats_changed) {
             hmapx_add(&nd->trk_data.trk_nat_lrs, od);
         }
+        if (routes_changed) {
+            hmapx_add(&nd->trk_data.trk_route_lrs, od);
+        }
     }
 
     if (!hmapx_is_empty(&nd->trk_data.trk_nat_lrs)) {
         nd->trk_data.type |= NORTHD_TRACKED_LR_NATS;
     }
+    if (!hmapx_is_empty(&nd->trk_data.trk_route_lrs)) {
+        nd->trk_data.type |= NORTHD_TRACKED_LR_ROUTES;
+    }
 
     return true;
 fail:
@@ -4859,6 +4906,31 @@ fail:
     return false;
 }
 
+/* Handles the FDB entries learnt by ovn-controller.  Only the datapath and
+ * port of an entry matter to northd, entries that don't belong to an
+ * existing logical switch port are deleted, same as on a full recompute.
+ *
+ * Always returns true, the changes never affect northd data. */
+bool
+northd_handle_sb_fdb_changes(const struct sbrec_fdb_table *sbrec_fdb_table,
+                             struct hmap *ls_datapaths)
+{
+    const struct sbrec_fdb *fdb_e;
+    SBREC_FDB_TABLE_FOR_EACH_TRACKED (fdb_e, sbrec_fdb_table) {
+        if (sbrec_fdb_is_deleted(fdb_e)) {
+            continue;
+        }
+
+        if ((sbrec_fdb_is_new(fdb_e)
+             || sbrec_fdb_is_updated(fdb_e, SBREC_FDB_COL_DP_KEY)
+             || sbrec_fdb_is_updated(fdb_e, SBREC_FDB_COL_PORT_KEY))
+            && fdb_entry_is_stale(fdb_e, ls_datapaths)) {
+            sbrec_fdb_delete(fdb_e);
+        }
+    }
+    return true;
+}
+
 bool
 northd_handle_sb_port_binding_changes(
     const struct sbrec_port_binding_table *sbrec_port_binding_table,
@@ -5549,19 +5621,6 @@ ovn_igmp_group_destroy(struct hmap *igmp_groups,
 
 int parallelization_state = STATE_NULL;
 
-
-/* This thread-local var is used for parallel lflow building when dp-groups is
- * enabled. It maintains the number of lflows inserted by the current thread to
- * the shared lflow hmap in the current iteration. It is needed because the
- * lflow_hash_lock cannot protect current update of the hmap's size (hmap->n)
- * by different threads.
- *
- * When all threads complete the tasks of an iteration, the counters of all the
- * threads are collected to fix the lflow hmap's size (by the function
- * fix_flow_map_size()).
- * */
-thread_local size_t thread_lflow_counter = 0;
-
 static bool
 build_dhcpv4_action(struct ovn_port *op, ovs_be32 offer_ip,
                     struct ds *options_action, struct ds *response_action,
@@ -6711,7 +6770,9 @@ ovn_update_ipv6_options(struct hmap *lr_ports)
 {
     struct ovn_port *op;
     HMAP_FOR_EACH (op, key_node, lr_ports) {
+        engine_txn_lock();
         ovn_update_ipv6_opt_for_op(op);
+        engine_txn_unlock();
     }
 }
 
@@ -15802,6 +15863,76 @@ build_lbnat_lflows_iterate_by_lrp(
                                          actions);
 }
 
+/* The flows of a logical router datapath, of a lr_stateful record and of a
+ * ls_stateful record are built by a few independent tasks each.  The parallel
+ * lflow build hands out every task separately, so that the flows of a single
+ * large router or switch, e.g. a gateway router with many routes, NATs and
+ * load balancers, are built by several threads, see build_lflows_thread().
+ *
+ * A task itself is not split any further, e.g. the flows of all the NAT
+ * entries of a router are built by the same thread, since the flows of a NAT
+ * entry depend on the entries that precede it. */
+enum lrouter_flows_task {
+    LROUTER_FLOWS_DEFAULT,
+    LROUTER_FLOWS_STATIC_ROUTES,
+    LROUTER_FLOWS_POLICIES,
+    LROUTER_FLOWS_N_TASKS,
+};
+
+enum lr_stateful_flows_task {
+    LR_STATEFUL_FLOWS_NAT_DEFRAG_AND_LB,
+    LR_STATEFUL_FLOWS_GW_REDIRECT,
+    LR_STATEFUL_FLOWS_ARP_ND,
+    LR_STATEFUL_FLOWS_N_TASKS,
+};
+
+enum ls_stateful_flows_task {
+    LS_STATEFUL_FLOWS_PRE_ACLS_AND_LB,
+    LS_STATEFUL_FLOWS_ACLS,
+    LS_STATEFUL_FLOWS_N_TASKS,
+};
+
+static void
+build_lr_stateful_flows_task(const struct lr_stateful_record *lr_stateful_rec,
+                             enum lr_stateful_flows_task task,
+                             const struct ovn_datapaths *lr_datapaths,
+                             struct lflow_table *lflows,
+                             const struct hmap *ls_ports,
+                             const struct hmap *lr_ports,
+                             struct ds *match,
+                             struct ds *actions,
+                             const struct shash *meter_groups,
+                             const struct chassis_features *features)
+{
+    const struct ovn_datapath *od =
+        ovn_datapaths_find_by_index(lr_datapaths, lr_stateful_rec->lr_index);
+    ovs_assert(od->nbr);
+    ovs_assert(uuid_equals(&od->nbr->header_.uuid,
+                           &lr_stateful_rec->nbr_uuid));
+
+    switch (task) {
+    case LR_STATEFUL_FLOWS_NAT_DEFRAG_AND_LB:
+        build_lrouter_nat_defrag_and_lb(lr_stateful_rec, od, lflows, ls_ports,
+                                        lr_ports, match, actions, meter_groups,
+                                        features, lr_stateful_rec->lflow_ref);
+        break;
+    case LR_STATEFUL_FLOWS_GW_REDIRECT:
+        build_lr_gateway_redirect_flows_for_nats(od,
+                                                 lr_stateful_rec->lrnat_rec,
+                                                 lflows, match, actions,
+                                                 lr_stateful_rec->lflow_ref);
+        break;
+    case LR_STATEFUL_FLOWS_ARP_ND:
+        build_lrouter_arp_nd_for_datapath(od, lr_stateful_rec->lrnat_rec,
+                                          lflows, meter_groups,
+                                          lr_stateful_rec->lflow_ref);
+        break;
+    case LR_STATEFUL_FLOWS_N_TASKS:
+    default:
+        OVS_NOT_REACHED();
+    }
+}
+
 static void
 build_lr_stateful_flows(const struct lr_stateful_record *lr_stateful_rec,
                         const struct ovn_datapaths *lr_datapaths,
@@ -15813,20 +15944,41 @@ build_lr_stateful_flows(const struct lr_stateful_record *lr_stateful_rec,
                         const struct shash *meter_groups,
                         const struct chassis_features *features)
 {
-    const struct ovn_datapath *od =
-        ovn_datapaths_find_by_index(lr_datapaths, lr_stateful_rec->lr_index);
-    ovs_assert(od->nbr);
-    ovs_assert(uuid_equals(&od->nbr->header_.uuid,
-                           &lr_stateful_rec->nbr_uuid));
-    build_lrouter_nat_defrag_and_lb(lr_stateful_rec, od, lflows, ls_ports,
-                                    lr_ports, match, actions, meter_groups,
-                                    features, lr_stateful_rec->lflow_ref);
-    build_lr_gateway_redirect_flows_for_nats(od, lr_stateful_rec->lrnat_rec,
-                                             lflows, match, actions,
-                                             lr_stateful_rec->lflow_ref);
-    build_lrouter_arp_nd_for_datapath(od, lr_stateful_rec->lrnat_rec,
-                                      lflows, meter_groups,
-                                      lr_stateful_rec->lflow_ref);
+    for (size_t task = 0; task < LR_STATEFUL_FLOWS_N_TASKS; task++) {
+        build_lr_stateful_flows_task(lr_stateful_rec, task, lr_datapaths,
+                                     lflows, ls_ports, lr_ports, match,
+                                     actions, meter_groups, features);
+    }
+}
+
+static void
+build_ls_stateful_flows_task(const struct ls_stateful_record *ls_stateful_rec,
+                             enum ls_stateful_flows_task task,
+                             const struct ovn_datapath *od,
+                             const struct ls_port_group_table *ls_pgs,
+                             const struct chassis_features *features,
+                             const struct shash *meter_groups,
+                             struct lflow_table *lflows)
+{
+    switch (task) {
+    case LS_STATEFUL_FLOWS_PRE_ACLS_AND_LB:
+        build_ls_stateful_rec_pre_acls(ls_stateful_rec, od, ls_pgs, lflows,
+                                       ls_stateful_rec->lflow_ref);
+        build_ls_stateful_rec_pre_lb(ls_stateful_rec, od, lflows,
+                                     ls_stateful_rec->lflow_ref);
+        build_lb_hairpin(ls_stateful_rec, od, lflows,
+                         ls_stateful_rec->lflow_ref);
+        break;
+    case LS_STATEFUL_FLOWS_ACLS:
+        build_acl_hints(ls_stateful_rec, od, features, lflows,
+                        ls_stateful_rec->lflow_ref);
+        build_acls(ls_stateful_rec, od, features, lflows, ls_pgs,
+                   meter_groups, ls_stateful_rec->lflow_ref);
+        break;
+    case LS_STATEFUL_FLOWS_N_TASKS:
+    default:
+        OVS_NOT_REACHED();
+    }
 }
 
 static void
@@ -15837,16 +15989,28 @@ build_ls_stateful_flows(const struct ls_stateful_record *ls_stateful_rec,
                         const struct shash *meter_groups,
                         struct lflow_table *lflows)
 {
-    build_ls_stateful_rec_pre_acls(ls_stateful_rec, od, ls_pgs, lflows,
-                                   ls_stateful_rec->lflow_ref);
-    build_ls_stateful_rec_pre_lb(ls_stateful_rec, od, lflows,
-                                 ls_stateful_rec->lflow_ref);
-    build_acl_hints(ls_stateful_rec, od, features, lflows,
-                    ls_stateful_rec->lflow_ref);
-    build_acls(ls_stateful_rec, od, features, lflows, ls_pgs,
-               meter_groups, ls_stateful_rec->lflow_ref);
-    build_lb_hairpin(ls_stateful_rec, od, lflows, ls_stateful_rec->lflow_ref);
-}
+    for (size_t task = 0; task < LS_STATEFUL_FLOWS_N_TASKS; task++) {
+        build_ls_stateful_flows_task(ls_stateful_rec, task, od, ls_pgs,
+                                     features, meter_groups, lflows);
+    }
+}
+
+/* Phases of the parallel lflow build.  Each phase iterates over the hash
+ * buckets of one of the input tables, the buckets are handed out to the
+ * threads through a work stealing task queue per phase.  For the logical
+ * router datapaths and the stateful records, the queue hands out every
+ * (bucket, task) pair separately, see build_lflows_thread(). */
+enum lflows_build_phase {
+    LFLOWS_BUILD_LS_DATAPATHS,
+    LFLOWS_BUILD_LR_DATAPATHS,
+    LFLOWS_BUILD_LS_PORTS,
+    LFLOWS_BUILD_LR_PORTS,
+    LFLOWS_BUILD_LB_DPS,
+    LFLOWS_BUILD_LR_STATEFUL,
+    LFLOWS_BUILD_LS_STATEFUL,
+    LFLOWS_BUILD_IGMP_GROUPS,
+    LFLOWS_BUILD_N_PHASES,
+};
 
 struct lswitch_flow_build_info {
     const struct ovn_datapaths *ls_datapaths;
@@ -15866,8 +16030,10 @@ struct lswitch_flow_build_info {
     char *svc_check_match;
     struct ds match;
     struct ds actions;
-    size_t thread_lflow_counter;
     const char *svc_monitor_mac;
+
+    /* Shared by all the threads, indexed by 'enum lflows_build_phase'. */
+    struct worker_task_queue *tasks;
 };
 
 /* Helper function to combine all lflow generation which is iterated by
@@ -15898,28 +16064,69 @@ build_lswitch_and_lrouter_iterate_by_ls(struct ovn_datapath *od,
     build_lswitch_lflows_l2_unknown(od, lsi->lflows, NULL);
 }
 
-/* Helper function to combine all lflow generation which is iterated by
- * logical router datapath.
- */
+/* Builds the logical flows of the logical router 'od' that depend on its
+ * static routes and routing policies, and references them in
+ * 'od->route_lflow_ref'. */
 static void
-build_lswitch_and_lrouter_iterate_by_lr(struct ovn_datapath *od,
-                                        struct lswitch_flow_build_info *lsi)
+build_lr_route_flows(struct ovn_datapath *od,
+                     const struct chassis_features *features,
+                     struct lflow_table *lflows,
+                     const struct hmap *lr_ports,
+                     const struct hmap *bfd_connections,
+                     struct ds *match, struct ds *actions,
+                     const struct shash *meter_groups)
+{
+    build_static_route_flows_for_lrouter(od, features, lflows, lr_ports,
+                                         bfd_connections,
+                                         od->route_lflow_ref);
+    build_ingress_policy_flows_for_lrouter(od, lflows, lr_ports,
+                                           bfd_connections,
+                                           od->route_lflow_ref);
+    build_arp_request_flows_for_lrouter(od, lflows, match, actions,
+                                        meter_groups, od->route_lflow_ref);
+}
+
+/* Builds the flows of the logical router datapath 'od' for 'task'. */
+static void
+build_lrouter_flows_task(struct ovn_datapath *od,
+                         enum lrouter_flows_task task,
+                         struct lswitch_flow_build_info *lsi)
 {
     ovs_assert(od->nbr);
+
+    switch (task) {
+    case LROUTER_FLOWS_DEFAULT:
+        break;
+    case LROUTER_FLOWS_STATIC_ROUTES:
+        build_static_route_flows_for_lrouter(od, lsi->features, lsi->lflows,
+                                             lsi->lr_ports,
+                                             lsi->bfd_connections,
+                                             od->route_lflow_ref);
+        return;
+    case LROUTER_FLOWS_POLICIES:
+        build_ingress_policy_flows_for_lrouter(od, lsi->lflows,
+                                               lsi->lr_ports,
+                                               lsi->bfd_connections,
+                                               od->route_lflow_ref);
+        return;
+    case LROUTER_FLOWS_N_TASKS:
+    default:
+        OVS_NOT_REACHED();
+    }
+
     build_adm_ctrl_flows_for_lrouter(od, lsi->lflows, NULL);
     build_neigh_learning_flows_for_lrouter(od, lsi->lflows, &lsi->match,
                                            &lsi->actions,
                                            lsi->meter_groups, NULL);
     build_ND_RA_flows_for_lrouter(od, lsi->lflows, NULL);
     build_ip_routing_pre_flows_for_lrouter(od, lsi->lflows, NULL);
-    build_static_route_flows_for_lrouter(od, lsi->features,
-                                         lsi->lflows, lsi->lr_ports,
-                                         lsi->bfd_connections,
-                                         NULL);
+    /* The rest of build_lr_route_flows(), the static routes and policies
+     * are separate tasks. */
+    build_arp_request_flows_for_lrouter(od, lsi->lflows, &lsi->match,
+                                        &lsi->actions, lsi->meter_groups,
+                                        od->route_lflow_ref);
     build_mcast_lookup_flows_for_lrouter(od, lsi->lflows, &lsi->match,
                                          &lsi->actions, NULL);
-    build_ingress_policy_flows_for_lrouter(od, lsi->lflows, lsi->lr_ports,
-                                           lsi->bfd_connections, NULL);
     build_arp_resolve_flows_for_lrouter(od, lsi->lflows, NULL);
     build_check_pkt_len_flows_for_lrouter(od, lsi->lflows, lsi->lr_ports,
                                           &lsi->match, &lsi->actions,
@@ -15927,10 +16134,6 @@ build_lswitch_and_lrouter_iterate_by_lr(struct ovn_datapath *od,
                                           lsi->features);
     build_gateway_redirect_flows_for_lrouter(od, lsi->lflows, &lsi->match,
                                              &lsi->actions, NULL);
-    build_arp_request_flows_for_lrouter(od, lsi->lflows, &lsi->match,
-                                        &lsi->actions,
-                                        lsi->meter_groups,
-                                        NULL);
     build_misc_local_traffic_drop_flows_for_lrouter(od, lsi->lflows, NULL);
 
     build_lr_nat_defrag_and_lb_default_flows(od, lsi->lflows, NULL);
@@ -15942,6 +16145,18 @@ build_lswitch_and_lrouter_iterate_by_lr(struct ovn_datapath *od,
     ovn_lflow_add_default_drop(lsi->lflows, od, S_ROUTER_OUT_DELIVERY, NULL);
 }
 
+/* Helper function to combine all lflow generation which is iterated by
+ * logical router datapath.
+ */
+static void
+build_lswitch_and_lrouter_iterate_by_lr(struct ovn_datapath *od,
+                                        struct lswitch_flow_build_info *lsi)
+{
+    for (size_t task = 0; task < LROUTER_FLOWS_N_TASKS; task++) {
+        build_lrouter_flows_task(od, task, lsi);
+    }
+}
+
 /* Helper function to combine all lflow generation which is iterated by logical
  * switch port.
  */
@@ -16020,27 +16235,24 @@ build_lflows_thread(void *arg)
     struct ovn_lb_datapaths *lb_dps;
     struct ovn_datapath *od;
     struct ovn_port *op;
-    int bnum;
-
-    /* Note:  lflow_ref is not thread safe.  Ensure that
-     *    - op->lflow_ref
-     *    - lb_dps->lflow_ref
-     *    - lr_stateful_rec->lflow_ref
-     *    - ls_stateful_rec->lflow_ref
-     * are not accessed by multiple threads at the same time. */
+    size_t n_buckets;
+    size_t item;
+    size_t bnum;
+
+    /* Note:  The lflow_refs of the stateful records and of the routes of a
+     * router are used by several tasks, that may run in different threads,
+     * see "Thread safety in lflow_ref" in lflow-mgr.c. */
     while (!stop_parallel_processing()) {
         wait_for_work(control);
         lsi = (struct lswitch_flow_build_info *) control->data;
         if (stop_parallel_processing()) {
             return NULL;
         }
-        thread_lflow_counter = 0;
         if (lsi) {
-            /* Iterate over bucket ThreadID, ThreadID+size, ... */
-            for (bnum = control->id;
-                    bnum <= lsi->ls_datapaths->datapaths.mask;
-                    bnum += control->pool->size)
-            {
+            /* Iterate over the hash buckets claimed from the shared task
+             * queues, see build_lswitch_and_lrouter_flows(). */
+            WORKER_TASK_FOR_EACH (bnum, control->id,
+                                  &lsi->tasks[LFLOWS_BUILD_LS_DATAPATHS]) {
                 HMAP_FOR_EACH_IN_PARALLEL (od, key_node, bnum,
                                            &lsi->ls_datapaths->datapaths) {
                     if (stop_parallel_processing()) {
@@ -16049,22 +16261,22 @@ build_lflows_thread(void *arg)
                     build_lswitch_and_lrouter_iterate_by_ls(od, lsi);
                 }
             }
-            for (bnum = control->id;
-                    bnum <= lsi->lr_datapaths->datapaths.mask;
-                    bnum += control->pool->size)
-            {
+            /* The items are (task, bucket) pairs, see
+             * build_lswitch_and_lrouter_flows(). */
+            n_buckets = lsi->lr_datapaths->datapaths.mask + 1;
+            WORKER_TASK_FOR_EACH (item, control->id,
+                                  &lsi->tasks[LFLOWS_BUILD_LR_DATAPATHS]) {
+                bnum = item % n_buckets;
                 HMAP_FOR_EACH_IN_PARALLEL (od, key_node, bnum,
                                            &lsi->lr_datapaths->datapaths) {
                     if (stop_parallel_processing()) {
                         return NULL;
                     }
-                    build_lswitch_and_lrouter_iterate_by_lr(od, lsi);
+                    build_lrouter_flows_task(od, item / n_buckets, lsi);
                 }
             }
-            for (bnum = control->id;
-                    bnum <= lsi->ls_ports->mask;
-                    bnum += control->pool->size)
-            {
+            WORKER_TASK_FOR_EACH (bnum, control->id,
+                                  &lsi->tasks[LFLOWS_BUILD_LS_PORTS]) {
                 HMAP_FOR_EACH_IN_PARALLEL (op, key_node, bnum,
                                            lsi->ls_ports) {
                     if (stop_parallel_processing()) {
@@ -16081,10 +16293,8 @@ build_lflows_thread(void *arg)
                         &lsi->actions, lsi->lflows);
                 }
             }
-            for (bnum = control->id;
-                    bnum <= lsi->lr_ports->mask;
-                    bnum += control->pool->size)
-            {
+            WORKER_TASK_FOR_EACH (bnum, control->id,
+                                  &lsi->tasks[LFLOWS_BUILD_LR_PORTS]) {
                 HMAP_FOR_EACH_IN_PARALLEL (op, key_node, bnum,
                                            lsi->lr_ports) {
                     if (stop_parallel_processing()) {
@@ -16096,10 +16306,8 @@ build_lflows_thread(void *arg)
                         &lsi->match, &lsi->actions, lsi->lflows);
                 }
             }
-            for (bnum = control->id;
-                    bnum <= lsi->lb_dps_map->mask;
-                    bnum += control->pool->size)
-            {
+            WORKER_TASK_FOR_EACH (bnum, control->id,
+                                  &lsi->tasks[LFLOWS_BUILD_LB_DPS]) {
                 HMAP_FOR_EACH_IN_PARALLEL (lb_dps, hmap_node, bnum,
                                            lsi->lb_dps_map) {
                     if (stop_parallel_processing()) {
@@ -16129,28 +16337,30 @@ build_lflows_thread(void *arg)
                                                &lsi->match, &lsi->actions);
                 }
             }
-            for (bnum = control->id;
-                    bnum <= lsi->lr_stateful_table->entries.mask;
-                    bnum += control->pool->size)
-            {
+            n_buckets = lsi->lr_stateful_table->entries.mask + 1;
+            WORKER_TASK_FOR_EACH (item, control->id,
+                                  &lsi->tasks[LFLOWS_BUILD_LR_STATEFUL]) {
+                bnum = item % n_buckets;
                 LR_STATEFUL_TABLE_FOR_EACH_IN_P (lr_stateful_rec, bnum,
                                                  lsi->lr_stateful_table) {
                     if (stop_parallel_processing()) {
                         return NULL;
                     }
-                    build_lr_stateful_flows(lr_stateful_rec, lsi->lr_datapaths,
-                                            lsi->lflows, lsi->ls_ports,
-                                            lsi->lr_ports, &lsi->match,
-                                            &lsi->actions,
-                                            lsi->meter_groups,
-                                            lsi->features);
+                    build_lr_stateful_flows_task(lr_stateful_rec,
+                                                 item / n_buckets,
+                                                 lsi->lr_datapaths,
+                                                 lsi->lflows, lsi->ls_ports,
+                                                 lsi->lr_ports, &lsi->match,
+                                                 &lsi->actions,
+                                                 lsi->meter_groups,
+                                                 lsi->features);
                 }
             }
 
-            for (bnum = control->id;
-                    bnum <= lsi->ls_stateful_table->entries.mask;
-                    bnum += control->pool->size)
-            {
+            n_buckets = lsi->ls_stateful_table->entries.mask + 1;
+            WORKER_TASK_FOR_EACH (item, control->id,
+                                  &lsi->tasks[LFLOWS_BUILD_LS_STATEFUL]) {
+                bnum = item % n_buckets;
                 LS_STATEFUL_TABLE_FOR_EACH_IN_P (ls_stateful_rec, bnum,
                                                  lsi->ls_stateful_table) {
                     od = ovn_datapaths_find_by_index(
@@ -16159,17 +16369,17 @@ build_lflows_thread(void *arg)
                      * same NB Logical switch. */
                     ovs_assert(uuid_equals(&ls_stateful_rec->nbs_uuid,
                                            &od->nbs->header_.uuid));
-                    build_ls_stateful_flows(ls_stateful_rec, od,
-                                            lsi->ls_port_groups,
-                                            lsi->features, lsi->meter_groups,
-                                            lsi->lflows);
+                    build_ls_stateful_flows_task(ls_stateful_rec,
+                                                 item / n_buckets, od,
+                                                 lsi->ls_port_groups,
+                                                 lsi->features,
+                                                 lsi->meter_groups,
+                                                 lsi->lflows);
                 }
             }
 
-            for (bnum = control->id;
-                    bnum <= lsi->igmp_groups->mask;
-                    bnum += control->pool->size)
-            {
+            WORKER_TASK_FOR_EACH (bnum, control->id,
+                                  &lsi->tasks[LFLOWS_BUILD_IGMP_GROUPS]) {
                 HMAP_FOR_EACH_IN_PARALLEL (
                         igmp_group, hmap_node, bnum, lsi->igmp_groups) {
                     if (stop_parallel_processing()) {
@@ -16181,7 +16391,6 @@ build_lflows_thread(void *arg)
                 }
             }
         }
-        lsi->thread_lflow_counter = thread_lflow_counter;
         post_completed_work(control);
     }
     return NULL;
@@ -16198,27 +16407,6 @@ noop_callback(struct worker_pool *pool OVS_UNUSED,
     /* Do nothing */
 }
 
-/* Fixes the hmap size (hmap->n) after parallel building the lflow_table when
- * dp-groups is enabled, because in that case all threads are updating the
- * global lflow hmap. Although the lflow_hash_lock prevents currently inserting
- * to the same hash bucket, the hmap->n is updated currently by all threads and
- * may not be accurate at the end of each iteration. This function collects the
- * thread-local lflow counters maintained by each thread and update the hmap
- * size with the aggregated value. This function must be called immediately
- * after the worker threads complete the tasks in each iteration before any
- * future operations on the lflow map. */
-static void
-fix_flow_table_size(struct lflow_table *lflow_table,
-                  struct lswitch_flow_build_info *lsiv,
-                  size_t n_lsiv)
-{
-    size_t total = 0;
-    for (size_t i = 0; i < n_lsiv; i++) {
-        total += lsiv[i].thread_lflow_counter;
-    }
-    lflow_table_set_size(lflow_table, total);
-}
-
 static void
 build_lswitch_and_lrouter_flows(
     const struct ovn_datapaths *ls_datapaths,
@@ -16241,16 +16429,41 @@ build_lswitch_and_lrouter_flows(
     char *svc_check_match = xasprintf("eth.dst == %s", svc_monitor_mac);
 
     if (parallelization_state == STATE_USE_PARALLELIZATION) {
+        struct worker_task_queue tasks[LFLOWS_BUILD_N_PHASES];
         struct lswitch_flow_build_info *lsiv;
         int index;
 
+        /* The datapath and stateful record tasks are numbered so that
+         * item = task * n_buckets + bucket.  The tasks of a large router then
+         * fall far apart in the queue and are likely handed out to different
+         * threads. */
+        const size_t n_items[LFLOWS_BUILD_N_PHASES] = {
+            [LFLOWS_BUILD_LS_DATAPATHS] = ls_datapaths->datapaths.mask + 1,
+            [LFLOWS_BUILD_LR_DATAPATHS] =
+                (lr_datapaths->datapaths.mask + 1) * LROUTER_FLOWS_N_TASKS,
+            [LFLOWS_BUILD_LS_PORTS] = ls_ports->mask + 1,
+            [LFLOWS_BUILD_LR_PORTS] = lr_ports->mask + 1,
+            [LFLOWS_BUILD_LB_DPS] = lb_dps_map->mask + 1,
+            [LFLOWS_BUILD_LR_STATEFUL] =
+                (lr_stateful_table->entries.mask + 1)
+                * LR_STATEFUL_FLOWS_N_TASKS,
+            [LFLOWS_BUILD_LS_STATEFUL] =
+                (ls_stateful_table->entries.mask + 1)
+                * LS_STATEFUL_FLOWS_N_TASKS,
+            [LFLOWS_BUILD_IGMP_GROUPS] = igmp_groups->mask + 1,
+        };
+        for (index = 0; index < LFLOWS_BUILD_N_PHASES; index++) {
+            worker_task_queue_init(&tasks[index], n_items[index],
+                                   build_lflows_pool->size, 0);
+        }
+
         lsiv = xcalloc(sizeof(*lsiv), build_lflows_pool->size);
 
         /* Set up "work chunks" for each thread to work on. */
 
         for (index = 0; index < build_lflows_pool->size; index++) {
-            /* dp_groups are in use so we lock a shared lflows hash
-             * on a per-bucket level.
+            /* All the threads insert to the shared lflows hash, see
+             * do_ovn_lflow_add_concurrent().
              */
             lsiv[index].lflows = lflows;
             lsiv[index].ls_datapaths = ls_datapaths;
@@ -16267,8 +16480,8 @@ build_lswitch_and_lrouter_flows(
             lsiv[index].bfd_connections = bfd_connections;
             lsiv[index].features = features;
             lsiv[index].svc_check_match = svc_check_match;
-            lsiv[index].thread_lflow_counter = 0;
             lsiv[index].svc_monitor_mac = svc_monitor_mac;
+            lsiv[index].tasks = tasks;
             ds_init(&lsiv[index].match);
             ds_init(&lsiv[index].actions);
 
@@ -16277,13 +16490,15 @@ build_lswitch_and_lrouter_flows(
 
         /* Run thread pool. */
         run_pool_callback(build_lflows_pool, NULL, NULL, noop_callback);
-        fix_flow_table_size(lflows, lsiv, build_lflows_pool->size);
 
         for (index = 0; index < build_lflows_pool->size; index++) {
             ds_destroy(&lsiv[index].match);
             ds_destroy(&lsiv[index].actions);
         }
         free(lsiv);
+        for (index = 0; index < LFLOWS_BUILD_N_PHASES; index++) {
+            worker_task_queue_destroy(&tasks[index]);
+        }
     } else {
         const struct lr_stateful_record *lr_stateful_rec;
         const struct ls_stateful_record *ls_stateful_rec;
@@ -16416,6 +16631,21 @@ void run_update_worker_pool(int n_threads)
             parallelization_state = STATE_INIT_HASH_SIZES;
         }
     }
+
+    engine_set_n_threads(MAX(n_threads, 1));
+    lflow_sync_update_worker_pool(n_threads);
+}
+
+void
+northd_worker_pool_show_stats(struct ds *ds)
+{
+    worker_pool_format_stats(build_lflows_pool, ds);
+}
+
+void
+northd_worker_pool_clear_stats(void)
+{
+    worker_pool_clear_stats(build_lflows_pool);
 }
 
 static void
@@ -16567,6 +16797,11 @@ lflow_reset_northd_refs(struct lflow_input *lflow_input)
     HMAP_FOR_EACH (lb_dps, hmap_node, lflow_input->lb_datapaths_map) {
         lflow_ref_clear(lb_dps->lflow_ref);
     }
+
+    struct ovn_datapath *od;
+    HMAP_FOR_EACH (od, key_node, &lflow_input->lr_datapaths->datapaths) {
+        lflow_ref_clear(od->route_lflow_ref);
+    }
 }
 
 bool
@@ -16789,6 +17024,86 @@ lflow_handle_northd_lb_changes(struct ovsdb_idl_txn *ovnsb_txn,
     return true;
 }
 
+/* Returns true if the static routes or the routing policies of the logical
+ * router 'od' may depend on BFD sessions.  The BFD connections are only
+ * built on a full recompute of the logical flows. */
+static bool
+lr_routes_use_bfd(const struct ovn_datapath *od,
+                  const struct nbrec_bfd_table *nbrec_bfd_table,
+                  const struct hmap *lr_ports)
+{
+    for (size_t i = 0; i < od->nbr->n_static_routes; i++) {
+        if (od->nbr->static_routes[i]->bfd) {
+            return true;
+        }
+    }
+    for (size_t i = 0; i < od->nbr->n_policies; i++) {
+        if (od->nbr->policies[i]->n_bfd_sessions) {
+            return true;
+        }
+    }
+
+    /* A deleted route may have referenced a BFD session of this router,
+     * whose status needs to be updated. */
+    const struct nbrec_bfd *nb_bt;
+    NBREC_BFD_TABLE_FOR_EACH (nb_bt, nbrec_bfd_table) {
+        const struct ovn_port *op = ovn_port_find(lr_ports,
+                                                  nb_bt->logical_port);
+        if (op && op->od == od) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+lflow_handle_northd_lr_route_changes(struct ovsdb_idl_txn *ovnsb_txn,
+                                     struct hmapx *trk_route_lrs,
+                                     struct lflow_input *lflow_input,
+                                     struct lflow_table *lflows)
+{
+    struct hmap bfd_connections = HMAP_INITIALIZER(&bfd_connections);
+    struct ds actions = DS_EMPTY_INITIALIZER;
+    struct ds match = DS_EMPTY_INITIALIZER;
+    struct hmapx_node *hmapx_node;
+    bool handled = true;
+
+    HMAPX_FOR_EACH (hmapx_node, trk_route_lrs) {
+        struct ovn_datapath *od = hmapx_node->data;
+
+        if (lr_routes_use_bfd(od, lflow_input->nbrec_bfd_table,
+                              lflow_input->lr_ports)) {
+            handled = false;
+            break;
+        }
+
+        /* Unlink old lflows. */
+        lflow_ref_unlink_lflows(od->route_lflow_ref);
+
+        /* Generate new lflows. */
+        build_lr_route_flows(od, lflow_input->features, lflows,
+                             lflow_input->lr_ports, &bfd_connections,
+                             &match, &actions, lflow_input->meter_groups);
+
+        /* Sync the new flows to SB. */
+        handled = lflow_ref_sync_lflows(
+            od->route_lflow_ref, lflows, ovnsb_txn,
+            lflow_input->ls_datapaths, lflow_input->lr_datapaths,
+            lflow_input->ovn_internal_version_changed,
+            lflow_input->sbrec_logical_flow_table,
+            lflow_input->sbrec_logical_dp_group_table);
+        if (!handled) {
+            break;
+        }
+    }
+
+    ds_destroy(&match);
+    ds_destroy(&actions);
+    hmap_destroy(&bfd_connections);
+
+    return handled;
+}
+
 bool
 lflow_handle_lr_stateful_changes(struct ovsdb_idl_txn *ovnsb_txn,
                                 struct lr_stateful_tracked_data *trk_data,
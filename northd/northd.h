@@ -120,6 +120,7 @@ enum northd_tracked_data_type {
     NORTHD_TRACKED_LR_NATS  = (1 << 2),
     NORTHD_TRACKED_LS_LBS   = (1 << 3),
     NORTHD_TRACKED_LS_ACLS  = (1 << 4),
+    NORTHD_TRACKED_LR_ROUTES = (1 << 5),
 };
 
 /* Track what's changed in the northd engine node.
@@ -135,6 +136,11 @@ struct northd_tracked_data {
      * hmapx node is 'struct ovn_datapath *'. */
     struct hmapx trk_nat_lrs;
 
+    /* Tracked logical routers whose static routes or routing policies
+     * have changed.
+     * hmapx node is 'struct ovn_datapath *'. */
+    struct hmapx trk_route_lrs;
+
     /* Tracked logical switches whose load balancers have changed.
      * hmapx node is 'struct ovn_datapath *'. */
     struct hmapx ls_with_changed_lbs;
@@ -199,8 +205,6 @@ enum {
     STATE_USE_PARALLELIZATION /* parallelization is on */
 };
 
-extern thread_local size_t thread_lflow_counter;
-
 /*
  * Multicast snooping and querier per datapath configuration.
  */
@@ -340,6 +344,11 @@ struct ovn_datapath {
     /* Map of ovn_port objects belonging to this datapath.
      * This map doesn't include derived ports. */
     struct hmap ports;
+
+    /* Logical flows generated for the static routes and the routing
+     * policies of a logical router datapath.  NULL for logical switch
+     * datapaths. */
+    struct lflow_ref *route_lflow_ref;
 };
 
 const struct ovn_datapath *ovn_datapath_find(const struct hmap *datapaths,
@@ -691,6 +700,10 @@ bool lflow_handle_northd_lb_changes(struct ovsdb_idl_txn *ovnsb_txn,
                                     struct tracked_lbs *,
                                     struct lflow_input *,
                                     struct lflow_table *lflows);
+bool lflow_handle_northd_lr_route_changes(struct ovsdb_idl_txn *ovnsb_txn,
+                                          struct hmapx *trk_route_lrs,
+                                          struct lflow_input *,
+                                          struct lflow_table *lflows);
 bool lflow_handle_lr_stateful_changes(struct ovsdb_idl_txn *,
                                       struct lr_stateful_tracked_data *,
                                       struct lflow_input *,
@@ -702,6 +715,8 @@ bool lflow_handle_ls_stateful_changes(struct ovsdb_idl_txn *,
 bool northd_handle_sb_port_binding_changes(
     const struct sbrec_port_binding_table *, struct hmap *ls_ports,
     struct hmap *lr_ports);
+bool northd_handle_sb_fdb_changes(const struct sbrec_fdb_table *,
+                                  struct hmap *ls_datapaths);
 
 struct tracked_lb_data;
 bool northd_handle_lb_data_changes(struct tracked_lb_data *,
@@ -719,6 +734,8 @@ void build_bfd_table(struct ovsdb_idl_txn *ovnsb_txn,
 void bfd_cleanup_connections(const struct nbrec_bfd_table *,
                              struct hmap *bfd_map);
 void run_update_worker_pool(int n_threads);
+void northd_worker_pool_show_stats(struct ds *);
+void northd_worker_pool_clear_stats(void);
 
 const struct ovn_datapath *northd_get_datapath_for_port(
     const struct hmap *ls_ports, const char *port_name);
@@ -754,6 +771,13 @@ northd_has_lr_nats_in_tracked_data(struct northd_tracked_data *trk_nd_changes)
     return trk_nd_changes->type & NORTHD_TRACKED_LR_NATS;
 }
 
+static inline bool
+northd_has_lr_routes_in_tracked_data(
+    struct northd_tracked_data *trk_nd_changes)
+{
+    return trk_nd_changes->type & NORTHD_TRACKED_LR_ROUTES;
+}
+
 static inline bool
 northd_has_ls_lbs_in_tracked_data(struct northd_tracked_data *trk_nd_changes)
 {
@@ -23,6 +23,7 @@
 #include "daemon.h"
 #include "fatal-signal.h"
 #include "inc-proc-northd.h"
+#include "lib/inc-proc-eng.h"
 #include "lib/ip-mcast-index.h"
 #include "lib/mcast-group-index.h"
 #include "lib/memory-trim.h"
@@ -35,6 +36,7 @@
 #include "lib/ovn-sb-idl.h"
 #include "lib/ovs-rcu.h"
 #include "openvswitch/poll-loop.h"
+#include "ovs-replay.h"
 #include "simap.h"
 #include "stopwatch.h"
 #include "lib/stopwatch-names.h"
@@ -54,6 +56,8 @@ static unixctl_cb_func ovn_northd_status;
 static unixctl_cb_func cluster_state_reset_cmd;
 static unixctl_cb_func ovn_northd_set_thread_count_cmd;
 static unixctl_cb_func ovn_northd_get_thread_count_cmd;
+static unixctl_cb_func ovn_northd_show_thread_stats_cmd;
+static unixctl_cb_func ovn_northd_clear_thread_stats_cmd;
 
 struct northd_state {
     bool had_lock;
@@ -551,6 +555,9 @@ Options:\n\
   --dry-run                 start in paused state (do not commit db changes)\n\
   --n-threads=N             specify number of threads\n\
   --unixctl=SOCKET          override default control socket name\n\
+  --record[=DIR]            record the database and control connections\n\
+                            into DIR, to replay them later\n\
+  --replay[=DIR]            replay the connections recorded in DIR\n\
   -h, --help                display this help message\n\
   -o, --options             list available options\n\
   -V, --version             display version information\n\
@@ -568,6 +575,7 @@ parse_options(int argc OVS_UNUSED, char *argv[] OVS_UNUSED,
         OVN_DAEMON_OPTION_ENUMS,
         VLOG_OPTION_ENUMS,
         SSL_OPTION_ENUMS,
+        OVS_REPLAY_OPTION_ENUMS,
         OPT_DRY_RUN,
         OPT_N_THREADS,
     };
@@ -583,6 +591,7 @@ parse_options(int argc OVS_UNUSED, char *argv[] OVS_UNUSED,
         OVN_DAEMON_LONG_OPTIONS,
         VLOG_LONG_OPTIONS,
         STREAM_SSL_LONG_OPTIONS,
+        OVS_REPLAY_LONG_OPTIONS,
         {NULL, 0, NULL, 0},
     };
     char *short_options = ovs_cmdl_long_options_to_short_options(long_options);
@@ -598,6 +607,7 @@ parse_options(int argc OVS_UNUSED, char *argv[] OVS_UNUSED,
         switch (c) {
         OVN_DAEMON_OPTION_HANDLERS;
         VLOG_OPTION_HANDLERS;
+        OVS_REPLAY_OPTION_HANDLERS;
 
         case 'p':
             ssl_private_key_file = optarg;
@@ -804,6 +814,12 @@ main(int argc, char *argv[])
     unixctl_command_register("parallel-build/get-n-threads", "", 0, 0,
                              ovn_northd_get_thread_count_cmd,
                              NULL);
+    unixctl_command_register("parallel-build/show-stats", "", 0, 0,
+                             ovn_northd_show_thread_stats_cmd,
+                             NULL);
+    unixctl_command_register("parallel-build/clear-stats", "", 0, 0,
+                             ovn_northd_clear_thread_stats_cmd,
+                             NULL);
 
     daemonize_complete();
 
@@ -894,6 +910,10 @@ main(int argc, char *argv[])
     unsigned int ovnnb_cond_seqno = UINT_MAX;
     unsigned int ovnsb_cond_seqno = UINT_MAX;
 
+    /* IDL sequence numbers seen by the last engine run. */
+    unsigned int run_nb_seqno = UINT_MAX;
+    unsigned int run_sb_seqno = UINT_MAX;
+
     run_update_worker_pool(n_threads);
 
     /* Main loop. */
@@ -907,6 +927,7 @@ main(int argc, char *argv[])
 
             ovsdb_idl_get_memory_usage(ovnnb_idl_loop.idl, &usage);
             ovsdb_idl_get_memory_usage(ovnsb_idl_loop.idl, &usage);
+            engine_get_memory_usage(&usage);
             memory_report(&usage);
             simap_destroy(&usage);
         }
@@ -964,11 +985,22 @@ main(int argc, char *argv[])
 
             if (ovsdb_idl_has_lock(ovnsb_idl_loop.idl)) {
                 bool activity = false;
+                eng_ctx.input_changed =
+                    run_nb_seqno != ovsdb_idl_get_seqno(ovnnb_idl_loop.idl)
+                    || run_sb_seqno != ovsdb_idl_get_seqno(ovnsb_idl_loop.idl);
                 if (ovnnb_txn && ovnsb_txn &&
                     inc_proc_northd_can_run(&eng_ctx)) {
                     int64_t loop_start_time = time_wall_msec();
+                    long long int run_start = time_msec();
                     activity = inc_proc_northd_run(ovnnb_txn, ovnsb_txn,
                                                    &eng_ctx);
+                    if (ovs_replay_get_state() == OVS_REPLAY_READ) {
+                        VLOG_INFO("Replayed engine run took %lld ms%s",
+                                  time_msec() - run_start,
+                                  activity ? "" : " (no updates)");
+                    }
+                    run_nb_seqno = ovsdb_idl_get_seqno(ovnnb_idl_loop.idl);
+                    run_sb_seqno = ovsdb_idl_get_seqno(ovnsb_idl_loop.idl);
                     eng_ctx.recompute = false;
                     check_and_add_supported_dhcp_opts_to_sb_db(
                                  ovnsb_txn, ovnsb_idl_loop.idl);
@@ -1055,6 +1087,9 @@ main(int argc, char *argv[])
             eng_ctx.backoff_ms =
                     smap_get_uint(&nb->options, "northd-backoff-interval-ms",
                                   0);
+            eng_ctx.coalesce_ms =
+                    smap_get_uint(&nb->options, "northd-coalesce-interval-ms",
+                                  0);
         }
         set_idl_probe_interval(ovnnb_idl_loop.idl, ovnnb_db, interval);
         set_idl_probe_interval(ovnsb_idl_loop.idl, ovnsb_db, interval);
@@ -1184,3 +1219,25 @@ ovn_northd_get_thread_count_cmd(struct unixctl_conn *conn, int argc OVS_UNUSED,
     unixctl_command_reply(conn, ds_cstr(&s));
     ds_destroy(&s);
 }
+
+static void
+ovn_northd_show_thread_stats_cmd(struct unixctl_conn *conn,
+                                 int argc OVS_UNUSED,
+                                 const char *argv[] OVS_UNUSED,
+                                 void *aux OVS_UNUSED)
+{
+    struct ds s = DS_EMPTY_INITIALIZER;
+    northd_worker_pool_show_stats(&s);
+    unixctl_command_reply(conn, ds_cstr(&s));
+    ds_destroy(&s);
+}
+
+static void
+ovn_northd_clear_thread_stats_cmd(struct unixctl_conn *conn,
+                                  int argc OVS_UNUSED,
+                                  const char *argv[] OVS_UNUSED,
+                                  void *aux OVS_UNUSED)
+{
+    northd_worker_pool_clear_stats();
+    unixctl_command_reply(conn, NULL);
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2024, Red Hat, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include "tests/ovstest.h"
+#include "tests/test-utils.h"
+#include "util.h"
+
+#include "dp-refcnts.h"
+
+static void
+dp_refcnts_print(const struct dp_refcnts *dp_refcnts)
+{
+    const struct dp_refcnt *entries = dp_refcnts->array
+                                      ? dp_refcnts->array
+                                      : dp_refcnts->inline_refcnts;
+
+    printf("%s, n: %"PRIu32":", dp_refcnts->array ? "heap" : "inline",
+           dp_refcnts->n);
+    for (size_t i = 0; i < dp_refcnts->n; i++) {
+        printf(" %"PRIu32"=%"PRIu32, entries[i].dp_index, entries[i].refcnt);
+    }
+    printf("\n");
+}
+
+static void
+test_dp_refcnts_operations(struct ovs_cmdl_context *ctx)
+{
+    struct dp_refcnts dp_refcnts;
+    int shift = 1;
+
+    dp_refcnts_init(&dp_refcnts);
+
+    while (shift < ctx->argc) {
+        const char *op = test_read_value(ctx, shift++, "op");
+        unsigned int dp_index;
+
+        if (!strcmp(op, "compact")) {
+            dp_refcnts_compact(&dp_refcnts);
+            printf("compact\n");
+            continue;
+        } else if (!strcmp(op, "dump")) {
+            dp_refcnts_print(&dp_refcnts);
+            continue;
+        }
+
+        if (!test_read_uint_value(ctx, shift++, "dp_index", &dp_index)) {
+            goto done;
+        }
+        if (!strcmp(op, "use")) {
+            dp_refcnt_use(&dp_refcnts, dp_index);
+            printf("use(%u): %"PRIu32"\n", dp_index,
+                   dp_refcnt_get(&dp_refcnts, dp_index));
+        } else if (!strcmp(op, "release")) {
+            bool ret = dp_refcnt_release(&dp_refcnts, dp_index);
+            printf("release(%u): %s\n", dp_index, ret ? "true" : "false");
+        } else if (!strcmp(op, "get")) {
+            printf("get(%u): %"PRIu32"\n", dp_index,
+                   dp_refcnt_get(&dp_refcnts, dp_index));
+        } else {
+            printf("Unknown operation: %s\n", op);
+            goto done;
+        }
+    }
+    dp_refcnts_print(&dp_refcnts);
+
+done:
+    dp_refcnts_destroy(&dp_refcnts);
+}
+
+/* Uses and releases all the datapaths from 0 to N - 1 'n_iterations' times,
+ * checking that the counters stay sorted and consistent. */
+static void
+test_dp_refcnts_many(struct ovs_cmdl_context *ctx)
+{
+    unsigned int n_dps, n_iterations;
+
+    if (!test_read_uint_value(ctx, 1, "n_dps", &n_dps)
+        || !test_read_uint_value(ctx, 2, "n_iterations", &n_iterations)) {
+        return;
+    }
+
+    struct dp_refcnts dp_refcnts;
+    dp_refcnts_init(&dp_refcnts);
+
+    for (unsigned int i = 0; i < n_iterations; i++) {
+        /* Insert in descending order, so that each counter goes in front. */
+        for (unsigned int dp = n_dps; dp-- > 0;) {
+            dp_refcnt_use(&dp_refcnts, dp);
+        }
+        for (unsigned int dp = 0; dp < n_dps; dp++) {
+            dp_refcnt_use(&dp_refcnts, dp);
+        }
+        ovs_assert(dp_refcnts.n == n_dps);
+        for (unsigned int dp = 0; dp < n_dps; dp++) {
+            ovs_assert(dp_refcnt_get(&dp_refcnts, dp) == 3);
+        }
+
+        for (unsigned int dp = 0; dp < n_dps; dp++) {
+            ovs_assert(!dp_refcnt_release(&dp_refcnts, dp));
+        }
+        dp_refcnts_compact(&dp_refcnts);
+        ovs_assert(dp_refcnts.n == n_dps);
+
+        /* Release the even datapaths, then the odd ones. */
+        for (unsigned int dp = 0; dp < n_dps; dp += 2) {
+            ovs_assert(!dp_refcnt_release(&dp_refcnts, dp));
+            ovs_assert(dp_refcnt_release(&dp_refcnts, dp));
+        }
+        dp_refcnts_compact(&dp_refcnts);
+        ovs_assert(dp_refcnts.n == n_dps / 2);
+        for (unsigned int dp = 1; dp < n_dps; dp += 2) {
+            ovs_assert(!dp_refcnt_release(&dp_refcnts, dp));
+            ovs_assert(dp_refcnt_release(&dp_refcnts, dp));
+        }
+        dp_refcnts_compact(&dp_refcnts);
+        ovs_assert(!dp_refcnts.n);
+        ovs_assert(!dp_refcnts.array);
+    }
+    dp_refcnts_destroy(&dp_refcnts);
+}
+
+static void
+test_dp_refcnts_main(int argc, char *argv[])
+{
+    set_program_name(argv[0]);
+    static const struct ovs_cmdl_command commands[] = {
+        {"operations", NULL, 0, INT_MAX,
+         test_dp_refcnts_operations, OVS_RO},
+        {"many", NULL, 2, 2, test_dp_refcnts_many, OVS_RO},
+        {NULL, NULL, 0, 0, NULL, OVS_RO},
+    };
+    struct ovs_cmdl_context ctx;
+    ctx.argc = argc - 1;
+    ctx.argv = argv + 1;
+    ovs_cmdl_run_command(&ctx, commands);
+}
+
+OVSTEST_REGISTER("test-dp-refcnts", test_dp_refcnts_main);
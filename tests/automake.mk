@@ -41,7 +41,10 @@ TESTSUITE_AT = \
 	tests/ovn-performance.at \
 	tests/ovn-ofctrl-seqno.at \
 	tests/ovn-ipam.at \
+	tests/ovn-dp-refcnts.at \
 	tests/ovn-features.at \
+	tests/ovn-sparse-bitmap.at \
+	tests/ovn-string-pool.at \
 	tests/ovn-lflow-cache.at \
 	tests/ovn-lflow-conj-ids.at \
 	tests/ovn-ipsec.at \
@@ -287,6 +290,9 @@ tests_ovstest_SOURCES = \
 	controller/test-ofctrl-seqno.c \
 	controller/test-vif-plug.c \
 	lib/test-ovn-features.c \
+	lib/test-sparse-bitmap.c \
+	lib/test-string-pool.c \
+	northd/test-dp-refcnts.c \
 	northd/test-ipam.c
 
 tests_ovstest_LDADD = $(OVS_LIBDIR)/daemon.lo \
@@ -304,6 +310,7 @@ tests_ovstest_LDADD = $(OVS_LIBDIR)/daemon.lo \
 	controller/ovsport.$(OBJEXT) \
 	controller/patch.$(OBJEXT) \
 	controller/vif-plug.$(OBJEXT) \
+	northd/dp-refcnts.$(OBJEXT) \
 	northd/ipam.$(OBJEXT)
 
 # Python tests.